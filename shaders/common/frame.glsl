@@ -0,0 +1,21 @@
+// Per-frame values shared by every pass (see FrameUniforms in manager.cpp).
+layout (std140, binding = 0) uniform Frame {
+    mat4 u_projection;
+    mat4 u_inverse_projection;
+    vec2 u_uv_scale; // fraction of each render target covered by the frame
+    vec2 u_render_size; // size of the frame in pixels
+};
+
+// Convert render target texture coordinates to frame coordinates in [0, 1].
+vec2 texture_to_screen(vec2 uv)
+{
+    return uv / u_uv_scale;
+}
+
+// Convert frame coordinates in [0, 1] to render target texture coordinates,
+// clamped to the texels covered by the frame.
+vec2 screen_to_texture(vec2 uv, vec2 texture_size)
+{
+    vec2 half_texel = 0.5 / texture_size;
+    return clamp(uv * u_uv_scale, half_texel, u_uv_scale - half_texel);
+}
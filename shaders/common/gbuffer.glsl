@@ -0,0 +1,33 @@
+// Helpers shared by the passes that write and read the g-buffer.
+
+// Get the sign of each component, treating zero as positive.
+vec2 sign_not_zero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Encode a unit vector as octahedral coordinates in [0, 1].
+vec2 encode_normal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * sign_not_zero(n.xy);
+    return e * 0.5 + 0.5;
+}
+
+// Decode a unit vector from octahedral coordinates in [0, 1].
+vec3 decode_normal(vec2 e)
+{
+    e = e * 2.0 - 1.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy -= sign_not_zero(n.xy) * t;
+    return normalize(n);
+}
+
+// Reconstruct a view-space position from texture coordinates and depth.
+vec3 view_position(vec2 uv, float depth, mat4 inverse_projection)
+{
+    vec4 ndc = vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec4 view = inverse_projection * ndc;
+    return view.xyz / view.w;
+}
@@ -0,0 +1,69 @@
+// Point and spot lights sorted into a froxel grid. The host defines the grid
+// dimensions CLUSTER_X, CLUSTER_Y, CLUSTER_Z and the per-cluster capacity
+// MAX_CLUSTER_LIGHTS (see LightClusters::defines).
+
+// A Light matches the Light struct in lights.hpp. Point lights have a
+// cos_outer below -1 so that every direction is inside their cone.
+struct Light {
+    vec3 position;
+    float range;
+    vec3 color;
+    float cos_outer;
+    vec3 direction;
+    float cos_inner;
+};
+
+layout (std430, binding = 4) buffer ViewLights { Light view_lights[]; };
+layout (std430, binding = 5) buffer ClusterCounts { uint cluster_counts[]; };
+layout (std430, binding = 6) buffer ClusterLights { uint cluster_lights[]; };
+
+const uvec3 cluster_grid = uvec3(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+const float cluster_near = 1.0; // near plane of the projection
+
+// Get the view depth at which a depth slice starts. Slices are spaced
+// exponentially so that clusters stay roughly cubic.
+float slice_depth(float slice, float far)
+{
+    return cluster_near * pow(far / cluster_near, slice / float(CLUSTER_Z));
+}
+
+// Get the cluster containing a point in frame coordinates at some distance
+// from the view.
+uint cluster_index(vec2 uv, float depth, float far)
+{
+    uvec2 tile = uvec2(clamp(uv, 0.0, 0.999999) * vec2(cluster_grid.xy));
+    float slice = log(max(depth, cluster_near) / cluster_near) /
+                  log(far / cluster_near) * float(CLUSTER_Z);
+    uint z = min(uint(slice), cluster_grid.z - 1);
+    return (z * cluster_grid.y + tile.y) * cluster_grid.x + tile.x;
+}
+
+// Get the light a view-space surface receives from a view-space light, with
+// a Blinn-Phong specular term scaled by the surface's specular intensity.
+vec3 shade(
+    Light light,
+    vec3 position,
+    vec3 normal,
+    vec3 diffuse,
+    float specular)
+{
+    vec3 to_light = light.position - position;
+    float distance = length(to_light);
+    if (distance >= light.range) {
+        return vec3(0.0);
+    }
+    vec3 l = to_light / distance;
+
+    // smooth window that reaches zero at the light's range
+    float falloff = 1.0 - pow(distance / light.range, 4.0);
+    float attenuation = falloff * falloff;
+    attenuation *= smoothstep(
+        light.cos_outer,
+        light.cos_inner,
+        dot(-l, light.direction));
+
+    vec3 h = normalize(l + normalize(-position));
+    float lambert = max(dot(normal, l), 0.0);
+    float phong = pow(max(dot(normal, h), 0.0), 32.0) * specular;
+    return light.color * attenuation * (diffuse * lambert + phong);
+}
@@ -0,0 +1,16 @@
+// Tunable ssao parameters (see SsaoUniforms in manager.cpp). Shader variants
+// may compile the counts in as macros, and read everything else from here so
+// that it can change without a rebuild.
+layout (std140, binding = 1) uniform Ssao {
+    float u_radius; // radius of the occlusion in view units
+    float u_bias; // depth bias that avoids self-occlusion
+    float u_intensity; // scale of the occlusion
+    float u_power; // exponent applied to the unoccluded fraction
+    int u_sample_count;
+    int u_noise_size;
+    int u_directions;
+    int u_slices;
+    int u_steps;
+    int u_blur_radius;
+    vec4 u_samples[64]; // hemisphere kernel offsets, length parameters in w
+};
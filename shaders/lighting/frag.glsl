@@ -1,20 +1,62 @@
 #version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "../common/lights.glsl"
+// ENABLE_SSAO and ENABLE_LIGHTS are compile-time constants when defined by
+// the host, and fall back to uniforms otherwise.
+#ifndef ENABLE_SSAO
+uniform bool u_enable_ssao;
+#define ENABLE_SSAO u_enable_ssao
+#endif
+
+#ifndef ENABLE_LIGHTS
+uniform bool u_enable_lights;
+#define ENABLE_LIGHTS u_enable_lights
+#endif
+
 uniform sampler2D u_diffuse_spec;
 uniform sampler2D u_occlusion;
+uniform sampler2D u_normal;
+uniform sampler2D u_depth;
 
-uniform bool u_enable_ssao;
+uniform float u_ambient; // intensity of the ambient light
+uniform float u_cluster_far; // view depth of the last cluster slice
 
 in vec2 v_tex_coords;
+in vec2 v_screen_coords;
 
 out vec4 v_frag_color;
 
 void main()
 {
-    vec3 diffuse_color = texture(u_diffuse_spec, v_tex_coords).rgb;
+    vec4 diffuse_spec = texture(u_diffuse_spec, v_tex_coords);
+    vec3 diffuse_color = diffuse_spec.rgb;
     float occlusion = 1.0;
-    if (u_enable_ssao) {
+    if (ENABLE_SSAO) {
         occlusion = texture(u_occlusion, v_tex_coords).r;
+        occlusion = clamp(1.0 - u_intensity * (1.0 - occlusion), 0.0, 1.0);
+        occlusion = pow(occlusion, u_power);
+    }
+    vec3 color = diffuse_color * occlusion * u_ambient;
+
+    float depth = texture(u_depth, v_tex_coords).r;
+    if (ENABLE_LIGHTS && depth < 1.0) {
+        vec3 position =
+            view_position(v_screen_coords, depth, u_inverse_projection);
+        vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+        uint cluster =
+            cluster_index(v_screen_coords, -position.z, u_cluster_far);
+        uint first = cluster * MAX_CLUSTER_LIGHTS;
+        for (uint i = 0; i < cluster_counts[cluster]; i++) {
+            Light light = view_lights[cluster_lights[first + i]];
+            color += shade(
+                light,
+                position,
+                normal,
+                diffuse_color,
+                diffuse_spec.a);
+        }
     }
-    vec3 ambient = diffuse_color * occlusion;
-    v_frag_color = vec4(ambient, 1.0);
+    v_frag_color = vec4(color, 1.0);
 }
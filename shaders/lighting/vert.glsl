@@ -1,11 +1,14 @@
 #version 460 core
+#include "../common/frame.glsl"
 layout (location = 0) in vec3 b_position;
 layout (location = 1) in vec2 b_tex_coords;
 
-out vec2 v_tex_coords;
+out vec2 v_tex_coords; // render target coordinates
+out vec2 v_screen_coords; // frame coordinates in [0, 1]
 
 void main()
 {
-    v_tex_coords = b_tex_coords;
+    v_tex_coords = b_tex_coords * u_uv_scale;
+    v_screen_coords = b_tex_coords;
     gl_Position = vec4(b_position, 1.0);
 }
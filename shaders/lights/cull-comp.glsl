@@ -0,0 +1,78 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/lights.glsl"
+#define BATCH_SIZE 128
+layout (local_size_x = BATCH_SIZE) in;
+
+uniform uint u_light_count;
+uniform float u_cluster_far;
+
+// view-space lights shared by every cluster of the work group
+shared vec4 batch[BATCH_SIZE];
+
+// Get the view-space point at some distance along the ray through a point
+// in frame coordinates.
+vec3 view_point(vec2 uv, float depth)
+{
+    vec3 ray = view_position(uv, 0.5, u_inverse_projection);
+    return ray * (depth / -ray.z);
+}
+
+void main()
+{
+    // Find the view-space bounding box of this invocation's cluster.
+    uint cluster = gl_GlobalInvocationID.x;
+    uint cluster_count = cluster_grid.x * cluster_grid.y * cluster_grid.z;
+    uvec3 coords = uvec3(
+        cluster % cluster_grid.x,
+        cluster / cluster_grid.x % cluster_grid.y,
+        cluster / (cluster_grid.x * cluster_grid.y));
+    vec2 uv_min = vec2(coords.xy) / vec2(cluster_grid.xy);
+    vec2 uv_max = vec2(coords.xy + 1) / vec2(cluster_grid.xy);
+    float near = slice_depth(float(coords.z), u_cluster_far);
+    float far = slice_depth(float(coords.z + 1), u_cluster_far);
+    if (coords.z == cluster_grid.z - 1) {
+        far = 1e30; // the last slice extends to infinity
+    }
+    vec3 box_min = vec3(1e30);
+    vec3 box_max = vec3(-1e30);
+    for (int i = 0; i < 4; i++) {
+        vec2 uv = vec2(i % 2 == 0 ? uv_min.x : uv_max.x,
+                       i / 2 == 0 ? uv_min.y : uv_max.y);
+        for (int j = 0; j < 2; j++) {
+            vec3 corner = view_point(uv, j == 0 ? near : min(far, 1e7));
+            box_min = min(box_min, corner);
+            box_max = max(box_max, corner);
+        }
+    }
+
+    // Test the lights in batches against the box, bounding spot lights
+    // by the sphere of their range.
+    uint count = 0;
+    uint first = cluster * MAX_CLUSTER_LIGHTS;
+    for (uint base = 0; base < u_light_count; base += BATCH_SIZE) {
+        uint i = base + gl_LocalInvocationID.x;
+        if (i < u_light_count) {
+            batch[gl_LocalInvocationID.x] =
+                vec4(view_lights[i].position, view_lights[i].range);
+        }
+        barrier();
+
+        uint batch_count = min(u_light_count - base, BATCH_SIZE);
+        for (uint j = 0; j < batch_count && cluster < cluster_count; j++) {
+            vec4 sphere = batch[j];
+            vec3 closest = clamp(sphere.xyz, box_min, box_max);
+            vec3 offset = closest - sphere.xyz;
+            if (dot(offset, offset) < sphere.w * sphere.w &&
+                count < MAX_CLUSTER_LIGHTS) {
+                cluster_lights[first + count] = base + j;
+                count++;
+            }
+        }
+        barrier();
+    }
+    if (cluster < cluster_count) {
+        cluster_counts[cluster] = count;
+    }
+}
@@ -0,0 +1,20 @@
+#version 460 core
+#include "../common/lights.glsl"
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 3) readonly buffer Lights { Light lights[]; };
+
+uniform mat4 u_view;
+uniform uint u_light_count;
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= u_light_count) {
+        return;
+    }
+    Light light = lights[i];
+    light.position = (u_view * vec4(light.position, 1.0)).xyz;
+    light.direction = normalize(mat3(u_view) * light.direction);
+    view_lights[i] = light;
+}
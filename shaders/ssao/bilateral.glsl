@@ -0,0 +1,42 @@
+// Weights shared by the fragment and compute bilateral blur shaders. The
+// blur radius is a compile-time constant when the host defines BLUR_RADIUS,
+// and falls back to the Ssao block otherwise.
+#ifndef BLUR_RADIUS
+#define MAX_BLUR_RADIUS 16
+#define BLUR_RADIUS min(u_blur_radius, MAX_BLUR_RADIUS)
+#else
+#define MAX_BLUR_RADIUS BLUR_RADIUS
+#endif
+
+// relative view distance difference at which a tap's weight falls off
+const float blur_depth_sigma = 0.05;
+// sharpness of the falloff of a tap's weight with the normal angle
+const float blur_normal_power = 8.0;
+// view distance of background pixels
+const float background_distance = 1e30;
+
+// Get the distance from the view to the surface at some depth.
+float view_distance(float depth)
+{
+    if (depth >= 1.0) {
+        return background_distance;
+    }
+    return -view_position(vec2(0.5), depth, u_inverse_projection).z;
+}
+
+// Get the weight of a tap some pixels away from the center of the blur, from
+// its distance, view distance, and normal relative to the center.
+float bilateral_weight(
+    int offset,
+    float center_distance,
+    vec3 center_normal,
+    float distance,
+    vec3 normal)
+{
+    float sigma = 0.5 * float(BLUR_RADIUS) + 0.5;
+    float spatial = exp(-float(offset * offset) / (2.0 * sigma * sigma));
+    float depth = exp(-abs(distance - center_distance) /
+                      (blur_depth_sigma * center_distance));
+    float similarity = pow(max(dot(normal, center_normal), 0.0), blur_normal_power);
+    return spatial * depth * similarity;
+}
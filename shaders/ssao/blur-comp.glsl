@@ -0,0 +1,68 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "bilateral.glsl"
+// One direction of the bilateral blur as a compute shader. Each work group
+// blurs GROUP_SIZE pixels of a row or column, and first caches them with
+// BLUR_RADIUS texels on either side in shared memory, so every texel is
+// fetched once instead of once per tap.
+#define GROUP_SIZE 128
+#define LINE_SIZE (GROUP_SIZE + 2 * MAX_BLUR_RADIUS)
+layout (local_size_x = GROUP_SIZE) in;
+
+layout (r16f, binding = 0) writeonly uniform image2D u_blurred;
+uniform sampler2D u_occlusion;
+uniform sampler2D u_depth; // same resolution as the occlusion
+uniform sampler2D u_normal; // same resolution as the occlusion
+uniform ivec2 u_direction; // (1, 0) or (0, 1)
+
+shared float line_occlusion[LINE_SIZE];
+shared float line_distance[LINE_SIZE];
+shared vec3 line_normal[LINE_SIZE];
+
+void main()
+{
+    vec2 size = vec2(textureSize(u_occlusion, 0));
+    ivec2 last = ivec2(ceil(size * u_uv_scale)) - 1;
+    ivec2 across = ivec2(1) - u_direction;
+    int line = int(gl_WorkGroupID.y);
+    int start = int(gl_WorkGroupID.x) * GROUP_SIZE - BLUR_RADIUS;
+    for (int i = int(gl_LocalInvocationIndex); i < GROUP_SIZE + 2 * BLUR_RADIUS;
+         i += GROUP_SIZE) {
+        ivec2 texel = u_direction * (start + i) + across * line;
+        texel = clamp(texel, ivec2(0), last);
+        line_occlusion[i] = texelFetch(u_occlusion, texel, 0).r;
+        line_distance[i] = view_distance(texelFetch(u_depth, texel, 0).r);
+        line_normal[i] = decode_normal(texelFetch(u_normal, texel, 0).rg);
+    }
+    barrier();
+
+    ivec2 pixel = u_direction * int(gl_GlobalInvocationID.x) + across * line;
+    if (any(greaterThan(pixel, last))) {
+        return;
+    }
+    int center = int(gl_LocalInvocationID.x) + BLUR_RADIUS;
+    float center_distance = line_distance[center];
+    if (center_distance >= background_distance) {
+        imageStore(u_blurred, pixel, vec4(line_occlusion[center]));
+        return;
+    }
+
+    float sum = line_occlusion[center];
+    float total = 1.0;
+    for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        if (i == 0) {
+            continue;
+        }
+        float weight = bilateral_weight(
+            i,
+            center_distance,
+            line_normal[center],
+            line_distance[center + i],
+            line_normal[center + i]);
+        sum += line_occlusion[center + i] * weight;
+        total += weight;
+    }
+    imageStore(u_blurred, pixel, vec4(sum / total));
+}
@@ -1,20 +1,47 @@
 #version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "bilateral.glsl"
+// One direction of a separable blur that keeps occlusion from leaking across
+// depth and normal discontinuities.
 uniform sampler2D u_occlusion;
-
-in vec2 v_tex_coords;
+uniform sampler2D u_depth; // same resolution as the occlusion
+uniform sampler2D u_normal; // same resolution as the occlusion
+uniform ivec2 u_direction; // (1, 0) or (0, 1)
 
 out float v_frag_color;
 
 void main()
 {
-    vec2 texel_size = 1.0 / vec2(textureSize(u_occlusion, 0)); 
-    float sum = 0.0;
-    for (int x = -2; x < 2; x++) {
-        for (int y = -2; y < 2; y++) {
-            vec2 offset = vec2(x, y) * texel_size;
-            sum += texture(u_occlusion, v_tex_coords + offset).r;
-        }
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 size = vec2(textureSize(u_occlusion, 0));
+    ivec2 last = ivec2(ceil(size * u_uv_scale)) - 1;
+    float center = texelFetch(u_occlusion, pixel, 0).r;
+    float center_distance = view_distance(texelFetch(u_depth, pixel, 0).r);
+    if (center_distance >= background_distance) {
+        v_frag_color = center;
+        return;
     }
+    vec3 center_normal = decode_normal(texelFetch(u_normal, pixel, 0).rg);
 
-    v_frag_color = sum / 16.0;
+    float sum = center;
+    float total = 1.0;
+    for (int i = -BLUR_RADIUS; i <= BLUR_RADIUS; i++) {
+        if (i == 0) {
+            continue;
+        }
+        ivec2 tap = clamp(pixel + i * u_direction, ivec2(0), last);
+        float distance = view_distance(texelFetch(u_depth, tap, 0).r);
+        vec3 normal = decode_normal(texelFetch(u_normal, tap, 0).rg);
+        float weight = bilateral_weight(
+            i,
+            center_distance,
+            center_normal,
+            distance,
+            normal);
+        sum += texelFetch(u_occlusion, tap, 0).r * weight;
+        total += weight;
+    }
+    v_frag_color = sum / total;
 }
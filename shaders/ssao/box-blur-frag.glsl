@@ -0,0 +1,23 @@
+#version 460 core
+#include "../common/frame.glsl"
+uniform sampler2D u_occlusion;
+
+in vec2 v_screen_coords;
+
+out float v_frag_color;
+
+void main()
+{
+    vec2 size = textureSize(u_occlusion, 0);
+    vec2 texel_size = 1.0 / (size * u_uv_scale);
+    float sum = 0.0;
+    for (int x = -2; x < 2; x++) {
+        for (int y = -2; y < 2; y++) {
+            vec2 offset = vec2(x, y) * texel_size;
+            vec2 uv = screen_to_texture(v_screen_coords + offset, size);
+            sum += texture(u_occlusion, uv).r;
+        }
+    }
+
+    v_frag_color = sum / 16.0;
+}
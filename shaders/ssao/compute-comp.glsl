@@ -0,0 +1,72 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "hemisphere.glsl"
+// Each work group loads the depth of its TILE_SIZE x TILE_SIZE pixels, plus
+// an APRON of texels on every side, into shared memory once. Kernel samples
+// that land inside read from there instead of the depth texture.
+#ifndef TILE_SIZE
+#define TILE_SIZE 16
+#endif
+
+#ifndef APRON
+#define APRON 16
+#endif
+
+#define SHARED_SIZE (TILE_SIZE + 2 * APRON)
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+layout (r16f, binding = 0) writeonly uniform image2D u_occlusion;
+uniform sampler2D u_depth;
+uniform sampler2D u_normal;
+uniform sampler2D u_noise;
+uniform ivec2 u_source_size; // size of the inputs in pixels
+
+shared float tile_depth[SHARED_SIZE][SHARED_SIZE];
+
+// Get the view-space position of the surface at some frame coordinates, read
+// from tile_depth when they fall inside it. The tile origin is the texel of
+// tile_depth[0][0].
+vec3 surface_position(vec2 uv, ivec2 tile_origin)
+{
+    vec2 size = vec2(textureSize(u_depth, 0));
+    ivec2 texel = ivec2(screen_to_texture(uv, size) * size);
+    ivec2 local = texel - tile_origin;
+    float depth;
+    if (all(greaterThanEqual(local, ivec2(0))) &&
+        all(lessThan(local, ivec2(SHARED_SIZE)))) {
+        depth = tile_depth[local.y][local.x];
+    } else {
+        depth = texelFetch(u_depth, texel, 0).r;
+    }
+    vec2 pixel_uv = texture_to_screen((vec2(texel) + 0.5) / size);
+    return view_position(pixel_uv, depth, u_inverse_projection);
+}
+
+void main()
+{
+    ivec2 tile_origin = ivec2(gl_WorkGroupID.xy) * TILE_SIZE - APRON;
+    for (uint i = gl_LocalInvocationIndex; i < SHARED_SIZE * SHARED_SIZE;
+         i += TILE_SIZE * TILE_SIZE) {
+        ivec2 local = ivec2(i % SHARED_SIZE, i / SHARED_SIZE);
+        ivec2 texel = clamp(tile_origin + local, ivec2(0), u_source_size - 1);
+        tile_depth[local.y][local.x] = texelFetch(u_depth, texel, 0).r;
+    }
+    barrier();
+
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, u_source_size))) {
+        return;
+    }
+    vec3 frag_pos = surface_position(
+        texture_to_screen((vec2(pixel) + 0.5) / vec2(textureSize(u_depth, 0))),
+        tile_origin);
+    vec3 normal = decode_normal(texelFetch(u_normal, pixel, 0).rg);
+    ivec2 noise_coords = pixel % NOISE_SIZE;
+    vec3 noise = texelFetch(u_noise, noise_coords, 0).xyz;
+
+    float occlusion =
+        hemisphere_occlusion(frag_pos, normal, noise, tile_origin);
+    imageStore(u_occlusion, pixel, vec4(occlusion));
+}
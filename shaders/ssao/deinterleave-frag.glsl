@@ -0,0 +1,21 @@
+#version 460 core
+layout (location = 0) out float b_depth;
+layout (location = 1) out vec2 b_normal;
+
+uniform sampler2D u_depth;
+uniform sampler2D u_normal;
+uniform int u_factor; // pixels between samples of one tile
+uniform ivec2 u_tile_size; // size of each atlas tile
+uniform ivec2 u_source_size; // size of the interleaved inputs in pixels
+
+void main()
+{
+    // Pixel (x, y) of tile (i, j) comes from source pixel
+    // (x * u_factor + i, y * u_factor + j).
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 tile = texel / u_tile_size;
+    ivec2 local = texel % u_tile_size;
+    ivec2 source = min(local * u_factor + tile, u_source_size - 1);
+    b_depth = texelFetch(u_depth, source, 0).r;
+    b_normal = texelFetch(u_normal, source, 0).rg;
+}
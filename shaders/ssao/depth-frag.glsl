@@ -1,47 +1,68 @@
 #version 460 core
-uniform sampler2D u_position;
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "hemisphere.glsl"
+uniform sampler2D u_depth;
 uniform sampler2D u_normal;
 uniform sampler2D u_noise;
 
-uniform vec3 u_samples[64];
-uniform mat4 u_projection;
-uniform vec2 u_noise_scale;
-
 in vec2 v_tex_coords;
+in vec2 v_screen_coords;
 
 out float v_frag_color;
 
-// Adjust scale based on size of scene.
-// Default: sponza is big
-const float c_scale = 1000;
-const float c_radius = 0.5 * c_scale;
-const float c_bias = 0.025 * c_scale;
+#ifdef DEINTERLEAVED
+// The inputs are an atlas of NOISE_SIZE x NOISE_SIZE tiles. Each tile holds
+// the pixels that share one kernel rotation, so neighbouring fragments
+// sample neighbouring texels.
+uniform ivec2 u_source_size; // size of the interleaved inputs in pixels
 
-void main()
+// Get the view-space position of the surface at some frame coordinates,
+// sampled from the tile of the atlas that holds this fragment.
+vec3 surface_position(vec2 uv, ivec2 tile)
 {
-    vec3 frag_pos = texture(u_position, v_tex_coords).xyz;
-    vec3 normal = normalize(texture(u_normal, v_tex_coords).rgb);
-    vec3 random = normalize(texture(u_noise, v_tex_coords * u_noise_scale).xyz);
-
-    vec3 tangent = normalize(random - normal * dot(random, normal));
-    vec3 bitangent = cross(normal, tangent);
-    mat3 tbn = mat3(tangent, bitangent, normal);
-
-    float occlusion = 0.0;
-    for (int i = 0; i < 64; i++) {
-        vec3 sample_pos = tbn * u_samples[i];
-        sample_pos = frag_pos + sample_pos * c_radius;
-
-        vec4 offset = vec4(sample_pos, 1.0);
-        offset = u_projection * offset;
-        offset.xyz /= offset.w;
-        offset.xyz = offset.xyz * 0.5 + 0.5;
-
-        float sample_depth = texture(u_position, offset.xy).z;
+    ivec2 tile_size = textureSize(u_depth, 0) / NOISE_SIZE;
+    vec2 extent = ceil(vec2(u_source_size - tile) / float(NOISE_SIZE));
+    vec2 local = (uv * vec2(u_source_size) - vec2(tile)) / float(NOISE_SIZE);
+    local = clamp(floor(local), vec2(0.0), extent - 1.0);
+    float depth = texelFetch(u_depth, tile * tile_size + ivec2(local), 0).r;
+    vec2 pixel = local * float(NOISE_SIZE) + vec2(tile) + 0.5;
+    return view_position(pixel / vec2(u_source_size), depth, u_inverse_projection);
+}
+#else
+// Get the view-space position of the surface at some frame coordinates. The
+// inputs are not split into tiles, so the tile is unused.
+vec3 surface_position(vec2 uv, ivec2 tile)
+{
+    vec2 tex_coords = screen_to_texture(uv, textureSize(u_depth, 0));
+    float depth = texture(u_depth, tex_coords).r;
+    return view_position(texture_to_screen(tex_coords), depth, u_inverse_projection);
+}
+#endif
 
-        float boundary = smoothstep(0.0, 1.0, c_radius / abs(frag_pos.z - sample_depth));
-        occlusion += (sample_depth >= sample_pos.z + c_bias ? 1.0 : 0.0) * boundary;
+void main()
+{
+#ifdef DEINTERLEAVED
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 tile_size = textureSize(u_depth, 0) / NOISE_SIZE;
+    ivec2 tile = texel / tile_size;
+    ivec2 pixel = texel % tile_size * NOISE_SIZE + tile;
+    if (any(greaterThanEqual(pixel, u_source_size))) {
+        v_frag_color = 1.0;
+        return;
     }
-    occlusion = 1.0 - (occlusion / 64.0);
-    v_frag_color = occlusion;
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(u_source_size);
+    vec3 normal = decode_normal(texelFetch(u_normal, texel, 0).rg);
+    ivec2 noise_coords = tile;
+#else
+    vec2 uv = v_screen_coords;
+    vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+    ivec2 noise_coords = ivec2(gl_FragCoord.xy) % NOISE_SIZE;
+    ivec2 tile = ivec2(0);
+#endif
+    vec3 frag_pos = surface_position(uv, tile);
+    vec3 noise = texelFetch(u_noise, noise_coords, 0).xyz;
+
+    v_frag_color = hemisphere_occlusion(frag_pos, normal, noise, tile);
 }
@@ -0,0 +1,32 @@
+#version 460 core
+#include "../common/frame.glsl"
+layout (location = 0) out float b_depth;
+layout (location = 1) out vec2 b_normal;
+
+uniform sampler2D u_depth;
+uniform sampler2D u_normal;
+uniform int u_divisor; // ratio of the full and reduced resolutions
+
+void main()
+{
+    // Alternate between the closest and farthest depth of each block in a
+    // checkerboard, so that both sides of an edge are kept.
+    ivec2 reduced = ivec2(gl_FragCoord.xy);
+    ivec2 base = reduced * u_divisor;
+    bool farthest = ((reduced.x + reduced.y) & 1) == 1;
+    float depth = farthest ? 0.0 : 1.0;
+    ivec2 selected = base;
+    for (int y = 0; y < u_divisor; y++) {
+        for (int x = 0; x < u_divisor; x++) {
+            ivec2 texel = min(base + ivec2(x, y), ivec2(u_render_size) - 1);
+            float d = texelFetch(u_depth, texel, 0).r;
+            if (farthest ? d > depth : d < depth) {
+                depth = d;
+                selected = texel;
+            }
+        }
+    }
+
+    b_depth = depth;
+    b_normal = texelFetch(u_normal, selected, 0).rg;
+}
@@ -0,0 +1,75 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "horizon.glsl"
+// Ground-truth ambient occlusion (Jimenez et al. 2016): find the two
+// horizons of a few view-aligned slices, and integrate the cosine-weighted
+// visibility between them analytically.
+#ifndef SLICES
+#define SLICES u_slices
+#endif
+
+// Get the cosine of the highest horizon along a screen direction, faded
+// towards the bottom of the hemisphere with distance.
+float horizon_cos(vec2 direction, vec3 position, vec3 view, float jitter)
+{
+    float highest = -1.0;
+    for (int s = 0; s < STEPS; s++) {
+        vec2 uv = v_screen_coords + direction * (float(s) + jitter + 1.0);
+        vec3 delta = surface_position(uv) - position;
+        float distance_sq = dot(delta, delta);
+        float cos_h = dot(delta, view) * inversesqrt(distance_sq);
+        float falloff =
+            clamp(1.0 - distance_sq / (RADIUS * RADIUS), 0.0, 1.0);
+        highest = max(highest, mix(-1.0, cos_h, falloff));
+    }
+    return highest;
+}
+
+// Integrate the cosine-weighted visibility of one side of a slice.
+float integrate_arc(float h, float n)
+{
+    return 0.25 * (-cos(2.0 * h - n) + cos(n) + 2.0 * h * sin(n));
+}
+
+void main()
+{
+    float depth = texture(u_depth, v_tex_coords).r;
+    if (depth >= 1.0) {
+        v_frag_color = 1.0;
+        return;
+    }
+    vec3 position = surface_position(v_screen_coords);
+    vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+    vec3 view = normalize(-position);
+    vec2 radius = screen_radius(position);
+    vec2 noise = pixel_noise();
+
+    float visibility = 0.0;
+    for (int i = 0; i < SLICES; i++) {
+        float angle = (float(i) + noise.x) * PI / float(SLICES);
+        vec2 omega = vec2(cos(angle), sin(angle));
+        vec2 step_size = omega * radius / float(STEPS + 1);
+
+        // project the normal onto the slice plane
+        vec3 direction = vec3(omega, 0.0);
+        vec3 axis = normalize(cross(direction, view));
+        vec3 projected = normal - axis * dot(normal, axis);
+        float projected_length = length(projected);
+        vec3 tangent = cross(view, axis);
+        float cos_n =
+            clamp(dot(projected, view) / projected_length, -1.0, 1.0);
+        float n = sign(dot(projected, tangent)) * acos(cos_n);
+
+        // clamp the horizons to the hemisphere around the normal
+        float h0 = -acos(horizon_cos(-step_size, position, view, noise.y));
+        float h1 = acos(horizon_cos(step_size, position, view, noise.y));
+        h0 = n + max(h0 - n, -0.5 * PI);
+        h1 = n + min(h1 - n, 0.5 * PI);
+
+        visibility += projected_length *
+                      (integrate_arc(h0, n) + integrate_arc(h1, n));
+    }
+    v_frag_color = clamp(visibility / float(SLICES), 0.0, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+#include "horizon.glsl"
+// Horizon-based ambient occlusion, in the per-sample form of HBAO+: every
+// step along a few screen directions adds how far above the tangent plane
+// the sampled surface rises, faded out towards the radius.
+#ifndef DIRECTIONS
+#define DIRECTIONS u_directions
+#endif
+
+const float angle_bias = 0.1; // sine of the ignored angle above the plane
+
+void main()
+{
+    float depth = texture(u_depth, v_tex_coords).r;
+    if (depth >= 1.0) {
+        v_frag_color = 1.0;
+        return;
+    }
+    vec3 position = surface_position(v_screen_coords);
+    vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+    vec2 radius = screen_radius(position);
+    vec2 noise = pixel_noise();
+
+    float occlusion = 0.0;
+    for (int d = 0; d < DIRECTIONS; d++) {
+        float angle = (float(d) + noise.x) * 2.0 * PI / float(DIRECTIONS);
+        vec2 step_size = vec2(cos(angle), sin(angle)) * radius /
+                         float(STEPS + 1);
+        for (int s = 0; s < STEPS; s++) {
+            vec2 uv =
+                v_screen_coords + step_size * (float(s) + noise.y + 1.0);
+            vec3 v = surface_position(uv) - position;
+            float distance_sq = dot(v, v);
+            float rise = dot(normal, v) * inversesqrt(distance_sq);
+            float falloff =
+                clamp(1.0 - distance_sq / (RADIUS * RADIUS), 0.0, 1.0);
+            occlusion += max(rise - angle_bias, 0.0) * falloff;
+        }
+    }
+    occlusion /= float(DIRECTIONS * STEPS) * (1.0 - angle_bias);
+    v_frag_color = clamp(1.0 - occlusion, 0.0, 1.0);
+}
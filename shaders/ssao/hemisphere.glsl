@@ -0,0 +1,66 @@
+// Hemisphere-kernel occlusion shared by the fragment and compute ssao
+// shaders. The including shader defines surface_position.
+
+// Each parameter below is a compile-time constant when the host defines the
+// macro of the same name, and falls back to the Ssao block otherwise.
+#ifndef SAMPLE_COUNT
+#define SAMPLE_COUNT u_sample_count
+#endif
+
+#ifndef RADIUS
+#define RADIUS u_radius
+#endif
+
+#ifndef BIAS
+#define BIAS u_bias
+#endif
+
+#ifndef NOISE_SIZE
+#define NOISE_SIZE u_noise_size
+#endif
+
+uniform vec2 u_frame_noise; // per-frame noise offset for temporal ssao
+
+// Get the view-space position of the surface at some frame coordinates. The
+// tile is the part of the depth input that the including shader reads from.
+vec3 surface_position(vec2 uv, ivec2 tile);
+
+// Get the length scale of a kernel offset from its length parameter, as
+// kernel_length in sampling.cpp does.
+float kernel_length(float parameter)
+{
+    return mix(0.1, 1.0, parameter * parameter);
+}
+
+// Get the fraction of a hemisphere of kernel samples around a view-space
+// surface that is not occluded, with the kernel rotated by the xy of a noise
+// vector and its lengths shifted by the z, and the depth sampled from a tile
+// of the including shader.
+float hemisphere_occlusion(vec3 frag_pos, vec3 normal, vec3 noise, ivec2 tile)
+{
+    float angle = u_frame_noise.x * 6.28318530718;
+    mat2 spin = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+    vec3 random = vec3(spin * noise.xy, 0.0);
+    float shift = noise.z + u_frame_noise.y;
+    vec3 tangent = normalize(random - normal * dot(random, normal));
+    vec3 bitangent = cross(normal, tangent);
+    mat3 tbn = mat3(tangent, bitangent, normal);
+
+    float occlusion = 0.0;
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        vec4 k = u_samples[i];
+        vec3 sample_pos = tbn * (k.xyz * kernel_length(fract(k.w + shift)));
+        sample_pos = frag_pos + sample_pos * RADIUS;
+
+        vec4 offset = vec4(sample_pos, 1.0);
+        offset = u_projection * offset;
+        offset.xyz /= offset.w;
+        offset.xyz = offset.xyz * 0.5 + 0.5;
+
+        float sample_depth = surface_position(offset.xy, tile).z;
+
+        float boundary = smoothstep(0.0, 1.0, RADIUS / abs(frag_pos.z - sample_depth));
+        occlusion += (sample_depth >= sample_pos.z + BIAS ? 1.0 : 0.0) * boundary;
+    }
+    return 1.0 - (occlusion / float(SAMPLE_COUNT));
+}
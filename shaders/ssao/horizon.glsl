@@ -0,0 +1,50 @@
+// Inputs and helpers shared by the horizon-based occlusion shaders. Each
+// parameter below is a compile-time constant when the host defines the
+// macro of the same name, and falls back to the Ssao block otherwise.
+#ifndef RADIUS
+#define RADIUS u_radius
+#endif
+
+#ifndef STEPS
+#define STEPS u_steps
+#endif
+
+#ifndef NOISE_SIZE
+#define NOISE_SIZE u_noise_size
+#endif
+
+uniform sampler2D u_depth;
+uniform sampler2D u_normal;
+uniform sampler2D u_noise;
+uniform vec2 u_frame_noise; // per-frame noise offset for temporal ssao
+
+in vec2 v_tex_coords;
+in vec2 v_screen_coords;
+
+out float v_frag_color;
+
+const float PI = 3.14159265359;
+
+// Get the view-space position of the surface at some frame coordinates.
+vec3 surface_position(vec2 uv)
+{
+    vec2 tex_coords = screen_to_texture(uv, textureSize(u_depth, 0));
+    float depth = texture(u_depth, tex_coords).r;
+    return view_position(texture_to_screen(tex_coords), depth, u_inverse_projection);
+}
+
+// Get the extent of the occlusion radius in frame coordinates around a
+// view-space position.
+vec2 screen_radius(vec3 position)
+{
+    vec2 scale = vec2(u_projection[0][0], u_projection[1][1]);
+    return 0.5 * RADIUS * scale / -position.z;
+}
+
+// Get a per-pixel rotation and step jitter in [0, 1) from the noise texture.
+vec2 pixel_noise()
+{
+    ivec2 noise_coords = ivec2(gl_FragCoord.xy) % NOISE_SIZE;
+    vec2 noise = texelFetch(u_noise, noise_coords, 0).xy;
+    return fract(noise * 0.5 + 0.5 + u_frame_noise);
+}
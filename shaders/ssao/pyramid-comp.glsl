@@ -0,0 +1,36 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+// Build one level of the view distance pyramid read by sao. Level 0 holds
+// the linear view distance of every pixel, and every further level keeps one
+// texel of each 2x2 block of the level below, on a rotated grid, so that
+// distances are never blended across edges.
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) writeonly uniform image2D u_level_image;
+uniform sampler2D u_depth; // hardware depth, read for level 0
+uniform sampler2D u_pyramid; // lower levels of the pyramid
+uniform int u_level; // level being built
+uniform ivec2 u_level_size; // pixels covered by the frame in this level
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, u_level_size))) {
+        return;
+    }
+
+    float distance;
+    if (u_level == 0) {
+        float depth = texelFetch(u_depth, texel, 0).r;
+        vec2 uv = (vec2(texel) + 0.5) / vec2(u_level_size);
+        distance = depth >= 1.0
+                       ? 1e30
+                       : -view_position(uv, depth, u_inverse_projection).z;
+    } else {
+        ivec2 below = textureSize(u_pyramid, u_level - 1) - 1;
+        ivec2 source = texel * 2 + ivec2(texel.y & 1, texel.x & 1);
+        distance = texelFetch(u_pyramid, min(source, below), u_level - 1).r;
+    }
+    imageStore(u_level_image, texel, vec4(distance));
+}
@@ -0,0 +1,14 @@
+#version 460 core
+uniform sampler2D u_occlusion;
+uniform int u_factor; // pixels between samples of one tile
+uniform ivec2 u_tile_size; // size of each atlas tile
+
+out float v_frag_color;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 tile = pixel % u_factor;
+    ivec2 local = pixel / u_factor;
+    v_frag_color = texelFetch(u_occlusion, tile * u_tile_size + local, 0).r;
+}
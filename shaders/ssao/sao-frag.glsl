@@ -0,0 +1,96 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+#include "../common/ssao.glsl"
+// Scalable ambient obscurance: taps on a spiral around each pixel read view
+// distances from the level of the pyramid whose texel size matches their
+// distance from the center, so distant taps stay cache resident at any
+// radius. Each parameter below is a compile-time constant when the host
+// defines the macro of the same name, and falls back to the Ssao block
+// otherwise.
+#ifndef SAMPLE_COUNT
+#define SAMPLE_COUNT u_sample_count
+#endif
+
+#ifndef RADIUS
+#define RADIUS u_radius
+#endif
+
+#ifndef BIAS
+#define BIAS u_bias
+#endif
+
+#ifndef NOISE_SIZE
+#define NOISE_SIZE u_noise_size
+#endif
+
+// highest pyramid level read by the taps (0 reads full resolution only)
+#ifndef SAO_MAX_LEVEL
+#define SAO_MAX_LEVEL 5
+#endif
+
+uniform sampler2D u_depth; // view distance pyramid
+uniform sampler2D u_normal;
+uniform sampler2D u_noise;
+uniform vec2 u_frame_noise; // per-frame noise offset for temporal ssao
+
+in vec2 v_tex_coords;
+in vec2 v_screen_coords;
+
+out float v_frag_color;
+
+const float PI = 3.14159265359;
+const float spiral_turns = 7.0; // turns of the tap spiral
+const int log_level_offset = 3; // taps within 2^3 pixels read level 0
+
+// Get the view-space position of a pixel of the frame at a view distance.
+vec3 pixel_position(vec2 pixel, vec2 size, float distance)
+{
+    vec2 ndc = pixel / size * 2.0 - 1.0;
+    vec2 scale = vec2(u_projection[0][0], u_projection[1][1]);
+    return vec3(ndc * distance / scale, -distance);
+}
+
+void main()
+{
+    vec2 size = ceil(vec2(textureSize(u_depth, 0)) * u_uv_scale);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float center_distance = texelFetch(u_depth, pixel, 0).r;
+    if (center_distance >= 1e30) {
+        v_frag_color = 1.0;
+        return;
+    }
+    vec3 position = pixel_position(vec2(pixel) + 0.5, size, center_distance);
+    vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+
+    // Radius of the occlusion in pixels at the center's distance.
+    float pixel_radius =
+        0.5 * RADIUS * u_projection[1][1] * size.y / center_distance;
+    vec3 noise = texelFetch(u_noise, pixel % NOISE_SIZE, 0).xyz;
+    float rotation = atan(noise.y, noise.x) + 2.0 * PI * u_frame_noise.x;
+
+    float occlusion = 0.0;
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        float alpha = (float(i) + 0.5) / float(SAMPLE_COUNT);
+        float angle = alpha * spiral_turns * 2.0 * PI + rotation;
+        float offset = alpha * pixel_radius;
+        ivec2 tap = ivec2(vec2(pixel) + offset * vec2(cos(angle), sin(angle)));
+        tap = clamp(tap, ivec2(0), ivec2(size) - 1);
+
+        int level = clamp(
+            findMSB(int(offset)) - log_level_offset,
+            0,
+            min(SAO_MAX_LEVEL, textureQueryLevels(u_depth) - 1));
+        ivec2 level_tap = min(tap >> level, textureSize(u_depth, level) - 1);
+        float distance = texelFetch(u_depth, level_tap, level).r;
+
+        vec3 v = pixel_position(vec2(tap) + 0.5, size, distance) - position;
+        float vv = dot(v, v);
+        float vn = dot(v, normal);
+        float r2 = RADIUS * RADIUS;
+        float f = max(r2 - vv, 0.0) / r2;
+        occlusion += f * f * f * max((vn - BIAS) / (0.01 * r2 + vv), 0.0) * RADIUS;
+    }
+    occlusion *= 5.0 / float(SAMPLE_COUNT);
+    v_frag_color = clamp(1.0 - occlusion, 0.0, 1.0);
+}
@@ -0,0 +1,60 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+uniform sampler2D u_occlusion; // occlusion of this frame
+uniform sampler2D u_depth;
+uniform sampler2D u_normal;
+uniform sampler2D u_history; // accumulation of the previous frame
+
+uniform mat4 u_reprojection; // view space of this frame to the previous one
+uniform vec2 u_history_uv_scale; // u_uv_scale of the previous frame
+uniform float u_history_weight; // weight of the history, 0 to reset
+
+in vec2 v_tex_coords;
+in vec2 v_screen_coords;
+
+// accumulated occlusion, view distance, and encoded view-space normal
+out vec4 v_frag_color;
+
+// relative view distance change at which the history is rejected
+const float depth_tolerance = 0.05;
+// cosine of the normal change at which the history is rejected
+const float normal_tolerance = 0.9;
+
+void main()
+{
+    vec2 occlusion_coords =
+        screen_to_texture(v_screen_coords, textureSize(u_occlusion, 0));
+    float occlusion = texture(u_occlusion, occlusion_coords).r;
+    float depth = texture(u_depth, v_tex_coords).r;
+    if (depth >= 1.0) {
+        v_frag_color = vec4(1.0, 1e30, 0.5, 0.5);
+        return;
+    }
+    vec3 position = view_position(v_screen_coords, depth, u_inverse_projection);
+    vec3 normal = decode_normal(texture(u_normal, v_tex_coords).rg);
+
+    // Find where the surface was in the previous frame.
+    vec3 previous = (u_reprojection * vec4(position, 1.0)).xyz;
+    vec3 previous_normal = mat3(u_reprojection) * normal;
+    vec4 clip = u_projection * vec4(previous, 1.0);
+    vec2 previous_uv = clip.xy / clip.w * 0.5 + 0.5;
+
+    // Reject the history where the surface was off screen or hidden.
+    float weight = u_history_weight;
+    if (any(lessThan(previous_uv, vec2(0.0))) ||
+        any(greaterThan(previous_uv, vec2(1.0))) || clip.w <= 0.0) {
+        weight = 0.0;
+    }
+    ivec2 texel = ivec2(previous_uv * u_history_uv_scale *
+                        vec2(textureSize(u_history, 0)));
+    vec4 history = texelFetch(u_history, texel, 0);
+    float distance = -previous.z;
+    if (abs(history.g - distance) > depth_tolerance * distance ||
+        dot(decode_normal(history.ba), previous_normal) < normal_tolerance) {
+        weight = 0.0;
+    }
+
+    occlusion = mix(occlusion, history.r, weight);
+    v_frag_color = vec4(occlusion, -position.z, encode_normal(normal));
+}
@@ -0,0 +1,68 @@
+#version 460 core
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+uniform sampler2D u_occlusion; // reduced resolution
+uniform sampler2D u_reduced_depth; // reduced resolution
+uniform sampler2D u_depth; // full resolution
+
+in vec2 v_tex_coords;
+in vec2 v_screen_coords;
+
+out float v_frag_color;
+
+// relative depth difference at which a reduced texel's weight falls off
+const float depth_sigma = 0.05;
+
+// Get the distance from the view to the surface at some frame coordinates.
+float linear_depth(vec2 uv, float depth)
+{
+    if (depth >= 1.0) {
+        return 1e30;
+    }
+    return -view_position(uv, depth, u_inverse_projection).z;
+}
+
+void main()
+{
+    float full_depth = texture(u_depth, v_tex_coords).r;
+    if (full_depth >= 1.0) {
+        v_frag_color = 1.0;
+        return;
+    }
+    float depth = linear_depth(v_screen_coords, full_depth);
+
+    // Weight the four reduced texels around this pixel by their bilinear
+    // weight and by how close their depth is to this pixel's depth.
+    vec2 size = textureSize(u_occlusion, 0);
+    ivec2 limit = ivec2(ceil(size * u_uv_scale)) - 1;
+    vec2 position = v_tex_coords * size - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+
+    float sum = 0.0;
+    float weight_sum = 0.0;
+    float closest = 1e30;
+    float nearest = 1.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i % 2, i / 2);
+        ivec2 texel = clamp(base + offset, ivec2(0), limit);
+        vec2 uv = texture_to_screen((vec2(texel) + 0.5) / size);
+        float reduced_depth =
+            linear_depth(uv, texelFetch(u_reduced_depth, texel, 0).r);
+        float occlusion = texelFetch(u_occlusion, texel, 0).r;
+
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float difference = abs(reduced_depth - depth) / depth;
+        float weight = bilinear.x * bilinear.y *
+                       exp(-0.5 * pow(difference / depth_sigma, 2.0));
+        sum += weight * occlusion;
+        weight_sum += weight;
+        if (difference < closest) {
+            closest = difference;
+            nearest = occlusion;
+        }
+    }
+
+    // fall back to the closest depth when every texel is across an edge
+    v_frag_color = weight_sum > 1e-4 ? sum / weight_sum : nearest;
+}
@@ -0,0 +1,13 @@
+#version 460 core
+#include "../common/frame.glsl"
+uniform sampler2D u_color;
+
+in vec2 v_screen_coords;
+
+out vec4 v_frag_color;
+
+void main()
+{
+    vec2 uv = screen_to_texture(v_screen_coords, textureSize(u_color, 0));
+    v_frag_color = texture(u_color, uv);
+}
@@ -0,0 +1,10 @@
+#version 460 core
+layout (location = 0) out uint b_visibility;
+
+uniform uint u_first_triangle; // id of the mesh's first triangle, less one
+
+void main()
+{
+    // 0 is left for pixels that no triangle covers
+    b_visibility = u_first_triangle + uint(gl_PrimitiveID) + 1u;
+}
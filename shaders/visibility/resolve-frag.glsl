@@ -0,0 +1,139 @@
+#version 460 core
+#extension GL_ARB_bindless_texture : require
+#include "../common/frame.glsl"
+#include "../common/gbuffer.glsl"
+layout (location = 0) out vec2 b_normal;
+layout (location = 1) out vec4 b_diffuse_spec;
+
+// A Draw locates a mesh in the merged buffers (see DrawRecord in
+// visibility.cpp). Texture handles are 0 for missing textures.
+struct Draw {
+    uint first_triangle;
+    uint base_vertex;
+    uvec2 diffuse;
+    uvec2 normal;
+    uvec2 specular;
+};
+
+// Vertices are tightly packed Vertex structs (see mesh.hpp).
+const uint vertex_stride = 11;
+
+layout (std430, binding = 0) readonly buffer Vertices { float vertices[]; };
+layout (std430, binding = 1) readonly buffer Indices { uint indices[]; };
+layout (std430, binding = 2) readonly buffer Draws { Draw draws[]; };
+
+uniform usampler2D u_visibility;
+uniform mat4 u_model;
+uniform mat4 u_view;
+
+// Find the mesh that a triangle id belongs to.
+uint find_draw(uint id)
+{
+    uint low = 0;
+    uint high = uint(draws.length()) - 1;
+    while (low < high) {
+        uint mid = (low + high + 1) / 2;
+        if (draws[mid].first_triangle < id) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+vec3 fetch_vec3(uint offset)
+{
+    return vec3(vertices[offset], vertices[offset + 1], vertices[offset + 2]);
+}
+
+// Intersect a ray from the view origin with a triangle, and get the
+// perspective-correct barycentric coordinates of the hit.
+vec3 barycentrics(vec3 direction, vec3 p0, vec3 p1, vec3 p2)
+{
+    vec3 e1 = p1 - p0;
+    vec3 e2 = p2 - p0;
+    vec3 p = cross(direction, e2);
+    float inverse_det = 1.0 / dot(e1, p);
+    vec3 t = -p0;
+    float u = dot(t, p) * inverse_det;
+    float v = dot(direction, cross(t, e1)) * inverse_det;
+    return vec3(1.0 - u - v, u, v);
+}
+
+// Get the view direction through a point in frame coordinates.
+vec3 view_ray(vec2 uv)
+{
+    return view_position(uv, 0.5, u_inverse_projection);
+}
+
+// Sample a material texture, reading (0, 0, 0, 1) for missing textures like
+// an unbound texture unit does.
+vec4 sample_material(uvec2 handle, vec2 uv, vec2 dx, vec2 dy)
+{
+    if (handle == uvec2(0)) {
+        return vec4(0.0, 0.0, 0.0, 1.0);
+    }
+    return textureGrad(sampler2D(handle), uv, dx, dy);
+}
+
+void main()
+{
+    uint id = texelFetch(u_visibility, ivec2(gl_FragCoord.xy), 0).r;
+    if (id == 0) {
+        discard;
+    }
+    Draw draw = draws[find_draw(id)];
+    uint triangle = id - 1;
+
+    // fetch the triangle's vertices
+    mat4 model_view = u_view * u_model;
+    vec3 position[3];
+    vec3 normal[3];
+    vec2 tex_coords[3];
+    vec3 tangent[3];
+    for (uint i = 0; i < 3; i++) {
+        uint vertex = draw.base_vertex + indices[triangle * 3 + i];
+        uint offset = vertex * vertex_stride;
+        position[i] = (model_view * vec4(fetch_vec3(offset), 1.0)).xyz;
+        normal[i] = fetch_vec3(offset + 3);
+        tex_coords[i] = vec2(vertices[offset + 6], vertices[offset + 7]);
+        tangent[i] = fetch_vec3(offset + 8);
+    }
+
+    // interpolate at this pixel and its neighbours for texture gradients
+    vec2 uv = gl_FragCoord.xy / u_render_size;
+    vec2 texel = 1.0 / u_render_size;
+    vec3 b = barycentrics(view_ray(uv), position[0], position[1], position[2]);
+    vec3 b_dx = barycentrics(
+        view_ray(uv + vec2(texel.x, 0.0)),
+        position[0],
+        position[1],
+        position[2]);
+    vec3 b_dy = barycentrics(
+        view_ray(uv + vec2(0.0, texel.y)),
+        position[0],
+        position[1],
+        position[2]);
+    mat3x2 tex = mat3x2(tex_coords[0], tex_coords[1], tex_coords[2]);
+    vec2 tex_coord = tex * b;
+    vec2 dx = tex * b_dx - tex_coord;
+    vec2 dy = tex * b_dy - tex_coord;
+
+    // build the tangent space as the geometry vertex shader does
+    vec3 t = mat3(tangent[0], tangent[1], tangent[2]) * b;
+    vec3 n = mat3(normal[0], normal[1], normal[2]) * b;
+    t = normalize(vec3(u_model * vec4(t, 0.0)));
+    n = normalize(vec3(u_model * vec4(n, 0.0)));
+    t = normalize(t - dot(t, n) * n);
+    mat3 tbn = mat3(u_view) * mat3(t, cross(n, t), n);
+
+    // write normal texture
+    vec3 normal_map = sample_material(draw.normal, tex_coord, dx, dy).rgb;
+    normal_map = normal_map * 2.0 - 1.0;
+    b_normal = encode_normal(normalize(tbn * normal_map));
+
+    // write color texture
+    b_diffuse_spec.rgb = sample_material(draw.diffuse, tex_coord, dx, dy).rgb;
+    b_diffuse_spec.a = sample_material(draw.specular, tex_coord, dx, dy).r;
+}
@@ -0,0 +1,11 @@
+#version 460 core
+#include "../common/frame.glsl"
+layout (location = 0) in vec3 b_position;
+
+uniform mat4 u_model;
+uniform mat4 u_view;
+
+void main()
+{
+    gl_Position = u_projection * u_view * u_model * vec4(b_position, 1.0);
+}
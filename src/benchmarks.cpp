@@ -0,0 +1,970 @@
+#include "benchmarks.hpp"
+#include "image_metrics.hpp"
+#include "thread_pool.hpp"
+
+#include <fmt/core.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto cpu_ssao_max_rmse = 0.005; // cpu against gpu ssao
+constexpr auto mib = 1024.0 * 1024.0;
+
+// A Column of a printed table.
+struct Column {
+    std::string name;
+    int width;
+    const char* format = "{}"; // of numeric cells
+};
+
+// A Table prints a header and rows of cells, with the first column aligned
+// left and the others right.
+class Table {
+  public:
+    explicit Table(std::vector<Column> columns)
+        : _columns{std::move(columns)} {
+        auto names = std::vector<std::string>{};
+        for (const auto& column : _columns) {
+            names.emplace_back(column.name);
+        }
+        print(names);
+    }
+
+    // Print a row, formatting numbers with the format of their column, and
+    // text as is.
+    template <typename... T> void row(const T&... cells) {
+        auto i = size_t{0};
+        auto format = [this, &i]<typename U>(const U& cell) {
+            const auto& column = _columns[i++];
+            if constexpr (std::is_convertible_v<U, std::string_view>) {
+                return std::string{cell};
+            } else {
+                return fmt::format(fmt::runtime(column.format), cell);
+            }
+        };
+        print({format(cells)...});
+    }
+
+    // Print a row of formatted cells.
+    void print(const std::vector<std::string>& cells) const {
+        for (auto i = size_t{0}; i < cells.size(); i++) {
+            if (i == 0) {
+                fmt::print("{:<{}}", cells[i], _columns[i].width);
+            } else {
+                fmt::print(" {:>{}}", cells[i], _columns[i].width);
+            }
+        }
+        fmt::print("\n");
+    }
+
+  private:
+    std::vector<Column> _columns;
+};
+
+// Pass filters.
+bool all_passes(std::string_view) {
+    return true;
+}
+
+bool ssao_passes(std::string_view name) {
+    return name.starts_with("ssao");
+}
+
+bool ssao_pass(std::string_view name) {
+    return name == "ssao";
+}
+
+bool blur_passes(std::string_view name) {
+    return name.starts_with("ssao_blur");
+}
+
+// Add up the pass times that match a filter.
+double total(
+    const std::vector<std::pair<std::string, double>>& timings,
+    const Benchmarks::PassFilter& filter) {
+    auto ms = 0.0;
+    for (const auto& [name, pass_ms] : timings) {
+        if (filter(name)) {
+            ms += pass_ms;
+        }
+    }
+    return ms;
+}
+
+// Set the ssao settings to the gpu passes that the cpu ssao reproduces.
+void use_cpu_ssao(Benchmarks::State& state) {
+    state.ssao.method = AoMethod::Hemisphere;
+    state.ssao.resolution_divisor = 1;
+    state.ssao.deinterleaved = false;
+    state.ssao.compute = false;
+    state.ssao.temporal = false;
+    state.ssao.blur = BlurMethod::Bilateral;
+}
+
+// Get the display name of an ambient occlusion method.
+const char* method_name(AoMethod method) {
+    switch (method) {
+    case AoMethod::Hbao:
+        return "hbao";
+    case AoMethod::Gtao:
+        return "gtao";
+    case AoMethod::Sao:
+        return "sao";
+    default:
+        return "hemisphere";
+    }
+}
+
+// Get the display name of a kernel pattern.
+const char* kernel_name(KernelPattern pattern) {
+    switch (pattern) {
+    case KernelPattern::Classic:
+        return "classic";
+    case KernelPattern::Hammersley:
+        return "hammersley";
+    case KernelPattern::Halton:
+        return "halton";
+    case KernelPattern::PoissonDisk:
+        return "poisson";
+    default:
+        return "random";
+    }
+}
+
+// Get the number of texture fetches per pixel of a blur method.
+double blur_fetches(BlurMethod blur, int radius) {
+    constexpr auto group_size = 128.0; // GROUP_SIZE in blur-comp.glsl
+    constexpr auto inputs = 3.0; // occlusion, depth, and normal
+    auto taps = 2.0 * radius + 1.0;
+    switch (blur) {
+    case BlurMethod::Bilateral:
+        return 2.0 * inputs * taps;
+    case BlurMethod::BilateralCompute:
+        return 2.0 * inputs * (group_size + taps - 1.0) / group_size;
+    default:
+        return 16.0;
+    }
+}
+
+// Get the display name of a blur method.
+const char* blur_name(BlurMethod blur) {
+    switch (blur) {
+    case BlurMethod::Bilateral:
+        return "bilateral";
+    case BlurMethod::BilateralCompute:
+        return "bilateral cs";
+    default:
+        return "box";
+    }
+}
+} // namespace
+
+Benchmarks::Benchmarks(Manager& manager)
+    : _manager{manager}, _start{state()} {}
+
+void Benchmarks::run() {
+    shaders();
+    visibility();
+    ssao_resolution();
+    ssao_deinterleaved();
+    ssao_compute();
+    ssao_temporal();
+    ssao_blur();
+    ssao_sampling();
+    ao_methods();
+    sao();
+    cpu_ssao();
+    software();
+    lights();
+    pacing();
+}
+
+bool Benchmarks::check_cpu_ssao() {
+    if (!_manager.has_scene()) {
+        fmt::print(stderr, "cpu ssao check: no scene\n");
+        return false;
+    }
+
+    auto passed = true;
+    with(use_cpu_ssao, [this, &passed] {
+        auto [gbuffer, reference] = cpu_ssao_reference();
+        auto settings = _manager.software_ssao_settings();
+        auto pool = ThreadPool{};
+        for (auto vectorize : {false, true}) {
+            if (vectorize && !cpu_ssao_vectorized()) {
+                continue;
+            }
+            auto occlusion = cpu_bilateral_blur(
+                ::cpu_ssao(gbuffer, settings, pool, vectorize),
+                gbuffer,
+                settings,
+                pool,
+                vectorize);
+            auto rmse = compare_images(occlusion, reference).rmse;
+            auto ok = rmse <= cpu_ssao_max_rmse;
+            fmt::print(
+                "cpu ssao check ({}): rmse {:.5f} against the gpu, at most "
+                "{} {}\n",
+                vectorize ? "avx2" : "scalar",
+                rmse,
+                cpu_ssao_max_rmse,
+                ok ? "passed" : "FAILED");
+            passed = passed && ok;
+        }
+    });
+    return passed;
+}
+
+Benchmarks::State Benchmarks::state() const {
+    return _manager.render_settings();
+}
+
+void Benchmarks::apply(const State& state) {
+    _manager.set_render_settings(state);
+}
+
+void Benchmarks::with(
+    const Override& override,
+    const std::function<void()>& measure) {
+    auto state = _start;
+    state.enable_ssao = true;
+    state.software = false;
+    if (override) {
+        override(state);
+    }
+    apply(state);
+    measure();
+    apply(_start);
+}
+
+double Benchmarks::time_passes(
+    const Override& override,
+    const PassFilter& filter,
+    int warmup,
+    int timed) {
+    auto ms = 0.0;
+    with(override, [&] {
+        ms = total(_manager.time_passes(warmup, timed), filter);
+    });
+    return ms;
+}
+
+std::vector<float>
+Benchmarks::capture_occlusion(const Override& override, int converge) {
+    auto occlusion = std::vector<float>{};
+    with(override, [&] {
+        if (converge > 0) {
+            _manager.time_passes(converge, 0);
+        }
+        occlusion = _manager.capture_occlusion();
+    });
+    return occlusion;
+}
+
+std::vector<float>
+Benchmarks::converged_occlusion(const Override& override, int seeds) {
+    auto average = std::vector<float>{};
+    for (auto k = 0; k < seeds; k++) {
+        auto occlusion = capture_occlusion([&override, this, k](State& state) {
+            override(state);
+            state.ssao.noise = NoisePattern::White;
+            state.ssao.seed = _start.ssao.seed + static_cast<unsigned>(k) + 1;
+        });
+        average.resize(occlusion.size());
+        for (auto i = size_t{0}; i < occlusion.size(); i++) {
+            average[i] += occlusion[i] / static_cast<float>(seeds);
+        }
+    }
+    return average;
+}
+
+std::pair<CpuGBuffer, std::vector<float>> Benchmarks::cpu_ssao_reference() {
+    auto gbuffer = _manager.capture_gbuffer();
+    auto reference = _manager.capture_occlusion();
+
+    // The gpu pass does not skip the background, so leave it out of the
+    // error.
+    for (auto i = size_t{0}; i < reference.size(); i++) {
+        if (gbuffer.depth[i] >= 1.0F) {
+            reference[i] = 1.0F;
+        }
+    }
+    return {std::move(gbuffer), std::move(reference)};
+}
+
+void Benchmarks::shaders() {
+    constexpr auto timed = 100;
+
+    struct Case {
+        bool specialize;
+        bool enable_ssao;
+        int sample_count;
+    };
+    constexpr auto cases = std::array{
+        Case{false, true, 16},
+        Case{true, true, 16},
+        Case{false, true, 32},
+        Case{true, true, 32},
+        Case{false, true, 64},
+        Case{true, true, 64},
+        Case{false, false, 64},
+        Case{true, false, 64}};
+
+    auto table = Table{
+        {{"variant", 12},
+         {"samples", 8},
+         {"ssao", 5},
+         {"gpu ms", 10, "{:.3f}"}}};
+    for (const auto& c : cases) {
+        auto ms = time_passes(
+            [&c](State& state) {
+                state.specialize_shaders = c.specialize;
+                state.enable_ssao = c.enable_ssao;
+                state.ssao.sample_count = c.sample_count;
+            },
+            all_passes,
+            warmup_frames,
+            timed);
+        table.row(
+            c.specialize ? "specialized" : "uniform",
+            c.sample_count,
+            c.enable_ssao ? "on" : "off",
+            ms);
+    }
+}
+
+void Benchmarks::visibility() {
+    constexpr auto timed = 100;
+
+    auto& m = _manager;
+    if (!m.bindless() || !m.has_scene()) {
+        fmt::print("visibility buffer: no bindless textures or scene\n");
+        return;
+    }
+
+    // Bytes written to render targets per sample: normal, diffuse, and depth
+    // by the geometry pass; id and depth by the visibility pass; normal and
+    // diffuse by the resolve pass. Texture and vertex reads are not counted.
+    constexpr auto geometry_bytes = 12.0;
+    constexpr auto visibility_bytes = 8.0;
+    constexpr auto resolve_bytes = 8.0;
+
+    m.count_samples(true);
+
+    auto table = Table{
+        {{"g-buffer", 10},
+         {"gpu ms", 8, "{:.3f}"},
+         {"rasterized", 12, "{:.0f}"},
+         {"shaded", 12, "{:.0f}"},
+         {"writes MiB", 11, "{:.1f}"},
+         {"peak MiB", 9, "{:.1f}"}}};
+    for (auto visibility : {false, true}) {
+        // The scene and camera are still, so the last frame's sample counts
+        // stand for every frame.
+        auto ms = 0.0;
+        auto samples = std::array<GLuint64, 2>{};
+        auto override = [visibility](State& state) {
+            state.visibility_buffer = visibility;
+        };
+        with(override, [&] {
+            ms = total(m.time_passes(warmup_frames, timed), all_passes);
+            samples = m.sample_counts();
+        });
+        auto rasterized = static_cast<double>(samples[0]);
+        auto shaded = static_cast<double>(samples[1]);
+        auto writes = visibility ? rasterized * visibility_bytes +
+                                       shaded * resolve_bytes
+                                 : rasterized * geometry_bytes;
+        table.row(
+            visibility ? "visibility" : "direct",
+            ms,
+            rasterized,
+            shaded,
+            writes / mib,
+            static_cast<double>(m.graph_stats().peak_bytes) / mib);
+    }
+
+    m.count_samples(false);
+}
+
+void Benchmarks::ssao_resolution() {
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto divided = [](int divisor) {
+        return [divisor](State& state) {
+            state.ssao.resolution_divisor = divisor;
+            state.ssao.temporal = false;
+        };
+    };
+    auto reference = capture_occlusion(divided(1));
+
+    auto table = Table{
+        {{"divisor", 8},
+         {"ssao ms", 8, "{:.3f}"},
+         {"rmse", 9, "{:.5f}"},
+         {"psnr dB", 9, "{:.2f}"},
+         {"max error", 10, "{:.4f}"}}};
+    for (auto divisor : {1, 2, 4}) {
+        auto ms = time_passes(divided(divisor), ssao_passes);
+        auto difference =
+            compare_images(capture_occlusion(divided(divisor)), reference);
+        table.row(
+            divisor,
+            ms,
+            difference.rmse,
+            difference.psnr,
+            difference.max_error);
+    }
+}
+
+void Benchmarks::ssao_deinterleaved() {
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto table = Table{
+        {{"ssao layout", 14},
+         {"radius", 8, "{:.1f}"},
+         {"samples", 8},
+         {"ssao ms", 8, "{:.3f}"}}};
+    for (auto radius_scale : {1.0F, 4.0F}) {
+        for (auto sample_count : {16, 64}) {
+            for (auto deinterleaved : {false, true}) {
+                auto ms = time_passes(
+                    [=](State& state) {
+                        state.ssao.radius *= radius_scale;
+                        state.ssao.sample_count = sample_count;
+                        state.ssao.deinterleaved = deinterleaved;
+                        state.ssao.compute = false;
+                        state.ssao.temporal = false;
+                    },
+                    ssao_passes);
+                table.row(
+                    deinterleaved ? "deinterleaved" : "interleaved",
+                    _start.ssao.radius * radius_scale,
+                    sample_count,
+                    ms);
+            }
+        }
+    }
+}
+
+void Benchmarks::ssao_compute() {
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto table = Table{
+        {{"ssao shader", 14},
+         {"radius", 8, "{:.1f}"},
+         {"samples", 8},
+         {"ssao ms", 8, "{:.3f}"}}};
+    for (auto radius_scale : {1.0F, 4.0F}) {
+        for (auto sample_count : {16, 64}) {
+            for (auto tile_size : {0, 8, 16, 32}) {
+                auto ms = time_passes(
+                    [=](State& state) {
+                        state.ssao.method = AoMethod::Hemisphere;
+                        state.ssao.deinterleaved = false;
+                        state.ssao.temporal = false;
+                        state.ssao.radius *= radius_scale;
+                        state.ssao.sample_count = sample_count;
+                        state.ssao.compute = tile_size > 0;
+                        state.ssao.tile_size = tile_size;
+                    },
+                    ssao_pass);
+                table.row(
+                    tile_size > 0 ? fmt::format("compute {0}x{0}", tile_size)
+                                  : std::string{"fragment"},
+                    _start.ssao.radius * radius_scale,
+                    sample_count,
+                    ms);
+            }
+        }
+    }
+}
+
+void Benchmarks::ssao_temporal() {
+    constexpr auto converge_frames = 60;
+
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto temporal = [](int sample_count) {
+        return [sample_count](State& state) {
+            state.ssao.method = AoMethod::Hemisphere;
+            state.ssao.temporal = sample_count > 0;
+            state.ssao.temporal_sample_count = sample_count;
+        };
+    };
+    auto reference = capture_occlusion(temporal(0));
+
+    auto table = Table{
+        {{"ssao", 10},
+         {"samples", 8},
+         {"ssao ms", 8, "{:.3f}"},
+         {"rmse", 9, "{:.5f}"},
+         {"psnr dB", 9, "{:.2f}"},
+         {"max error", 10, "{:.4f}"}}};
+    for (auto sample_count : {0, 8, 16}) {
+        // The capture continues from the frames that converged the history.
+        auto ms = 0.0;
+        auto occlusion = std::vector<float>{};
+        with(temporal(sample_count), [&] {
+            auto timings = _manager.time_passes(converge_frames, timed_frames);
+            ms = total(timings, ssao_passes);
+            occlusion = _manager.capture_occlusion();
+        });
+        auto difference = compare_images(occlusion, reference);
+        table.row(
+            sample_count > 0 ? "temporal" : "full",
+            sample_count > 0 ? sample_count : _start.ssao.sample_count,
+            ms,
+            difference.rmse,
+            difference.psnr,
+            difference.max_error);
+    }
+}
+
+void Benchmarks::ssao_blur() {
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto table = Table{
+        {{"blur", 14},
+         {"radius", 8},
+         {"fetches", 8, "{:.1f}"},
+         {"blur ms", 8, "{:.3f}"}}};
+    for (auto blur :
+         {BlurMethod::Box,
+          BlurMethod::Bilateral,
+          BlurMethod::BilateralCompute}) {
+        for (auto radius : {2, 4, 8}) {
+            if (blur == BlurMethod::Box && radius != 2) {
+                continue;
+            }
+            auto ms = time_passes(
+                [=](State& state) {
+                    state.ssao.blur = blur;
+                    state.ssao.blur_radius = radius;
+                },
+                blur_passes);
+            table.row(
+                blur_name(blur),
+                blur == BlurMethod::Box ? std::string{"-"}
+                                        : fmt::format("{}", radius),
+                blur_fetches(blur, radius),
+                ms);
+        }
+    }
+}
+
+void Benchmarks::ssao_sampling() {
+    constexpr auto reference_kernels = 64;
+
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    // Average many independently seeded random kernels as the reference, so
+    // that it favours no pattern. The classic kernel places its samples
+    // differently, so it converges elsewhere, and its own converged result
+    // separates its noise from that bias.
+    auto converged = [this](KernelPattern kernel) {
+        return converged_occlusion(
+            [kernel](State& state) {
+                state.ssao.method = AoMethod::Hemisphere;
+                state.ssao.temporal = false;
+                state.ssao.kernel = kernel;
+                state.ssao.sample_count = max_sample_count;
+            },
+            reference_kernels);
+    };
+    auto reference = converged(KernelPattern::Random);
+    auto classic_reference = converged(KernelPattern::Classic);
+
+    struct Config {
+        KernelPattern kernel;
+        NoisePattern noise;
+        int sample_count;
+    };
+    constexpr auto configs = std::array{
+        Config{KernelPattern::Classic, NoisePattern::White, 64},
+        Config{KernelPattern::Random, NoisePattern::White, 16},
+        Config{KernelPattern::Random, NoisePattern::Blue, 16},
+        Config{KernelPattern::Hammersley, NoisePattern::Blue, 16},
+        Config{KernelPattern::Halton, NoisePattern::Blue, 16},
+        Config{KernelPattern::PoissonDisk, NoisePattern::Blue, 16},
+        Config{KernelPattern::Hammersley, NoisePattern::Blue, 32},
+    };
+    auto table = Table{
+        {{"kernel", 11},
+         {"noise", 6},
+         {"samples", 8},
+         {"rmse", 9, "{:.5f}"},
+         {"psnr dB", 9, "{:.2f}"},
+         {"max error", 10, "{:.4f}"},
+         {"own rmse", 9, "{:.5f}"}}};
+    for (const auto& c : configs) {
+        auto occlusion = capture_occlusion([&c](State& state) {
+            state.ssao.method = AoMethod::Hemisphere;
+            state.ssao.temporal = false;
+            state.ssao.kernel = c.kernel;
+            state.ssao.noise = c.noise;
+            state.ssao.sample_count = c.sample_count;
+        });
+        auto difference = compare_images(occlusion, reference);
+        auto own = compare_images(
+            occlusion,
+            c.kernel == KernelPattern::Classic ? classic_reference
+                                               : reference);
+        table.row(
+            kernel_name(c.kernel),
+            c.noise == NoisePattern::Blue ? "blue" : "white",
+            c.sample_count,
+            difference.rmse,
+            difference.psnr,
+            difference.max_error,
+            own.rmse);
+    }
+}
+
+void Benchmarks::ao_methods() {
+    constexpr auto reference_seeds = 16;
+
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    struct Case {
+        AoMethod method;
+        int quality; // samples, directions, or slices
+        int steps;
+    };
+    constexpr auto cases = std::array{
+        Case{AoMethod::Hemisphere, 16, 0},
+        Case{AoMethod::Hemisphere, 64, 0},
+        Case{AoMethod::Hbao, 4, 4},
+        Case{AoMethod::Hbao, 8, 6},
+        Case{AoMethod::Gtao, 2, 6},
+        Case{AoMethod::Gtao, 4, 8},
+        Case{AoMethod::Sao, 16, 0},
+        Case{AoMethod::Sao, 32, 0}};
+    constexpr auto methods = std::array{
+        AoMethod::Hemisphere,
+        AoMethod::Hbao,
+        AoMethod::Gtao,
+        AoMethod::Sao};
+
+    // Every method is compared to converged gtao, the closest to ground
+    // truth, and to its own converged result, which shows how far it is from
+    // converging. Converged is the highest quality averaged over seeds.
+    constexpr auto reference_method = AoMethod::Gtao;
+    auto converged = [](AoMethod method) {
+        switch (method) {
+        case AoMethod::Hbao:
+        case AoMethod::Gtao:
+            return Case{method, 16, 32};
+        default:
+            return Case{method, max_sample_count, 0};
+        }
+    };
+
+    auto settings = [](const Case& c) {
+        return [c](State& state) {
+            state.ssao.method = c.method;
+            state.ssao.resolution_divisor = 1;
+            state.ssao.deinterleaved = false;
+            state.ssao.compute = false;
+            state.ssao.temporal = false;
+            state.ssao.sample_count = c.quality;
+            state.ssao.directions = c.quality;
+            state.ssao.slices = c.quality;
+            state.ssao.steps = c.steps;
+        };
+    };
+    auto references = std::map<AoMethod, std::vector<float>>{};
+    for (auto method : methods) {
+        auto reference = settings(converged(method));
+        references[method] = converged_occlusion(
+            [&reference](State& state) {
+                reference(state);
+                state.ssao.kernel = KernelPattern::Random;
+            },
+            reference_seeds);
+    }
+
+    auto table = Table{
+        {{"method", 11},
+         {"quality", 8},
+         {"steps", 6},
+         {"ssao ms", 8, "{:.3f}"},
+         {"rmse", 9, "{:.5f}"},
+         {"psnr dB", 9, "{:.2f}"},
+         {"own rmse", 9, "{:.5f}"}}};
+    for (const auto& c : cases) {
+        auto ms = time_passes(settings(c), ssao_passes);
+        auto occlusion = capture_occlusion(settings(c));
+        auto error = compare_images(occlusion, references[reference_method]);
+        auto own = compare_images(occlusion, references[c.method]);
+        table.row(
+            method_name(c.method),
+            c.quality,
+            c.steps,
+            ms,
+            error.rmse,
+            error.psnr,
+            own.rmse);
+    }
+}
+
+void Benchmarks::sao() {
+    constexpr auto sample_count = 16;
+
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    struct Config {
+        const char* name;
+        AoMethod method;
+        bool pyramid;
+    };
+    constexpr auto configs = std::array{
+        Config{"hemisphere ms", AoMethod::Hemisphere, false},
+        Config{"sao level 0 ms", AoMethod::Sao, false},
+        Config{"sao pyramid ms", AoMethod::Sao, true},
+    };
+    auto columns = std::vector<Column>{{"radius", 8}};
+    for (const auto& c : configs) {
+        columns.emplace_back(Column{c.name, 14});
+    }
+    auto table = Table{columns};
+    for (auto radius_scale : {0.5F, 1.0F, 2.0F, 4.0F, 8.0F}) {
+        auto cells = std::vector<std::string>{
+            fmt::format("{:.1f}", _start.ssao.radius * radius_scale)};
+        for (const auto& c : configs) {
+            auto ms = time_passes(
+                [&c, radius_scale](State& state) {
+                    state.ssao.method = c.method;
+                    state.ssao.sao_pyramid = c.pyramid;
+                    state.ssao.deinterleaved = false;
+                    state.ssao.compute = false;
+                    state.ssao.temporal = false;
+                    state.ssao.sample_count = sample_count;
+                    state.ssao.radius *= radius_scale;
+                },
+                [](std::string_view name) {
+                    return name == "ssao" || name == "ssao_pyramid";
+                });
+            cells.emplace_back(fmt::format("{:.3f}", ms));
+        }
+        table.print(cells);
+    }
+}
+
+void Benchmarks::cpu_ssao() {
+    constexpr auto cpu_runs = 3;
+
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    // Time the gpu passes that the cpu ssao reproduces, and capture their
+    // inputs and output.
+    auto ssao_ms = 0.0;
+    auto blur_ms = 0.0;
+    auto gbuffer = CpuGBuffer{};
+    auto reference = std::vector<float>{};
+    auto settings = std::optional<CpuSsaoSettings>{};
+    with(use_cpu_ssao, [&] {
+        auto timings = _manager.time_passes(warmup_frames, timed_frames);
+        ssao_ms = total(timings, ssao_pass);
+        blur_ms = total(timings, blur_passes);
+        std::tie(gbuffer, reference) = cpu_ssao_reference();
+        settings = _manager.software_ssao_settings();
+    });
+    auto megapixels = static_cast<double>(reference.size()) / 1.0e6;
+
+    auto table = Table{
+        {{"ssao", 6},
+         {"avx2", 7},
+         {"threads", 7},
+         {"ssao Mpx/s", 10, "{:.1f}"},
+         {"blur Mpx/s", 10, "{:.1f}"},
+         {"rmse", 9, "{:.5f}"},
+         {"psnr dB", 9, "{:.2f}"}}};
+    table.row(
+        "gpu",
+        "-",
+        "-",
+        megapixels / ssao_ms * 1.0e3,
+        megapixels / blur_ms * 1.0e3,
+        "-",
+        "-");
+    auto single = ThreadPool{1};
+    auto pool = ThreadPool{};
+    for (auto* threads : {&single, &pool}) {
+        if (threads == &pool && pool.size() == 1) {
+            continue;
+        }
+        for (auto vectorize : {false, true}) {
+            if (vectorize && !cpu_ssao_vectorized()) {
+                continue;
+            }
+            auto occlusion = std::vector<float>{};
+            auto blurred = std::vector<float>{};
+            auto cpu_ssao_ms = 0.0;
+            auto cpu_blur_ms = 0.0;
+            for (auto run = 0; run < cpu_runs; run++) {
+                auto start = std::chrono::steady_clock::now();
+                occlusion =
+                    ::cpu_ssao(gbuffer, *settings, *threads, vectorize);
+                auto middle = std::chrono::steady_clock::now();
+                blurred = cpu_bilateral_blur(
+                    occlusion,
+                    gbuffer,
+                    *settings,
+                    *threads,
+                    vectorize);
+                auto end = std::chrono::steady_clock::now();
+                cpu_ssao_ms += std::chrono::duration<double, std::milli>{
+                    middle - start}.count() / cpu_runs;
+                cpu_blur_ms += std::chrono::duration<double, std::milli>{
+                    end - middle}.count() / cpu_runs;
+            }
+            auto difference = compare_images(blurred, reference);
+            table.row(
+                "cpu",
+                vectorize ? "yes" : "no",
+                threads->size(),
+                megapixels / cpu_ssao_ms * 1.0e3,
+                megapixels / cpu_blur_ms * 1.0e3,
+                difference.rmse,
+                difference.psnr);
+        }
+    }
+}
+
+void Benchmarks::software() {
+    constexpr auto runs = 5;
+
+    auto& m = _manager;
+    if (!m.has_scene()) {
+        return;
+    }
+
+    auto table = Table{
+        {{"software", 8},
+         {"threads", 7},
+         {"frame ms", 9, "{:.2f}"},
+         {"speedup", 8, "{:.2f}"}}};
+    auto pixels = std::vector<glm::u8vec4>{};
+    with({}, [&] {
+        // Render a frame on the gpu first so that the projection and kernel
+        // are current, and load the host scene outside of the timings.
+        m.render();
+        m.host_scene();
+
+        auto hardware =
+            size_t{std::max(std::thread::hardware_concurrency(), 1U)};
+        auto single_ms = 0.0;
+        for (auto threads = size_t{1};;
+             threads = std::min(threads * 2, hardware)) {
+            auto pool = ThreadPool{threads};
+            m.render_software(pool);
+            auto start = std::chrono::steady_clock::now();
+            for (auto run = 0; run < runs; run++) {
+                pixels = m.render_software(pool);
+            }
+            auto end = std::chrono::steady_clock::now();
+            auto frame_ms =
+                std::chrono::duration<double, std::milli>{end - start}
+                    .count() /
+                runs;
+            if (threads == 1) {
+                single_ms = frame_ms;
+            }
+            table.row("cpu", threads, frame_ms, single_ms / frame_ms);
+            if (threads == hardware) {
+                break;
+            }
+        }
+    });
+
+    constexpr auto path = "software.ppm";
+    if (write_ppm(path, m.render_size().x, m.render_size().y, pixels)) {
+        fmt::print("wrote the software frame to {}\n", path);
+    }
+}
+
+void Benchmarks::lights() {
+    if (!_manager.has_scene()) {
+        return;
+    }
+
+    auto table = std::optional<Table>{};
+    for (auto count : {10, 100, 1000, 10000}) {
+        auto timings = std::vector<std::pair<std::string, double>>{};
+        auto override = [count](State& state) {
+            state.light_count = static_cast<size_t>(count);
+        };
+        with(override, [&] {
+            timings = _manager.time_passes(warmup_frames, timed_frames);
+        });
+
+        if (!table) {
+            auto columns = std::vector<Column>{{"lights", 8}};
+            for (const auto& [name, ms] : timings) {
+                columns.emplace_back(Column{name, 11});
+            }
+            columns.emplace_back(Column{"total ms", 11});
+            table.emplace(std::move(columns));
+        }
+        auto cells = std::vector<std::string>{fmt::format("{}", count)};
+        for (const auto& [name, ms] : timings) {
+            cells.emplace_back(fmt::format("{:.3f}", ms));
+        }
+        cells.emplace_back(fmt::format("{:.3f}", total(timings, all_passes)));
+        table->print(cells);
+    }
+}
+
+void Benchmarks::pacing() {
+    constexpr auto warmup = 30;
+    constexpr auto timed = 300;
+
+    auto& m = _manager;
+    auto table = Table{
+        {{"in flight", 10},
+         {"low latency", 11},
+         {"frame ms", 10, "{:.3f}"},
+         {"latency ms", 12, "{:.3f}"}}};
+    with({}, [&] {
+        for (auto frames_in_flight : {1, 2, 3}) {
+            for (auto low_latency : {false, true}) {
+                auto pacing = m.pacing();
+                pacing.frames_in_flight = frames_in_flight;
+                pacing.low_latency = low_latency;
+                const auto& pacer = m.pace_frames(pacing, warmup, timed);
+                table.row(
+                    frames_in_flight,
+                    low_latency ? "on" : "off",
+                    pacer.frame_ms(),
+                    pacer.latency_ms());
+            }
+        }
+    });
+}
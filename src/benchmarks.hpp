@@ -0,0 +1,133 @@
+#pragma once
+
+#include "manager.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Benchmarks measure the rendering pipeline of the manager between frames,
+// and print the results as tables. Each measurement overrides part of the
+// state that the benchmarks started from, with ssao on and the gpu pipeline,
+// and restores that state afterwards.
+class Benchmarks {
+  public:
+    // The State is the part of the manager that measurements override.
+    using State = RenderSettings;
+
+    // An Override changes the starting state for a measurement.
+    using Override = std::function<void(State&)>;
+
+    // A PassFilter selects the passes whose gpu times are added up.
+    using PassFilter = std::function<bool(std::string_view)>;
+
+    // Start from the current state of a manager.
+    explicit Benchmarks(Manager&);
+
+    // Disallow copies and moves.
+    Benchmarks(const Benchmarks&) = delete;
+    Benchmarks(Benchmarks&&) = delete;
+    Benchmarks& operator=(const Benchmarks&) = delete;
+    Benchmarks& operator=(Benchmarks&&) = delete;
+    ~Benchmarks() = default;
+
+    // Run and print all benchmarks.
+    void run();
+
+    // Compare the cpu ssao and blur, with and without avx2, to the gpu
+    // passes on the current frame, and get whether their error is small.
+    bool check_cpu_ssao();
+
+  private:
+    static constexpr auto warmup_frames = 10; // frames before timing
+    static constexpr auto timed_frames = 50; // frames averaged
+
+    Manager& _manager;
+    State _start; // state when the benchmarks were created
+
+    // Get or set the state of the manager.
+    [[nodiscard]] State state() const;
+    void apply(const State&);
+
+    // Run a measurement with the starting state changed by an override (none
+    // if empty), then restore the starting state.
+    void with(const Override&, const std::function<void()>& measure);
+
+    // Render frames with an override, and get the sum of the average gpu
+    // times of the passes that match a filter.
+    double time_passes(
+        const Override&,
+        const PassFilter&,
+        int warmup = warmup_frames,
+        int timed = timed_frames);
+
+    // Render frames with an override, and read back the occlusion of the
+    // last one.
+    std::vector<float> capture_occlusion(const Override&, int converge = 0);
+
+    // Render frames with an override and each of several seeds of the kernel
+    // and white-noise rotations, and get their average occlusion.
+    std::vector<float> converged_occlusion(const Override&, int seeds);
+
+    // Read back the g-buffer and the blurred occlusion of a frame rendered
+    // with the settings that the cpu ssao reproduces, with the occlusion set
+    // to 1 on the background that the cpu ssao skips. Call within with().
+    std::pair<CpuGBuffer, std::vector<float>> cpu_ssao_reference();
+
+    // Time the rendering pipeline with uniform-driven and specialized shader
+    // variants.
+    void shaders();
+
+    // Time the rendering pipeline with the g-buffer filled directly and from
+    // a visibility buffer, and estimate the render target writes.
+    void visibility();
+
+    // Time the ssao passes at each resolution divisor, and measure the error
+    // against full resolution.
+    void ssao_resolution();
+
+    // Time the ssao passes with and without deinterleaving at several radii
+    // and sample counts.
+    void ssao_deinterleaved();
+
+    // Time the hemisphere ssao pass as a fragment shader and as a compute
+    // shader with several tile sizes.
+    void ssao_compute();
+
+    // Time temporal ssao with a few per-frame sample counts, and measure the
+    // converged error against full-kernel ssao.
+    void ssao_temporal();
+
+    // Time each blur method at a few radii, and count its texture fetches
+    // per pixel.
+    void ssao_blur();
+
+    // Measure the error of each kernel and noise pattern against the average
+    // of many random kernels.
+    void ssao_sampling();
+
+    // Time each ambient occlusion method at a few quality levels, and
+    // measure the error against converged gtao and against the same method
+    // converged.
+    void ao_methods();
+
+    // Time sao with and without its depth pyramid, and hemisphere ssao, over
+    // a sweep of radii.
+    void sao();
+
+    // Time the cpu ssao and blur with and without avx2 and threads, and
+    // measure their error against the gpu passes.
+    void cpu_ssao();
+
+    // Time the software pipeline with thread counts up to the number of
+    // hardware threads, and write the last frame to an image.
+    void software();
+
+    // Time every pass with light counts from 10 to 10000.
+    void lights();
+
+    // Measure frame time and input latency for each frame pacing mode.
+    void pacing();
+};
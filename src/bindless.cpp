@@ -0,0 +1,57 @@
+#include "bindless.hpp"
+
+#include <string_view>
+
+namespace {
+using GetTextureHandle = GLuint64(APIENTRYP)(GLuint);
+using MakeHandleResident = void(APIENTRYP)(GLuint64);
+
+GetTextureHandle get_texture_handle = nullptr;
+MakeHandleResident make_handle_resident = nullptr;
+MakeHandleResident make_handle_non_resident = nullptr;
+
+// Look up an opengl function by name.
+template <typename F>
+F load(GLADloadproc get_proc_address, const char* name) {
+    return reinterpret_cast<F>(get_proc_address(name));
+}
+
+// Check if the current context supports an extension.
+bool has_extension(std::string_view name) {
+    auto count = GLint{0};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (auto i = GLuint{0}; i < static_cast<GLuint>(count); i++) {
+        const auto* extension = glGetStringi(GL_EXTENSIONS, i);
+        if (name == reinterpret_cast<const char*>(extension)) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+bool load_bindless_textures(GLADloadproc get_proc_address) {
+    if (!has_extension("GL_ARB_bindless_texture")) {
+        return false;
+    }
+    get_texture_handle =
+        load<GetTextureHandle>(get_proc_address, "glGetTextureHandleARB");
+    make_handle_resident = load<MakeHandleResident>(
+        get_proc_address,
+        "glMakeTextureHandleResidentARB");
+    make_handle_non_resident = load<MakeHandleResident>(
+        get_proc_address,
+        "glMakeTextureHandleNonResidentARB");
+    return get_texture_handle != nullptr && make_handle_resident != nullptr &&
+           make_handle_non_resident != nullptr;
+}
+
+GLuint64 resident_texture_handle(GLuint texture) {
+    auto handle = get_texture_handle(texture);
+    make_handle_resident(handle);
+    return handle;
+}
+
+void release_texture_handle(GLuint64 handle) {
+    make_handle_non_resident(handle);
+}
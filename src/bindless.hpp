@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Load the GL_ARB_bindless_texture entry points, which the generated loader
+// does not include, through the function lookup of the context. Returns
+// false when the driver lacks the extension.
+bool load_bindless_textures(GLADloadproc get_proc_address);
+
+// Get a handle that shaders can sample a texture through. The handle stays
+// resident until it is released, and the texture's state becomes immutable.
+GLuint64 resident_texture_handle(GLuint texture);
+
+// Make a handle from resident_texture_handle non-resident.
+void release_texture_handle(GLuint64 handle);
@@ -10,6 +10,12 @@ Camera::Camera()
       _right_dir{1.0, 0.0, 0.0}, _pitch{0.0F}, _yaw{-90.0F} {
 }
 
+Camera::Camera(glm::vec3 position, float pitch, float yaw)
+    : _position{position}, _pitch{std::clamp(pitch, -89.0F, 89.0F)},
+      _yaw{yaw} {
+    _update_directions();
+}
+
 glm::mat4 Camera::transform() const {
     return glm::lookAt(_position, _position + _view_dir, _up_dir);
 }
@@ -18,9 +24,21 @@ glm::vec3 Camera::position() const {
     return _position;
 }
 
+float Camera::pitch() const {
+    return _pitch;
+}
+
+float Camera::yaw() const {
+    return _yaw;
+}
+
 void Camera::rotate(float pitch, float yaw) {
     _pitch = std::clamp(_pitch + pitch, -89.0F, 89.0F);
     _yaw += yaw;
+    _update_directions();
+}
+
+void Camera::_update_directions() {
     auto look = glm::vec3{};
     look.x = std::cos(glm::radians(_yaw)) * std::cos(glm::radians(_pitch));
     look.y = std::sin(glm::radians(_pitch));
@@ -54,3 +72,12 @@ void Camera::move_right(float delta) {
 void Camera::move_left(float delta) {
     move_right(-delta);
 }
+
+Camera Camera::interpolate(const Camera& from, const Camera& to, float t) {
+    auto camera = Camera{};
+    camera._position = glm::mix(from._position, to._position, t);
+    camera._pitch = glm::mix(from._pitch, to._pitch, t);
+    camera._yaw = glm::mix(from._yaw, to._yaw, t);
+    camera._update_directions();
+    return camera;
+}
@@ -7,12 +7,21 @@ class Camera {
   public:
     Camera();
 
+    // Create a camera at a position with a pitch and yaw in degrees.
+    Camera(glm::vec3 position, float pitch, float yaw);
+
     // Get the matrix that transforms world to view coordinates.
     glm::mat4 transform() const;
 
     // Get the camera position in world coordinates.
     glm::vec3 position() const;
 
+    // Get the camera pitch in degrees.
+    float pitch() const;
+
+    // Get the camera yaw in degrees.
+    float yaw() const;
+
     // Rotate the camera by (pitch, yaw) in degrees.
     void rotate(float, float);
 
@@ -34,6 +43,9 @@ class Camera {
     // Move the camera backwards along the right vector.
     void move_left(float);
 
+    // Get the camera a fraction of the way from one camera to another.
+    static Camera interpolate(const Camera&, const Camera&, float);
+
   private:
     glm::vec3 _position;
     glm::vec3 _view_dir;
@@ -41,4 +53,7 @@ class Camera {
     glm::vec3 _right_dir;
     float _pitch;
     float _yaw;
+
+    // Recompute the direction vectors from the pitch and yaw.
+    void _update_directions();
 };
@@ -0,0 +1,130 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+// Get the tangent of a key as the slope between its neighbors, which keeps
+// the spline smooth when keys are unevenly spaced in time.
+template <typename T>
+T tangent(float t0, T p0, float t1, T p1) {
+    return t1 > t0 ? (p1 - p0) / (t1 - t0) : T{};
+}
+
+// Evaluate the cubic hermite curve between two values with tangents, at a
+// fraction s of an interval of length dt.
+template <typename T>
+T hermite(T p0, T m0, T p1, T m1, float s, float dt) {
+    auto s2 = s * s;
+    auto s3 = s2 * s;
+    return (2.0F * s3 - 3.0F * s2 + 1.0F) * p0 +
+           (s3 - 2.0F * s2 + s) * dt * m0 + (-2.0F * s3 + 3.0F * s2) * p1 +
+           (s3 - s2) * dt * m1;
+}
+} // namespace
+
+void CameraPath::add(float time, const Camera& camera, const Bounds& bounds) {
+    auto extent = glm::max(bounds.max - bounds.min, glm::vec3{1e-6F});
+    auto key = CameraKey{
+        time,
+        (camera.position() - bounds.min) / extent,
+        camera.pitch(),
+        camera.yaw()};
+
+    // Turn the short way from the last key.
+    if (!_keys.empty()) {
+        auto last = _keys.back().yaw;
+        key.yaw = last + std::remainder(key.yaw - last, 360.0F);
+    }
+    _keys.emplace_back(key);
+}
+
+bool CameraPath::empty() const {
+    return _keys.empty();
+}
+
+float CameraPath::duration() const {
+    return _keys.empty() ? 0.0F : _keys.back().time;
+}
+
+Camera CameraPath::camera(float time, const Bounds& bounds) const {
+    if (_keys.empty()) {
+        return Camera{};
+    }
+
+    // Find the keys around the time, and their neighbors for the tangents.
+    auto next = std::upper_bound(
+        _keys.begin(),
+        _keys.end(),
+        time,
+        [](float t, const CameraKey& key) { return t < key.time; });
+    auto i1 = std::min(
+        static_cast<size_t>(std::max(next - _keys.begin(), std::ptrdiff_t{1})),
+        _keys.size() - 1);
+    auto i0 = i1 > 0 ? i1 - 1 : 0;
+    const auto& k0 = _keys[i0];
+    const auto& k1 = _keys[i1];
+    const auto& before = _keys[i0 > 0 ? i0 - 1 : i0];
+    const auto& after = _keys[std::min(i1 + 1, _keys.size() - 1)];
+
+    auto dt = k1.time - k0.time;
+    auto s = dt > 0.0F ? std::clamp((time - k0.time) / dt, 0.0F, 1.0F) : 0.0F;
+    auto pose = [&](auto field) {
+        auto m0 = tangent(before.time, field(before), k1.time, field(k1));
+        auto m1 = tangent(k0.time, field(k0), after.time, field(after));
+        return hermite(field(k0), m0, field(k1), m1, s, dt);
+    };
+    auto position = pose([](const CameraKey& k) { return k.position; });
+    auto pitch = pose([](const CameraKey& k) { return k.pitch; });
+    auto yaw = pose([](const CameraKey& k) { return k.yaw; });
+    return Camera{
+        bounds.min + position * (bounds.max - bounds.min),
+        pitch,
+        yaw};
+}
+
+bool CameraPath::save(const std::filesystem::path& path) const {
+    auto file = std::ofstream{path};
+    file << "# time (s), position in the scene bounds (x y z), pitch and "
+            "yaw (degrees)\n";
+    for (const auto& key : _keys) {
+        file << key.time << ' ' << key.position.x << ' ' << key.position.y
+             << ' ' << key.position.z << ' ' << key.pitch << ' ' << key.yaw
+             << '\n';
+    }
+    return file.good();
+}
+
+std::optional<CameraPath> CameraPath::load(const std::filesystem::path& path) {
+    auto file = std::ifstream{path};
+    if (!file) {
+        return std::nullopt;
+    }
+
+    auto camera_path = CameraPath{};
+    auto line = std::string{};
+    while (std::getline(file, line)) {
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        auto stream = std::istringstream{line};
+        auto key = CameraKey{};
+        stream >> key.time >> key.position.x >> key.position.y >>
+            key.position.z >> key.pitch >> key.yaw;
+        if (!stream ||
+            (!camera_path._keys.empty() &&
+             key.time < camera_path._keys.back().time)) {
+            return std::nullopt;
+        }
+        camera_path._keys.emplace_back(key);
+    }
+    if (camera_path._keys.empty()) {
+        return std::nullopt;
+    }
+    return camera_path;
+}
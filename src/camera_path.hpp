@@ -0,0 +1,48 @@
+#pragma once
+
+#include "camera.hpp"
+#include "mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// A CameraKey is a camera pose at some time of a camera path. The position
+// is a fraction of the scene bounds, so that a path fits every export of a
+// scene regardless of its units.
+struct CameraKey {
+    float time; // seconds from the start of the path
+    glm::vec3 position; // in [0, 1] from the minimum to the maximum bounds
+    float pitch; // degrees
+    float yaw; // degrees, unwrapped so that keys turn the short way
+};
+
+// A CameraPath is a sequence of camera keys, played back with a spline
+// through every key. Paths are stored as text, one key per line.
+class CameraPath {
+  public:
+    // Append the pose of a camera in a scene with some bounds. Keys must be
+    // added in order of time.
+    void add(float time, const Camera&, const Bounds&);
+
+    // Check if the path has no keys.
+    [[nodiscard]] bool empty() const;
+
+    // Get the time of the last key in seconds.
+    [[nodiscard]] float duration() const;
+
+    // Get the camera at some time, clamped to the path, in a scene with
+    // some bounds. The pose follows a catmull-rom spline through the keys.
+    [[nodiscard]] Camera camera(float time, const Bounds&) const;
+
+    // Write the path to a file, and get whether it succeeded.
+    bool save(const std::filesystem::path&) const;
+
+    // Read a path from a file, or get nothing if it is invalid.
+    static std::optional<CameraPath> load(const std::filesystem::path&);
+
+  private:
+    std::vector<CameraKey> _keys;
+};
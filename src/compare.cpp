@@ -0,0 +1,191 @@
+#include "image_metrics.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto default_region_size = 32; // width of the heatmap regions
+constexpr auto worst_regions = 5; // number of regions to list
+constexpr auto usage_error = 2; // exit code of invalid arguments
+
+void print_usage() {
+    fmt::print(
+        stderr,
+        "usage: compare REFERENCE IMAGE [--min-psnr DB] [--min-ssim S] "
+        "[--max-flip F] [--max-region-flip F] [--region-size N] [--ppd N] "
+        "[--heatmap FILE.ppm] [--region-heatmap FILE.ppm]\n");
+}
+
+// Parse a number, or get nothing if the text is not one.
+std::optional<double> parse_number(const char* text) {
+    char* end = nullptr;
+    auto value = std::strtod(text, &end);
+    if (end == text || *end != '\0') {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Write a heatmap of values in [0, 1] to a ppm file, and report it.
+void write_heatmap(
+    const char* path,
+    int width,
+    int height,
+    std::span<const float> values) {
+    if (write_ppm(path, width, height, heatmap(values))) {
+        fmt::print("wrote {}\n", path);
+    } else {
+        fmt::print(stderr, "could not write {}\n", path);
+    }
+}
+} // namespace
+
+/*
+ * IMAGE COMPARISON
+ *
+ * Usage:
+ *  ./compare REFERENCE IMAGE [OPTIONS]
+ *
+ *  Compares a rendered frame to a reference frame of the same size with
+ *  PSNR, SSIM and the LDR-FLIP perceptual difference, and lists the worst
+ *  regions by their lower-left corner, counted from the bottom. Exits with
+ *  1 when a threshold is not met, so that performance modes can be gated on
+ *  quality in automated runs.
+ *
+ * Options:
+ *  --min-psnr DB: Fail below a peak signal-to-noise ratio
+ *  --min-ssim S: Fail below a mean structural similarity
+ *  --max-flip F: Fail above a mean perceptual difference
+ *  --max-region-flip F: Fail above the perceptual difference of a region
+ *  --region-size N: Width of the regions in pixels (32)
+ *  --ppd N: Pixels per degree of the viewing setup (67)
+ *  --heatmap FILE.ppm: Write the perceptual difference of each pixel
+ *  --region-heatmap FILE.ppm: Write the perceptual difference of regions
+ */
+int main(int argc, char* argv[]) {
+    auto args = std::span(argv + 1, static_cast<size_t>(argc - 1));
+    auto paths = std::vector<const char*>{};
+    auto thresholds = QualityThresholds{};
+    auto region_size = default_region_size;
+    auto pixels_per_degree = default_pixels_per_degree;
+    const char* heatmap_path = nullptr;
+    const char* region_heatmap_path = nullptr;
+    for (auto i = size_t{0}; i < args.size(); i++) {
+        auto arg = std::string_view{args[i]};
+        if (!arg.starts_with("--")) {
+            paths.emplace_back(args[i]);
+            continue;
+        }
+        if (i + 1 == args.size()) {
+            print_usage();
+            return usage_error;
+        }
+        const auto* value = args[++i];
+        if (arg == "--heatmap") {
+            heatmap_path = value;
+            continue;
+        }
+        if (arg == "--region-heatmap") {
+            region_heatmap_path = value;
+            continue;
+        }
+        auto number = parse_number(value);
+        if (!number) {
+            print_usage();
+            return usage_error;
+        }
+        if (arg == "--min-psnr") {
+            thresholds.min_psnr = *number;
+        } else if (arg == "--min-ssim") {
+            thresholds.min_ssim = *number;
+        } else if (arg == "--max-flip") {
+            thresholds.max_flip = *number;
+        } else if (arg == "--max-region-flip") {
+            thresholds.max_region_flip = *number;
+        } else if (arg == "--region-size" && *number >= 1.0) {
+            region_size = static_cast<int>(*number);
+        } else if (arg == "--ppd" && *number > 0.0) {
+            pixels_per_degree = static_cast<float>(*number);
+        } else {
+            print_usage();
+            return usage_error;
+        }
+    }
+    if (paths.size() != 2) {
+        print_usage();
+        return usage_error;
+    }
+
+    auto reference = read_image(paths[0]);
+    auto image = read_image(paths[1]);
+    if (!reference || !image) {
+        fmt::print(stderr, "could not read {}\n", paths[!reference ? 0 : 1]);
+        return usage_error;
+    }
+    if (image->width != reference->width ||
+        image->height != reference->height) {
+        fmt::print(
+            stderr,
+            "image is {}x{} but the reference is {}x{}\n",
+            image->width,
+            image->height,
+            reference->width,
+            reference->height);
+        return usage_error;
+    }
+
+    auto width = image->width;
+    auto height = image->height;
+    auto quality = measure_quality(*image, *reference, pixels_per_degree);
+    auto regions = region_scores(quality, width, height, region_size);
+    fmt::print(
+        "psnr {:.2f} dB, ssim {:.4f}, flip {:.4f}\n",
+        quality.psnr,
+        quality.ssim,
+        quality.flip);
+
+    auto worst = regions;
+    std::sort(worst.begin(), worst.end(), [](const auto& a, const auto& b) {
+        return a.flip > b.flip;
+    });
+    worst.resize(std::min(worst.size(), size_t{worst_regions}));
+    fmt::print("{:>6} {:>6} {:>8} {:>8}\n", "x", "y", "ssim", "flip");
+    for (const auto& region : worst) {
+        fmt::print(
+            "{:>6} {:>6} {:>8.4f} {:>8.4f}\n",
+            region.x * region_size,
+            region.y * region_size,
+            region.ssim,
+            region.flip);
+    }
+
+    if (heatmap_path != nullptr) {
+        write_heatmap(heatmap_path, width, height, quality.flip_map);
+    }
+    if (region_heatmap_path != nullptr) {
+        auto columns = (width + region_size - 1) / region_size;
+        auto values = std::vector<float>(quality.flip_map.size());
+        for (auto y = 0; y < height; y++) {
+            for (auto x = 0; x < width; x++) {
+                auto region = (y / region_size) * columns + x / region_size;
+                values[static_cast<size_t>(y * width + x)] = static_cast<float>(
+                    regions[static_cast<size_t>(region)].flip);
+            }
+        }
+        write_heatmap(region_heatmap_path, width, height, values);
+    }
+
+    auto failures = quality_failures(quality, regions, thresholds);
+    for (const auto& failure : failures) {
+        fmt::print("failed: {}\n", failure);
+    }
+    fmt::print("{}\n", failures.empty() ? "pass" : "fail");
+    return failures.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
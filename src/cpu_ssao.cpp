@@ -0,0 +1,563 @@
+#include "cpu_ssao.hpp"
+#include "sampling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CPU_SSAO_AVX2
+#include <immintrin.h>
+#endif
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+// relative view distance difference at which a tap's weight falls off
+constexpr auto blur_depth_sigma = 0.05F;
+// view distance of background pixels
+constexpr auto background_distance = 1e30F;
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float));
+
+// The Frame is the state shared by every row of one cpu ssao image.
+struct Frame {
+    const CpuGBuffer& gbuffer;
+    const CpuSsaoSettings& settings;
+    glm::mat4 inverse_projection;
+};
+
+// A BlurPass is one direction of the separable blur.
+struct BlurPass {
+    const CpuGBuffer& gbuffer;
+    std::span<const float> occlusion; // input of the pass
+    std::span<const float> distances; // view distance of every pixel
+    std::span<const float> spatial; // weight of each offset from 0 to radius
+    glm::ivec2 direction; // (1, 0) or (0, 1)
+};
+
+// Reconstruct a view-space position from frame coordinates and depth.
+glm::vec3 view_position(glm::vec2 uv, float depth, const glm::mat4& inverse) {
+    auto ndc = glm::vec4{glm::vec3{uv, depth} * 2.0F - 1.0F, 1.0F};
+    auto view = inverse * ndc;
+    return glm::vec3{view} / view.w;
+}
+
+// Get the view-space depth of the surface at some frame coordinates.
+float surface_depth(const Frame& frame, glm::vec2 uv) {
+    const auto& gbuffer = frame.gbuffer;
+    auto size = glm::vec2{gbuffer.width, gbuffer.height};
+    uv = glm::clamp(uv, 0.5F / size, 1.0F - 0.5F / size);
+    auto texel = glm::min(
+        glm::ivec2{uv * size},
+        glm::ivec2{gbuffer.width - 1, gbuffer.height - 1});
+    auto depth = gbuffer.depth[static_cast<size_t>(
+        texel.y * gbuffer.width + texel.x)];
+    return view_position(uv, depth, frame.inverse_projection).z;
+}
+
+// Get the occlusion of one pixel.
+float pixel_occlusion(const Frame& frame, int x, int y) {
+    const auto& gbuffer = frame.gbuffer;
+    const auto& settings = frame.settings;
+    auto index = static_cast<size_t>(y * gbuffer.width + x);
+    auto depth = gbuffer.depth[index];
+    if (depth >= 1.0F) {
+        return 1.0F;
+    }
+    auto size = glm::vec2{gbuffer.width, gbuffer.height};
+    auto uv = (glm::vec2{x, y} + 0.5F) / size;
+    auto frag_pos = view_position(uv, depth, frame.inverse_projection);
+    auto normal = gbuffer.normals[index];
+    auto n = settings.noise_size;
+    auto noise = settings.rotations[static_cast<size_t>(y % n * n + x % n)];
+    auto random = glm::normalize(glm::vec3{noise.x, noise.y, 0.0F});
+    auto tangent = glm::normalize(random - normal * glm::dot(random, normal));
+    auto bitangent = glm::cross(normal, tangent);
+
+    auto occlusion = 0.0F;
+    for (const auto& k : settings.kernel) {
+        auto length = kernel_length(glm::fract(k.w + noise.z));
+        auto sample_pos =
+            frag_pos + (tangent * k.x + bitangent * k.y + normal * k.z) *
+                           length * settings.radius;
+        auto offset = settings.projection * glm::vec4{sample_pos, 1.0F};
+        auto sample_uv = glm::vec2{offset} / offset.w * 0.5F + 0.5F;
+        auto sample_depth = surface_depth(frame, sample_uv);
+        auto boundary = glm::smoothstep(
+            0.0F,
+            1.0F,
+            settings.radius / std::abs(frag_pos.z - sample_depth));
+        auto occluded = sample_depth >= sample_pos.z + settings.bias;
+        occlusion += (occluded ? 1.0F : 0.0F) * boundary;
+    }
+    return 1.0F - occlusion / static_cast<float>(settings.kernel.size());
+}
+
+// Compute the occlusion of a row of pixels, starting at some column.
+void occlusion_row(const Frame& frame, int y, int first, float* out) {
+    for (auto x = first; x < frame.gbuffer.width; x++) {
+        out[x] = pixel_occlusion(frame, x, y);
+    }
+}
+
+// Blur one pixel.
+float pixel_blur(const BlurPass& pass, int x, int y) {
+    const auto& gbuffer = pass.gbuffer;
+    auto width = gbuffer.width;
+    auto index = static_cast<size_t>(y * width + x);
+    auto center = pass.occlusion[index];
+    auto center_distance = pass.distances[index];
+    if (center_distance >= background_distance) {
+        return center;
+    }
+    auto center_normal = gbuffer.normals[index];
+    auto last = glm::ivec2{width - 1, gbuffer.height - 1};
+    auto radius = static_cast<int>(pass.spatial.size()) - 1;
+
+    auto sum = center;
+    auto total = 1.0F;
+    for (auto i = -radius; i <= radius; i++) {
+        if (i == 0) {
+            continue;
+        }
+        auto tap = glm::clamp(
+            glm::ivec2{x, y} + i * pass.direction,
+            glm::ivec2{0},
+            last);
+        auto tap_index = static_cast<size_t>(tap.y * width + tap.x);
+        auto distance = pass.distances[tap_index];
+        auto similarity = std::max(
+            glm::dot(gbuffer.normals[tap_index], center_normal),
+            0.0F);
+        similarity *= similarity;
+        similarity *= similarity;
+        similarity *= similarity;
+        auto weight =
+            pass.spatial[static_cast<size_t>(std::abs(i))] *
+            std::exp(
+                -std::abs(distance - center_distance) /
+                (blur_depth_sigma * center_distance)) *
+            similarity;
+        sum += pass.occlusion[tap_index] * weight;
+        total += weight;
+    }
+    return sum / total;
+}
+
+// Blur a row of pixels, starting at some column.
+void blur_row(const BlurPass& pass, int y, int first, float* out) {
+    for (auto x = first; x < pass.gbuffer.width; x++) {
+        out[x] = pixel_blur(pass, x, y);
+    }
+}
+
+#ifdef CPU_SSAO_AVX2
+#define AVX2 __attribute__((target("avx2")))
+
+constexpr auto lanes = 8; // pixels per vector
+
+// A Vec3x8 holds 8 vectors in structure-of-arrays form.
+struct Vec3x8 {
+    __m256 x;
+    __m256 y;
+    __m256 z;
+};
+
+AVX2 __m256 add(__m256 a, __m256 b) {
+    return _mm256_add_ps(a, b);
+}
+
+AVX2 __m256 sub(__m256 a, __m256 b) {
+    return _mm256_sub_ps(a, b);
+}
+
+AVX2 __m256 mul(__m256 a, __m256 b) {
+    return _mm256_mul_ps(a, b);
+}
+
+AVX2 __m256 splat(float f) {
+    return _mm256_set1_ps(f);
+}
+
+AVX2 __m256 dot(const Vec3x8& a, const Vec3x8& b) {
+    return add(add(mul(a.x, b.x), mul(a.y, b.y)), mul(a.z, b.z));
+}
+
+AVX2 Vec3x8 normalize(const Vec3x8& v) {
+    auto length = _mm256_sqrt_ps(dot(v, v));
+    return {
+        _mm256_div_ps(v.x, length),
+        _mm256_div_ps(v.y, length),
+        _mm256_div_ps(v.z, length)};
+}
+
+// Get row r of a matrix applied to the points (p, 1).
+AVX2 __m256 transform_row(const glm::mat4& m, int r, const Vec3x8& p) {
+    return add(
+        add(mul(splat(m[0][r]), p.x), mul(splat(m[1][r]), p.y)),
+        add(mul(splat(m[2][r]), p.z), splat(m[3][r])));
+}
+
+// Clamp each component to a range.
+AVX2 __m256 clamp(__m256 v, __m256 low, __m256 high) {
+    return _mm256_min_ps(_mm256_max_ps(v, low), high);
+}
+
+// Rotate a kernel sample into the tangent spaces with some bases.
+AVX2 Vec3x8 rotate(
+    const Vec3x8& tangent,
+    const Vec3x8& bitangent,
+    const Vec3x8& normal,
+    glm::vec3 k) {
+    auto kx = splat(k.x);
+    auto ky = splat(k.y);
+    auto kz = splat(k.z);
+    return {
+        add(add(mul(tangent.x, kx), mul(bitangent.x, ky)), mul(normal.x, kz)),
+        add(add(mul(tangent.y, kx), mul(bitangent.y, ky)), mul(normal.y, kz)),
+        add(add(mul(tangent.z, kx), mul(bitangent.z, ky)), mul(normal.z, kz))};
+}
+
+// Gather 8 vectors of an array at some vector indices.
+AVX2 Vec3x8 gather(const glm::vec3* base, __m256i index) {
+    const auto* floats = &base->x;
+    auto offset = _mm256_mullo_epi32(index, _mm256_set1_epi32(3));
+    return {
+        _mm256_i32gather_ps(floats, offset, 4),
+        _mm256_i32gather_ps(floats + 1, offset, 4),
+        _mm256_i32gather_ps(floats + 2, offset, 4)};
+}
+
+// Get e raised to each component, with a degree 5 polynomial on the
+// fraction of the power of 2 (as in the cephes library).
+AVX2 __m256 exp8(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, splat(-87.3F)), splat(88.3F));
+    auto n = _mm256_floor_ps(add(mul(x, splat(1.44269504F)), splat(0.5F)));
+    x = sub(x, mul(n, splat(0.693359375F)));
+    x = sub(x, mul(n, splat(-2.12194440e-4F)));
+    auto p = splat(1.9875691500e-4F);
+    p = add(mul(p, x), splat(1.3981999507e-3F));
+    p = add(mul(p, x), splat(8.3334519073e-3F));
+    p = add(mul(p, x), splat(4.1665795894e-2F));
+    p = add(mul(p, x), splat(1.6666665459e-1F));
+    p = add(mul(p, x), splat(5.0000001201e-1F));
+    p = add(add(mul(mul(p, x), x), x), splat(1.0F));
+    auto exponent =
+        _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127));
+    return mul(p, _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23)));
+}
+
+// Compute the occlusion of a row of pixels, 8 at a time, and get the first
+// column left for the scalar code.
+AVX2 int occlusion_row_avx2(const Frame& frame, int y, float* out) {
+    const auto& gbuffer = frame.gbuffer;
+    const auto& settings = frame.settings;
+    const auto& inverse = frame.inverse_projection;
+    const auto& projection = settings.projection;
+    auto width = gbuffer.width;
+    auto height = gbuffer.height;
+    auto one = splat(1.0F);
+    auto two = splat(2.0F);
+    auto half = splat(0.5F);
+    auto size_x = splat(static_cast<float>(width));
+    auto size_y = splat(static_cast<float>(height));
+    auto min_u = splat(0.5F / static_cast<float>(width));
+    auto max_u = splat(1.0F - 0.5F / static_cast<float>(width));
+    auto min_v = splat(0.5F / static_cast<float>(height));
+    auto max_v = splat(1.0F - 0.5F / static_cast<float>(height));
+    auto last_x = _mm256_set1_epi32(width - 1);
+    auto last_y = _mm256_set1_epi32(height - 1);
+    auto stride = _mm256_set1_epi32(width);
+    auto radius = splat(settings.radius);
+    auto bias = splat(settings.bias);
+    auto sign = splat(-0.0F);
+    auto lane = _mm256_setr_ps(0.0F, 1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F, 7.0F);
+    auto lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    auto v = (static_cast<float>(y) + 0.5F) / static_cast<float>(height);
+    auto ndc_y = splat(v * 2.0F - 1.0F);
+    auto n = settings.noise_size;
+    auto noise_row = y % n * n;
+
+    auto x = 0;
+    for (; x + lanes <= width; x += lanes) {
+        auto index = y * width + x;
+        auto depth =
+            _mm256_loadu_ps(&gbuffer.depth[static_cast<size_t>(index)]);
+        auto background = _mm256_cmp_ps(depth, one, _CMP_GE_OQ);
+        if (_mm256_movemask_ps(background) == 0xFF) {
+            _mm256_storeu_ps(out + x, one);
+            continue;
+        }
+
+        auto u = _mm256_div_ps(add(splat(x + 0.5F), lane), size_x);
+        auto ndc = Vec3x8{
+            sub(mul(u, two), one),
+            ndc_y,
+            sub(mul(depth, two), one)};
+        auto w = transform_row(inverse, 3, ndc);
+        auto frag_pos = Vec3x8{
+            _mm256_div_ps(transform_row(inverse, 0, ndc), w),
+            _mm256_div_ps(transform_row(inverse, 1, ndc), w),
+            _mm256_div_ps(transform_row(inverse, 2, ndc), w)};
+        auto normal = gather(
+            gbuffer.normals.data(),
+            _mm256_add_epi32(_mm256_set1_epi32(index), lane_index));
+        auto noise = std::array<int, lanes>{};
+        for (auto i = 0; i < lanes; i++) {
+            noise[static_cast<size_t>(i)] = noise_row + (x + i) % n;
+        }
+        auto rotation = gather(
+            settings.rotations.data(),
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(noise.data())));
+        auto shift = rotation.z;
+        auto random =
+            normalize(Vec3x8{rotation.x, rotation.y, _mm256_setzero_ps()});
+        auto projected = dot(random, normal);
+        auto tangent = normalize(Vec3x8{
+            sub(random.x, mul(normal.x, projected)),
+            sub(random.y, mul(normal.y, projected)),
+            sub(random.z, mul(normal.z, projected))});
+        auto bitangent = Vec3x8{
+            sub(mul(normal.y, tangent.z), mul(normal.z, tangent.y)),
+            sub(mul(normal.z, tangent.x), mul(normal.x, tangent.z)),
+            sub(mul(normal.x, tangent.y), mul(normal.y, tangent.x))};
+
+        auto occlusion = _mm256_setzero_ps();
+        for (const auto& k : settings.kernel) {
+            // Shift the length parameter per pixel, as kernel_length does.
+            auto t = add(splat(k.w), shift);
+            t = sub(t, _mm256_floor_ps(t));
+            auto length = add(
+                splat(min_kernel_length),
+                mul(splat(1.0F - min_kernel_length), mul(t, t)));
+            auto scale = mul(length, radius);
+            auto offset = rotate(tangent, bitangent, normal, glm::vec3{k});
+            auto sample_pos = Vec3x8{
+                add(frag_pos.x, mul(offset.x, scale)),
+                add(frag_pos.y, mul(offset.y, scale)),
+                add(frag_pos.z, mul(offset.z, scale))};
+
+            // Project the sample and look up the surface under it. A NaN
+            // coordinate clamps to the lower edge.
+            auto clip_w = transform_row(projection, 3, sample_pos);
+            auto su = _mm256_div_ps(
+                transform_row(projection, 0, sample_pos),
+                clip_w);
+            auto sv = _mm256_div_ps(
+                transform_row(projection, 1, sample_pos),
+                clip_w);
+            su = clamp(add(mul(su, half), half), min_u, max_u);
+            sv = clamp(add(mul(sv, half), half), min_v, max_v);
+            auto tx = _mm256_cvttps_epi32(mul(su, size_x));
+            auto ty = _mm256_cvttps_epi32(mul(sv, size_y));
+            auto texel = _mm256_add_epi32(
+                _mm256_mullo_epi32(_mm256_min_epi32(ty, last_y), stride),
+                _mm256_min_epi32(tx, last_x));
+            auto surface = _mm256_i32gather_ps(gbuffer.depth.data(), texel, 4);
+            auto sample_ndc = Vec3x8{
+                sub(mul(su, two), one),
+                sub(mul(sv, two), one),
+                sub(mul(surface, two), one)};
+            auto sample_depth = _mm256_div_ps(
+                transform_row(inverse, 2, sample_ndc),
+                transform_row(inverse, 3, sample_ndc));
+
+            auto range = _mm256_div_ps(
+                radius,
+                _mm256_andnot_ps(sign, sub(frag_pos.z, sample_depth)));
+            range = clamp(range, _mm256_setzero_ps(), one);
+            auto boundary =
+                mul(mul(range, range), sub(splat(3.0F), mul(two, range)));
+            auto occluded = _mm256_cmp_ps(
+                sample_depth,
+                add(sample_pos.z, bias),
+                _CMP_GE_OQ);
+            occlusion = add(occlusion, _mm256_and_ps(occluded, boundary));
+        }
+        auto count = splat(static_cast<float>(settings.kernel.size()));
+        auto result = sub(one, _mm256_div_ps(occlusion, count));
+        _mm256_storeu_ps(out + x, _mm256_blendv_ps(result, one, background));
+    }
+    return x;
+}
+
+// Blur a row of pixels, 8 at a time, and get the first column left for the
+// scalar code.
+AVX2 int blur_row_avx2(const BlurPass& pass, int y, float* out) {
+    const auto& gbuffer = pass.gbuffer;
+    auto width = gbuffer.width;
+    auto radius = static_cast<int>(pass.spatial.size()) - 1;
+    auto zero = _mm256_setzero_ps();
+    auto sign = splat(-0.0F);
+    auto lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    auto zero_i = _mm256_setzero_si256();
+    auto last_x = _mm256_set1_epi32(width - 1);
+    auto stride = _mm256_set1_epi32(width);
+
+    auto x = 0;
+    for (; x + lanes <= width; x += lanes) {
+        auto index = static_cast<size_t>(y * width + x);
+        auto center = _mm256_loadu_ps(&pass.occlusion[index]);
+        auto center_distance = _mm256_loadu_ps(&pass.distances[index]);
+        auto background = _mm256_cmp_ps(
+            center_distance,
+            splat(background_distance),
+            _CMP_GE_OQ);
+        if (_mm256_movemask_ps(background) == 0xFF) {
+            _mm256_storeu_ps(out + x, center);
+            continue;
+        }
+        auto center_normal = gather(
+            gbuffer.normals.data(),
+            _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(index)), lane));
+        auto falloff = _mm256_div_ps(
+            splat(-1.0F),
+            mul(splat(blur_depth_sigma), center_distance));
+        auto column = _mm256_add_epi32(_mm256_set1_epi32(x), lane);
+
+        auto sum = center;
+        auto total = splat(1.0F);
+        for (auto i = -radius; i <= radius; i++) {
+            if (i == 0) {
+                continue;
+            }
+            auto tap = __m256i{};
+            if (pass.direction.x != 0) {
+                auto tap_x = _mm256_add_epi32(column, _mm256_set1_epi32(i));
+                tap_x = _mm256_max_epi32(tap_x, zero_i);
+                tap_x = _mm256_min_epi32(tap_x, last_x);
+                tap = _mm256_add_epi32(_mm256_set1_epi32(y * width), tap_x);
+            } else {
+                auto tap_y = std::clamp(y + i, 0, gbuffer.height - 1);
+                tap = _mm256_add_epi32(
+                    _mm256_mullo_epi32(_mm256_set1_epi32(tap_y), stride),
+                    column);
+            }
+            auto distance = _mm256_i32gather_ps(pass.distances.data(), tap, 4);
+            auto normal = gather(gbuffer.normals.data(), tap);
+            auto similarity = _mm256_max_ps(dot(normal, center_normal), zero);
+            similarity = mul(similarity, similarity);
+            similarity = mul(similarity, similarity);
+            similarity = mul(similarity, similarity);
+            auto depth = exp8(mul(
+                _mm256_andnot_ps(sign, sub(distance, center_distance)),
+                falloff));
+            auto spatial =
+                splat(pass.spatial[static_cast<size_t>(std::abs(i))]);
+            auto weight = mul(mul(spatial, depth), similarity);
+            auto occlusion = _mm256_i32gather_ps(pass.occlusion.data(), tap, 4);
+            sum = add(sum, mul(occlusion, weight));
+            total = add(total, weight);
+        }
+        auto result = _mm256_div_ps(sum, total);
+        _mm256_storeu_ps(out + x, _mm256_blendv_ps(result, center, background));
+    }
+    return x;
+}
+#endif
+
+// Check if the avx2 rows can run.
+bool use_avx2(bool vectorize) {
+    return vectorize && cpu_ssao_vectorized();
+}
+
+// Run one direction of the blur over every row.
+std::vector<float>
+blur_pass(const BlurPass& pass, ThreadPool& pool, bool vectorize) {
+    auto width = pass.gbuffer.width;
+    auto result = std::vector<float>(pass.occlusion.size());
+    auto avx2 = use_avx2(vectorize);
+    pool.run(static_cast<size_t>(pass.gbuffer.height), [&](size_t row) {
+        auto y = static_cast<int>(row);
+        auto* out = &result[row * static_cast<size_t>(width)];
+        auto first = 0;
+#ifdef CPU_SSAO_AVX2
+        if (avx2) {
+            first = blur_row_avx2(pass, y, out);
+        }
+#endif
+        blur_row(pass, y, first, out);
+    });
+    return result;
+}
+} // namespace
+
+glm::vec3 decode_normal(glm::vec2 e) {
+    e = e * 2.0F - 1.0F;
+    auto n = glm::vec3{e, 1.0F - std::abs(e.x) - std::abs(e.y)};
+    auto t = std::max(-n.z, 0.0F);
+    n.x -= (n.x >= 0.0F ? 1.0F : -1.0F) * t;
+    n.y -= (n.y >= 0.0F ? 1.0F : -1.0F) * t;
+    return glm::normalize(n);
+}
+
+bool cpu_ssao_vectorized() {
+#ifdef CPU_SSAO_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+std::vector<float> cpu_ssao(
+    const CpuGBuffer& gbuffer,
+    const CpuSsaoSettings& settings,
+    ThreadPool& pool,
+    bool vectorize) {
+    auto frame = Frame{gbuffer, settings, glm::inverse(settings.projection)};
+    auto width = static_cast<size_t>(gbuffer.width);
+    auto occlusion =
+        std::vector<float>(width * static_cast<size_t>(gbuffer.height));
+    auto avx2 = use_avx2(vectorize);
+    pool.run(static_cast<size_t>(gbuffer.height), [&](size_t row) {
+        auto y = static_cast<int>(row);
+        auto* out = &occlusion[row * width];
+        auto first = 0;
+#ifdef CPU_SSAO_AVX2
+        if (avx2) {
+            first = occlusion_row_avx2(frame, y, out);
+        }
+#endif
+        occlusion_row(frame, y, first, out);
+    });
+    return occlusion;
+}
+
+std::vector<float> cpu_bilateral_blur(
+    std::span<const float> occlusion,
+    const CpuGBuffer& gbuffer,
+    const CpuSsaoSettings& settings,
+    ThreadPool& pool,
+    bool vectorize) {
+    // Find the view distance of every pixel once for both directions.
+    auto inverse = glm::inverse(settings.projection);
+    auto distances = std::vector<float>(gbuffer.depth.size());
+    pool.run(static_cast<size_t>(gbuffer.height), [&](size_t row) {
+        auto width = static_cast<size_t>(gbuffer.width);
+        for (auto i = row * width; i < (row + 1) * width; i++) {
+            auto depth = gbuffer.depth[i];
+            distances[i] =
+                depth >= 1.0F
+                    ? background_distance
+                    : -view_position(glm::vec2{0.5F}, depth, inverse).z;
+        }
+    });
+
+    auto radius = std::max(settings.blur_radius, 0);
+    auto sigma = 0.5F * static_cast<float>(radius) + 0.5F;
+    auto spatial = std::vector<float>{};
+    for (auto i = 0; i <= radius; i++) {
+        spatial.emplace_back(
+            std::exp(-static_cast<float>(i * i) / (2.0F * sigma * sigma)));
+    }
+
+    auto rows = blur_pass(
+        {gbuffer, occlusion, distances, spatial, {1, 0}},
+        pool,
+        vectorize);
+    return blur_pass(
+        {gbuffer, rows, distances, spatial, {0, 1}},
+        pool,
+        vectorize);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// A CpuGBuffer is the part of the g-buffer read by ssao, in host memory.
+// Pixels are in row-major order starting from the bottom row, as read back
+// from opengl.
+struct CpuGBuffer {
+    int width;
+    int height;
+    std::vector<float> depth; // window-space depth, 1 for the background
+    std::vector<glm::vec3> normals; // view-space unit normals
+};
+
+// The CpuSsaoSettings are the inputs of the cpu ssao besides the g-buffer.
+// The kernel and rotations come from the generators in sampling.hpp.
+struct CpuSsaoSettings {
+    glm::mat4 projection;
+    std::vector<glm::vec4> kernel; // hemisphere samples and length parameters
+    std::vector<glm::vec3> rotations; // tileable rotations and length shifts
+    int noise_size; // width and height of the rotations
+    float radius; // radius of the sample hemisphere in view units
+    float bias; // depth bias that avoids self-occlusion
+    int blur_radius; // taps on either side of the bilateral blur
+};
+
+// Decode a unit vector from octahedral coordinates in [0, 1], as stored in
+// the g-buffer.
+glm::vec3 decode_normal(glm::vec2);
+
+// Check if the cpu ssao runs with 8-wide avx2 vectors on this machine.
+bool cpu_ssao_vectorized();
+
+// Compute the hemisphere occlusion of every pixel of a g-buffer, as the
+// non-deinterleaved fragment ssao pass does. Background pixels are 1. Rows
+// are split over the pool, and 8 pixels of a row run at once with avx2
+// unless disabled.
+std::vector<float> cpu_ssao(
+    const CpuGBuffer&,
+    const CpuSsaoSettings&,
+    ThreadPool&,
+    bool vectorize = true);
+
+// Blur the occlusion of a g-buffer with the separable bilateral blur of the
+// blur passes, first along rows and then along columns.
+std::vector<float> cpu_bilateral_blur(
+    std::span<const float> occlusion,
+    const CpuGBuffer&,
+    const CpuSsaoSettings&,
+    ThreadPool&,
+    bool vectorize = true);
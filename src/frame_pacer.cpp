@@ -0,0 +1,143 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto spin_margin = std::chrono::microseconds{1500};
+constexpr auto calibrate_interval = std::chrono::seconds{1};
+constexpr auto wait_timeout = GLuint64{1'000'000'000}; // 1 second in ns
+} // namespace
+
+FramePacer::FramePacer() {
+    calibrate();
+    _deadline = Clock::now();
+    _last_start = _deadline;
+}
+
+FramePacer::~FramePacer() {
+    for (auto& frame : _in_flight) {
+        glDeleteSync(frame.fence);
+        _free_queries.emplace_back(frame.query);
+    }
+    glDeleteQueries(
+        static_cast<GLsizei>(_free_queries.size()),
+        _free_queries.data());
+}
+
+void FramePacer::wait(const PacingSettings& settings) {
+    while (retire(false)) {
+    }
+
+    auto limit_in_flight = static_cast<size_t>(
+        std::max(settings.frames_in_flight, 1));
+    while (_in_flight.size() >= limit_in_flight) {
+        retire(true);
+    }
+
+    limit(settings.target_fps);
+
+    if (settings.low_latency) {
+        while (!_in_flight.empty()) {
+            retire(true);
+        }
+    }
+
+    auto now = Clock::now();
+    _frame_sum +=
+        std::chrono::duration<double, std::milli>{now - _last_start}.count();
+    _frame_count++;
+    _last_start = now;
+}
+
+void FramePacer::submit(Clock::time_point input_time) {
+    auto query = GLuint{};
+    if (_free_queries.empty()) {
+        glCreateQueries(GL_TIMESTAMP, 1, &query);
+    } else {
+        query = _free_queries.back();
+        _free_queries.pop_back();
+    }
+    glQueryCounter(query, GL_TIMESTAMP);
+    auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _in_flight.emplace_back(Frame{fence, query, input_time});
+
+    if (Clock::now() - _calibrated > calibrate_interval) {
+        calibrate();
+    }
+}
+
+double FramePacer::latency_ms() const {
+    return _latency_count == 0
+               ? 0.0
+               : _latency_sum / static_cast<double>(_latency_count);
+}
+
+double FramePacer::frame_ms() const {
+    return _frame_count == 0 ? 0.0
+                             : _frame_sum / static_cast<double>(_frame_count);
+}
+
+void FramePacer::reset_stats() {
+    _latency_sum = 0.0;
+    _latency_count = 0;
+    _frame_sum = 0.0;
+    _frame_count = 0;
+    _last_start = Clock::now();
+}
+
+bool FramePacer::retire(bool block) {
+    if (_in_flight.empty()) {
+        return false;
+    }
+
+    auto& frame = _in_flight.front();
+    auto status = glClientWaitSync(
+        frame.fence,
+        GL_SYNC_FLUSH_COMMANDS_BIT,
+        block ? wait_timeout : 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    auto gpu_ns = GLuint64{};
+    glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpu_ns);
+    auto done = Clock::time_point{std::chrono::nanoseconds{gpu_ns}} +
+                _gpu_offset;
+    _latency_sum += std::chrono::duration<double, std::milli>{
+        done - frame.input_time}
+                        .count();
+    _latency_count++;
+
+    glDeleteSync(frame.fence);
+    _free_queries.emplace_back(frame.query);
+    _in_flight.pop_front();
+    return true;
+}
+
+void FramePacer::limit(int target_fps) {
+    if (target_fps <= 0) {
+        _deadline = Clock::now();
+        return;
+    }
+
+    auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{1.0 / target_fps});
+    if (Clock::now() < _deadline - spin_margin) {
+        std::this_thread::sleep_until(_deadline - spin_margin);
+    }
+    while (Clock::now() < _deadline) {
+    }
+
+    // Do not try to catch up on frames missed by more than a period.
+    _deadline = std::max(_deadline + period, Clock::now());
+}
+
+void FramePacer::calibrate() {
+    auto gpu_ns = GLint64{};
+    glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+    _calibrated = Clock::now();
+    _gpu_offset = _calibrated - Clock::time_point{std::chrono::nanoseconds{
+                                    gpu_ns}};
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+// The PacingSettings control how frames are queued and spaced out.
+struct PacingSettings {
+    int frames_in_flight = 2; // frames the gpu may be behind the cpu
+    int target_fps = 0; // frame-rate cap (0 for none)
+    bool low_latency = false; // wait for the gpu to go idle before input
+};
+
+// The most frames that PacingSettings may let the gpu be behind the cpu.
+constexpr auto max_frames_in_flight = 3;
+
+// A FramePacer bounds the number of frames queued on the gpu with fences,
+// limits the frame rate, and measures the latency from input sampling to the
+// gpu finishing the frame (a proxy for input-to-photon latency).
+class FramePacer {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    FramePacer();
+
+    // Disallow copies and moves.
+    FramePacer(const FramePacer&) = delete;
+    FramePacer(FramePacer&&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    FramePacer& operator=(FramePacer&&) = delete;
+    ~FramePacer();
+
+    // Block until a new frame may start. Call right before sampling input.
+    void wait(const PacingSettings&);
+
+    // Mark the end of a frame whose input was sampled at the given time.
+    // Call right after swapping buffers.
+    void submit(Clock::time_point);
+
+    // Get the average input-to-gpu-completion latency in milliseconds.
+    [[nodiscard]] double latency_ms() const;
+
+    // Get the average time between frame starts in milliseconds.
+    [[nodiscard]] double frame_ms() const;
+
+    // Forget the measured averages.
+    void reset_stats();
+
+  private:
+    // A Frame is a submitted frame the gpu may still be working on.
+    struct Frame {
+        GLsync fence;
+        GLuint query; // gpu timestamp at the end of the frame
+        Clock::time_point input_time;
+    };
+
+    std::deque<Frame> _in_flight; // oldest first
+    std::vector<GLuint> _free_queries;
+    Clock::time_point _deadline; // earliest start of the next frame
+    Clock::time_point _last_start;
+    Clock::time_point _calibrated; // time of the last clock calibration
+    Clock::duration _gpu_offset{}; // cpu clock minus gpu clock
+
+    double _latency_sum = 0.0;
+    size_t _latency_count = 0;
+    double _frame_sum = 0.0;
+    size_t _frame_count = 0;
+
+    // Retire the oldest frame, waiting for it if requested. Return whether it
+    // was retired.
+    bool retire(bool block);
+
+    // Sleep, then spin, until the frame limiter deadline.
+    void limit(int target_fps);
+
+    // Measure the offset between the gpu and cpu clocks.
+    void calibrate();
+};
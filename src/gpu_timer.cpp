@@ -0,0 +1,70 @@
+#include "gpu_timer.hpp"
+
+#include <utility>
+
+GpuTimer::GpuTimer(Kind kind) : _id{0}, _end_id{0} {
+    if (kind == Kind::timestamps) {
+        glCreateQueries(GL_TIMESTAMP, 1, &_id);
+        glCreateQueries(GL_TIMESTAMP, 1, &_end_id);
+    } else {
+        glCreateQueries(GL_TIME_ELAPSED, 1, &_id);
+    }
+}
+
+GpuTimer::GpuTimer(GpuTimer&& t) noexcept : _id{0}, _end_id{0} {
+    GpuTimer::_swap(*this, t);
+}
+
+GpuTimer& GpuTimer::operator=(GpuTimer&& t) noexcept {
+    GpuTimer::_swap(*this, t);
+    return *this;
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(1, &_id);
+    glDeleteQueries(1, &_end_id);
+}
+
+void GpuTimer::begin() const {
+    if (_end_id != 0) {
+        glQueryCounter(_id, GL_TIMESTAMP);
+    } else {
+        glBeginQuery(GL_TIME_ELAPSED, _id);
+    }
+}
+
+void GpuTimer::end() const {
+    if (_end_id != 0) {
+        glQueryCounter(_end_id, GL_TIMESTAMP);
+    } else {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+}
+
+bool GpuTimer::ready() const {
+    auto available = GLint{};
+    glGetQueryObjectiv(
+        _end_id != 0 ? _end_id : _id,
+        GL_QUERY_RESULT_AVAILABLE,
+        &available);
+    return available != 0;
+}
+
+double GpuTimer::elapsed_ms() const {
+    auto ns = GLuint64{};
+    if (_end_id != 0) {
+        auto begin = GLuint64{};
+        auto end = GLuint64{};
+        glGetQueryObjectui64v(_id, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(_end_id, GL_QUERY_RESULT, &end);
+        ns = end - begin;
+    } else {
+        glGetQueryObjectui64v(_id, GL_QUERY_RESULT, &ns);
+    }
+    return static_cast<double>(ns) / 1.0e6;
+}
+
+void GpuTimer::_swap(GpuTimer& a, GpuTimer& b) {
+    std::swap(a._id, b._id);
+    std::swap(a._end_id, b._end_id);
+}
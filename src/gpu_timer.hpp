@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// A GpuTimer measures the time the gpu spends executing a range of commands.
+class GpuTimer {
+  public:
+    // How a timer queries the gpu. Time elapsed queries cannot overlap, so
+    // timers that enclose other timers use a pair of timestamps instead.
+    enum class Kind { elapsed, timestamps };
+
+    explicit GpuTimer(Kind = Kind::elapsed);
+
+    // Allow moves but disallow copies.
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer(GpuTimer&&) noexcept;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    GpuTimer& operator=(GpuTimer&&) noexcept;
+    ~GpuTimer();
+
+    // Start timing the commands that follow.
+    void begin() const;
+
+    // Stop timing.
+    void end() const;
+
+    // Check if the result of the last timed range is available.
+    [[nodiscard]] bool ready() const;
+
+    // Wait for the last timed range to finish and get its duration in
+    // milliseconds.
+    [[nodiscard]] double elapsed_ms() const;
+
+  private:
+    GLuint _id; // opengl id of the time elapsed or begin timestamp query
+    GLuint _end_id; // opengl id of the end timestamp query, if any
+
+    // Swap the ids of two timers.
+    static void _swap(GpuTimer&, GpuTimer&);
+};
@@ -0,0 +1,77 @@
+#include "headless.hpp"
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto gl_major_version = 4;
+constexpr auto gl_minor_version = 6;
+
+// Get the display of mesa's surfaceless platform, or the default display
+// when the platform is missing.
+EGLDisplay get_display() {
+    const auto* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (extensions == nullptr || get_platform_display == nullptr ||
+        std::strstr(extensions, "EGL_MESA_platform_surfaceless") == nullptr) {
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    return get_platform_display(
+        EGL_PLATFORM_SURFACELESS_MESA,
+        EGL_DEFAULT_DISPLAY,
+        nullptr);
+}
+} // namespace
+
+HeadlessContext::HeadlessContext() {
+    // llvmpipe supports the features of opengl 4.6 but reports 4.5. Unless
+    // the user overrides them, report 4.6 so that the shaders compile.
+    setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+    setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+    _display = get_display();
+    if (_display == EGL_NO_DISPLAY ||
+        eglInitialize(_display, nullptr, nullptr) == EGL_FALSE ||
+        eglBindAPI(EGL_OPENGL_API) == EGL_FALSE) {
+        std::terminate();
+    }
+
+    // Render only into framebuffer objects, so no config or surface is needed.
+    constexpr auto attributes = std::array{
+        EGL_CONTEXT_MAJOR_VERSION,
+        gl_major_version,
+        EGL_CONTEXT_MINOR_VERSION,
+        gl_minor_version,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    _context = eglCreateContext(
+        _display,
+        EGL_NO_CONFIG_KHR,
+        EGL_NO_CONTEXT,
+        attributes.data());
+    if (_context == EGL_NO_CONTEXT ||
+        eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context) ==
+            EGL_FALSE) {
+        std::terminate();
+    }
+}
+
+HeadlessContext::~HeadlessContext() {
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(_display, _context);
+    eglTerminate(_display);
+}
+
+void* HeadlessContext::get_proc_address(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// A HeadlessContext is an opengl 4.6 core context without a window or
+// default framebuffer. It uses egl on mesa's surfaceless platform, so it runs
+// without a display, and on llvmpipe without a gpu.
+class HeadlessContext {
+  public:
+    // Create the context and make it current on the calling thread.
+    HeadlessContext();
+
+    // Disallow copies and moves.
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext(HeadlessContext&&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(HeadlessContext&&) = delete;
+    ~HeadlessContext();
+
+    // Look up an opengl function by name.
+    static void* get_proc_address(const char* name);
+
+  private:
+    void* _display; // egl display, kept opaque to avoid the egl headers
+    void* _context; // egl context
+};
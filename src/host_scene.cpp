@@ -0,0 +1,19 @@
+#include "host_scene.hpp"
+
+#include <cmath>
+
+glm::vec4 HostTexture::sample(glm::vec2 uv) const {
+    auto position = glm::fract(uv) * glm::vec2{width, height} - 0.5F;
+    auto base = glm::floor(position);
+    auto f = position - base;
+    auto texel = [this](int x, int y) {
+        x = (x % width + width) % width;
+        y = (y % height + height) % height;
+        return glm::vec4{texels[static_cast<size_t>(y * width + x)]};
+    };
+    auto x = static_cast<int>(base.x);
+    auto y = static_cast<int>(base.y);
+    auto bottom = glm::mix(texel(x, y), texel(x + 1, y), f.x);
+    auto top = glm::mix(texel(x, y + 1), texel(x + 1, y + 1), f.x);
+    return glm::mix(bottom, top, f.y) / 255.0F;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <optional>
+#include <vector>
+
+// A HostTexture is an rgba8 texture in host memory, with rows starting from
+// the bottom as in opengl.
+struct HostTexture {
+    int width;
+    int height;
+    std::vector<glm::u8vec4> texels;
+
+    // Sample the texture in [0, 1] with bilinear filtering and repeat
+    // wrapping.
+    [[nodiscard]] glm::vec4 sample(glm::vec2 uv) const;
+};
+
+// A HostMesh is the geometry of a mesh and the indices of its textures in
+// the scene.
+struct HostMesh {
+    std::vector<Vertex> vertices;
+    std::vector<glm::uvec3> faces;
+    std::optional<size_t> diffuse;
+    std::optional<size_t> normal;
+    std::optional<size_t> specular;
+};
+
+// A HostScene is a copy of a scene in host memory for the software
+// rasterizer. It needs no opengl context.
+struct HostScene {
+    std::vector<HostTexture> textures;
+    std::vector<HostMesh> meshes;
+};
@@ -0,0 +1,665 @@
+#include "image_metrics.hpp"
+
+#include <glm/glm.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numbers>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto ssim_sigma = 1.5F; // width of the ssim window in pixels
+constexpr auto ssim_c1 = 0.01F * 0.01F; // stabilizes the mean term
+constexpr auto ssim_c2 = 0.03F * 0.03F; // stabilizes the contrast term
+constexpr auto flip_qc = 0.7F; // exponent of the color difference
+constexpr auto flip_pc = 0.4F; // breakpoint of the color difference mapping
+constexpr auto flip_pt = 0.95F; // value of the breakpoint after mapping
+constexpr auto flip_qf = 0.5F; // exponent of the feature difference
+constexpr auto flip_feature_width = 0.082F; // feature size in degrees
+
+// A Csf is the contrast sensitivity of an opponent color channel, as the
+// sum of two gaussians over visual degrees.
+struct Csf {
+    float a1;
+    float b1;
+    float a2;
+    float b2;
+};
+
+// The contrast sensitivities of the achromatic, red-green, and blue-yellow
+// channels.
+constexpr auto csfs = std::array{
+    Csf{1.0F, 0.0047F, 0.0F, 1.0e-5F},
+    Csf{1.0F, 0.0053F, 0.0F, 1.0e-5F},
+    Csf{34.1F, 0.04F, 13.5F, 0.025F}};
+
+// The d65 white point in xyz.
+constexpr auto white = glm::vec3{0.950428545F, 1.0F, 1.088900371F};
+
+glm::vec3 srgb_to_linear(glm::vec3 c) {
+    auto linear = glm::vec3{};
+    for (auto i = 0; i < 3; i++) {
+        linear[i] = c[i] <= 0.04045F ? c[i] / 12.92F
+                                     : std::pow((c[i] + 0.055F) / 1.055F, 2.4F);
+    }
+    return linear;
+}
+
+glm::vec3 linear_to_xyz(glm::vec3 c) {
+    const auto matrix = glm::transpose(glm::mat3{
+        0.4124564F,
+        0.3575761F,
+        0.1804375F,
+        0.2126729F,
+        0.7151522F,
+        0.0721750F,
+        0.0193339F,
+        0.1191920F,
+        0.9503041F});
+    return matrix * c;
+}
+
+glm::vec3 xyz_to_linear(glm::vec3 c) {
+    const auto matrix = glm::transpose(glm::mat3{
+        3.2404542F,
+        -1.5371385F,
+        -0.4985314F,
+        -0.9692660F,
+        1.8760108F,
+        0.0415560F,
+        0.0556434F,
+        -0.2040259F,
+        1.0572252F});
+    return matrix * c;
+}
+
+// Convert xyz to the linear opponent space ycxcz.
+glm::vec3 xyz_to_ycxcz(glm::vec3 c) {
+    auto n = c / white;
+    return {116.0F * n.y - 16.0F, 500.0F * (n.x - n.y), 200.0F * (n.y - n.z)};
+}
+
+glm::vec3 ycxcz_to_xyz(glm::vec3 c) {
+    auto y = (c.x + 16.0F) / 116.0F;
+    return glm::vec3{c.y / 500.0F + y, y, y - c.z / 200.0F} * white;
+}
+
+// Convert xyz to cielab, with the chroma scaled by lightness as the hunt
+// effect does.
+glm::vec3 xyz_to_hunt_lab(glm::vec3 c) {
+    constexpr auto delta = 6.0F / 29.0F;
+    auto f = [](float t) {
+        if (t > delta * delta * delta) {
+            return std::cbrt(t);
+        }
+        return t / (3.0F * delta * delta) + 4.0F / 29.0F;
+    };
+    auto n = c / white;
+    auto l = 116.0F * f(n.y) - 16.0F;
+    auto a = 500.0F * (f(n.x) - f(n.y));
+    auto b = 200.0F * (f(n.y) - f(n.z));
+    return {l, 0.01F * l * a, 0.01F * l * b};
+}
+
+// Get the hybrid distance of two colors in lab, which is closer to the
+// perceived distance than the euclidean one for large differences.
+float hyab(glm::vec3 a, glm::vec3 b) {
+    auto d = a - b;
+    return std::abs(d.x) + std::sqrt(d.y * d.y + d.z * d.z);
+}
+
+// Get an unnormalized gaussian with some width in pixels, out to three
+// widths.
+std::vector<float> gaussian(float sigma) {
+    auto radius = std::max(static_cast<int>(std::ceil(3.0F * sigma)), 1);
+    auto kernel = std::vector<float>(static_cast<size_t>(2 * radius + 1));
+    for (auto x = -radius; x <= radius; x++) {
+        auto t = static_cast<float>(x) / sigma;
+        kernel[static_cast<size_t>(x + radius)] = std::exp(-0.5F * t * t);
+    }
+    return kernel;
+}
+
+// Scale the positive weights of a kernel to sum to 1, and the negative
+// weights to sum to -1.
+std::vector<float> balance(std::vector<float> kernel) {
+    auto positive = 0.0F;
+    auto negative = 0.0F;
+    for (auto w : kernel) {
+        (w > 0.0F ? positive : negative) += w;
+    }
+    for (auto& w : kernel) {
+        w /= w > 0.0F ? positive : -negative;
+    }
+    return kernel;
+}
+
+// Convolve an image with a separable kernel, clamping at the edges.
+std::vector<float> filter(
+    std::span<const float> image,
+    int width,
+    int height,
+    std::span<const float> kernel_x,
+    std::span<const float> kernel_y) {
+    auto at = [width](int x, int y) {
+        return static_cast<size_t>(y * width + x);
+    };
+    auto rows = std::vector<float>(image.size());
+    auto radius_x = static_cast<int>(kernel_x.size() / 2);
+    for (auto y = 0; y < height; y++) {
+        for (auto x = 0; x < width; x++) {
+            auto sum = 0.0F;
+            for (auto i = -radius_x; i <= radius_x; i++) {
+                auto sx = std::clamp(x + i, 0, width - 1);
+                sum += kernel_x[static_cast<size_t>(i + radius_x)] *
+                       image[at(sx, y)];
+            }
+            rows[at(x, y)] = sum;
+        }
+    }
+    auto result = std::vector<float>(image.size());
+    auto radius_y = static_cast<int>(kernel_y.size() / 2);
+    for (auto y = 0; y < height; y++) {
+        for (auto x = 0; x < width; x++) {
+            auto sum = 0.0F;
+            for (auto i = -radius_y; i <= radius_y; i++) {
+                auto sy = std::clamp(y + i, 0, height - 1);
+                sum += kernel_y[static_cast<size_t>(i + radius_y)] *
+                       rows[at(x, sy)];
+            }
+            result[at(x, y)] = sum;
+        }
+    }
+    return result;
+}
+
+// Filter the opponent channels of an image by the contrast sensitivity of
+// the eye, and get the hunt-adjusted lab colors of the result.
+std::vector<glm::vec3>
+perceived_colors(const RgbImage& image, float pixels_per_degree) {
+    auto size = image.pixels.size();
+    auto channels = std::array<std::vector<float>, 3>{};
+    for (auto& channel : channels) {
+        channel.resize(size);
+    }
+    for (auto i = size_t{0}; i < size; i++) {
+        auto c = xyz_to_ycxcz(linear_to_xyz(srgb_to_linear(image.pixels[i])));
+        for (auto k = size_t{0}; k < 3; k++) {
+            channels[k][i] = c[static_cast<int>(k)];
+        }
+    }
+
+    // Each gaussian of a channel is separable, so the channel is filtered
+    // once per gaussian. The weights make the whole kernel sum to 1.
+    for (auto k = size_t{0}; k < 3; k++) {
+        const auto& csf = csfs[k];
+        auto terms = std::array{
+            std::pair{csf.a1, csf.b1},
+            std::pair{csf.a2, csf.b2}};
+        auto kernels = std::array<std::vector<float>, 2>{};
+        auto weights = std::array<float, 2>{};
+        auto total = 0.0F;
+        for (auto t = size_t{0}; t < 2; t++) {
+            auto [a, b] = terms[t];
+            if (a == 0.0F) {
+                continue;
+            }
+            auto sigma = std::sqrt(b / (2.0F * std::numbers::pi_v<float> *
+                                        std::numbers::pi_v<float>)) *
+                         pixels_per_degree;
+            kernels[t] = gaussian(sigma);
+            auto sum = 0.0F;
+            for (auto w : kernels[t]) {
+                sum += w;
+            }
+            weights[t] = a * std::sqrt(std::numbers::pi_v<float> / b);
+            total += weights[t] * sum * sum;
+        }
+        auto filtered = std::vector<float>(size, 0.0F);
+        for (auto t = size_t{0}; t < 2; t++) {
+            if (kernels[t].empty()) {
+                continue;
+            }
+            auto term = filter(
+                channels[k],
+                image.width,
+                image.height,
+                kernels[t],
+                kernels[t]);
+            for (auto i = size_t{0}; i < size; i++) {
+                filtered[i] += weights[t] / total * term[i];
+            }
+        }
+        channels[k] = std::move(filtered);
+    }
+
+    auto colors = std::vector<glm::vec3>(size);
+    for (auto i = size_t{0}; i < size; i++) {
+        auto c = glm::vec3{channels[0][i], channels[1][i], channels[2][i]};
+        auto linear =
+            glm::clamp(xyz_to_linear(ycxcz_to_xyz(c)), 0.0F, 1.0F);
+        colors[i] = xyz_to_hunt_lab(linear_to_xyz(linear));
+    }
+    return colors;
+}
+
+// The edge and point responses of an image's lightness.
+struct Features {
+    std::vector<float> edges;
+    std::vector<float> points;
+};
+
+// Detect edges and points with the first and second derivatives of a
+// gaussian of the feature size.
+Features detect_features(const RgbImage& image, float pixels_per_degree) {
+    auto size = image.pixels.size();
+    auto lightness = std::vector<float>(size);
+    for (auto i = size_t{0}; i < size; i++) {
+        auto c = xyz_to_ycxcz(linear_to_xyz(srgb_to_linear(image.pixels[i])));
+        lightness[i] = (c.x + 16.0F) / 116.0F;
+    }
+
+    auto sigma = 0.5F * flip_feature_width * pixels_per_degree;
+    auto smooth = gaussian(sigma);
+    auto sum = 0.0F;
+    for (auto w : smooth) {
+        sum += w;
+    }
+    auto first = smooth;
+    auto second = smooth;
+    auto radius = static_cast<int>(smooth.size() / 2);
+    for (auto x = -radius; x <= radius; x++) {
+        auto i = static_cast<size_t>(x + radius);
+        auto t = static_cast<float>(x) / sigma;
+        first[i] = -t * smooth[i];
+        second[i] = (t * t - 1.0F) * smooth[i];
+        smooth[i] /= sum;
+    }
+    first = balance(std::move(first));
+    second = balance(std::move(second));
+
+    auto [w, h] = std::pair{image.width, image.height};
+    auto edge_x = filter(lightness, w, h, first, smooth);
+    auto edge_y = filter(lightness, w, h, smooth, first);
+    auto point_x = filter(lightness, w, h, second, smooth);
+    auto point_y = filter(lightness, w, h, smooth, second);
+    auto features =
+        Features{std::vector<float>(size), std::vector<float>(size)};
+    for (auto i = size_t{0}; i < size; i++) {
+        features.edges[i] = std::hypot(edge_x[i], edge_y[i]);
+        features.points[i] = std::hypot(point_x[i], point_y[i]);
+    }
+    return features;
+}
+
+std::vector<float> ssim_map(const RgbImage& image, const RgbImage& reference) {
+    auto size = image.pixels.size();
+    auto luma = [size](const RgbImage& rgb) {
+        auto values = std::vector<float>(size);
+        for (auto i = size_t{0}; i < size; i++) {
+            values[i] =
+                glm::dot(rgb.pixels[i], glm::vec3{0.299F, 0.587F, 0.114F});
+        }
+        return values;
+    };
+    auto x = luma(image);
+    auto y = luma(reference);
+    auto xx = std::vector<float>(size);
+    auto yy = std::vector<float>(size);
+    auto xy = std::vector<float>(size);
+    for (auto i = size_t{0}; i < size; i++) {
+        xx[i] = x[i] * x[i];
+        yy[i] = y[i] * y[i];
+        xy[i] = x[i] * y[i];
+    }
+
+    auto window = gaussian(ssim_sigma);
+    auto sum = 0.0F;
+    for (auto w : window) {
+        sum += w;
+    }
+    for (auto& w : window) {
+        w /= sum;
+    }
+    auto blur = [&](const std::vector<float>& values) {
+        return filter(values, image.width, image.height, window, window);
+    };
+    auto mean_x = blur(x);
+    auto mean_y = blur(y);
+    auto mean_xx = blur(xx);
+    auto mean_yy = blur(yy);
+    auto mean_xy = blur(xy);
+
+    auto map = std::vector<float>(size);
+    for (auto i = size_t{0}; i < size; i++) {
+        auto mx = mean_x[i];
+        auto my = mean_y[i];
+        auto vx = mean_xx[i] - mx * mx;
+        auto vy = mean_yy[i] - my * my;
+        auto cov = mean_xy[i] - mx * my;
+        map[i] = (2.0F * mx * my + ssim_c1) * (2.0F * cov + ssim_c2) /
+                 ((mx * mx + my * my + ssim_c1) * (vx + vy + ssim_c2));
+    }
+    return map;
+}
+
+std::vector<float> flip_map(
+    const RgbImage& image,
+    const RgbImage& reference,
+    float pixels_per_degree) {
+    auto colors = perceived_colors(image, pixels_per_degree);
+    auto reference_colors = perceived_colors(reference, pixels_per_degree);
+    auto features = detect_features(image, pixels_per_degree);
+    auto reference_features = detect_features(reference, pixels_per_degree);
+
+    // The largest color difference is the one between green and blue.
+    auto max_color = std::pow(
+        hyab(
+            xyz_to_hunt_lab(linear_to_xyz({0.0F, 1.0F, 0.0F})),
+            xyz_to_hunt_lab(linear_to_xyz({0.0F, 0.0F, 1.0F}))),
+        flip_qc);
+    auto breakpoint = flip_pc * max_color;
+
+    auto map = std::vector<float>(colors.size());
+    for (auto i = size_t{0}; i < map.size(); i++) {
+        // Compress large color differences into the top of the range.
+        auto color =
+            std::pow(hyab(colors[i], reference_colors[i]), flip_qc);
+        color = color < breakpoint
+                    ? flip_pt / breakpoint * color
+                    : flip_pt + (color - breakpoint) /
+                                    (max_color - breakpoint) * (1.0F - flip_pt);
+
+        auto feature = std::max(
+            std::abs(features.edges[i] - reference_features.edges[i]),
+            std::abs(features.points[i] - reference_features.points[i]));
+        feature = std::pow(feature / std::numbers::sqrt2_v<float>, flip_qf);
+        map[i] = std::pow(std::min(color, 1.0F), 1.0F - feature);
+    }
+    return map;
+}
+
+// Get the crc-32 of the bytes of a png chunk.
+uint32_t crc32(std::span<const uint8_t> bytes) {
+    static const auto table = [] {
+        auto entries = std::array<uint32_t, 256>{};
+        for (auto i = uint32_t{0}; i < entries.size(); i++) {
+            auto c = i;
+            for (auto k = 0; k < 8; k++) {
+                c = (c & 1U) != 0 ? 0xEDB88320U ^ (c >> 1U) : c >> 1U;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+    auto crc = 0xFFFFFFFFU;
+    for (auto byte : bytes) {
+        crc = table[(crc ^ byte) & 0xFFU] ^ (crc >> 8U);
+    }
+    return crc ^ 0xFFFFFFFFU;
+}
+
+// Append a big-endian 32-bit integer to some bytes.
+void append_u32(std::vector<uint8_t>& bytes, uint32_t value) {
+    for (auto shift : {24U, 16U, 8U, 0U}) {
+        bytes.emplace_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+// Write a png chunk of some type and data.
+void write_chunk(
+    std::ofstream& file,
+    const char* type,
+    std::span<const uint8_t> data) {
+    auto chunk = std::vector<uint8_t>{};
+    append_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    append_u32(chunk, crc32(std::span{chunk}.subspan(4)));
+    file.write(
+        reinterpret_cast<const char*>(chunk.data()),
+        static_cast<std::streamsize>(chunk.size()));
+}
+
+double mean(std::span<const float> values) {
+    auto sum = 0.0;
+    for (auto value : values) {
+        sum += static_cast<double>(value);
+    }
+    return values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+}
+} // namespace
+
+ImageDifference
+compare_images(std::span<const float> image, std::span<const float> reference) {
+    auto size = std::min(image.size(), reference.size());
+    auto squared_sum = 0.0;
+    auto max_error = 0.0;
+    for (auto i = size_t{0}; i < size; i++) {
+        auto error = std::abs(
+            static_cast<double>(image[i]) - static_cast<double>(reference[i]));
+        squared_sum += error * error;
+        max_error = std::max(max_error, error);
+    }
+
+    auto mse = size > 0 ? squared_sum / static_cast<double>(size) : 0.0;
+    auto psnr = mse > 0.0 ? -10.0 * std::log10(mse)
+                          : std::numeric_limits<double>::infinity();
+    return {std::sqrt(mse), psnr, max_error};
+}
+
+bool write_ppm(
+    const std::filesystem::path& path,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels) {
+    auto file = std::ofstream{path, std::ios::binary};
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (auto y = height; y-- > 0;) {
+        for (auto x = 0; x < width; x++) {
+            const auto& pixel = pixels[static_cast<size_t>(y * width + x)];
+            file.put(static_cast<char>(pixel.r));
+            file.put(static_cast<char>(pixel.g));
+            file.put(static_cast<char>(pixel.b));
+        }
+    }
+    return file.good();
+}
+
+bool write_png(
+    const std::filesystem::path& path,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels) {
+    constexpr auto max_block = size_t{65535}; // bytes of a stored block
+    constexpr auto adler_modulus = 65521U;
+
+    // Filter every top-first row with "none", and store it in the zlib
+    // stream without compression.
+    auto raw = std::vector<uint8_t>{};
+    raw.reserve(static_cast<size_t>(height) * (4 * width + 1));
+    for (auto y = height; y-- > 0;) {
+        raw.emplace_back(0);
+        for (auto x = 0; x < width; x++) {
+            const auto& pixel = pixels[static_cast<size_t>(y * width + x)];
+            raw.insert(raw.end(), {pixel.r, pixel.g, pixel.b, pixel.a});
+        }
+    }
+    auto zlib = std::vector<uint8_t>{0x78, 0x01};
+    auto offset = size_t{0};
+    auto last = false;
+    while (!last) {
+        auto size = std::min(raw.size() - offset, max_block);
+        last = offset + size == raw.size();
+        zlib.emplace_back(last ? 1 : 0);
+        for (auto value : {size, ~size}) {
+            zlib.emplace_back(static_cast<uint8_t>(value));
+            zlib.emplace_back(static_cast<uint8_t>(value >> 8U));
+        }
+        zlib.insert(
+            zlib.end(),
+            raw.begin() + static_cast<std::ptrdiff_t>(offset),
+            raw.begin() + static_cast<std::ptrdiff_t>(offset + size));
+        offset += size;
+    }
+    auto a = 1U;
+    auto b = 0U;
+    for (auto byte : raw) {
+        a = (a + byte) % adler_modulus;
+        b = (b + a) % adler_modulus;
+    }
+    append_u32(zlib, (b << 16U) | a);
+
+    auto header = std::vector<uint8_t>{};
+    append_u32(header, static_cast<uint32_t>(width));
+    append_u32(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 6, 0, 0, 0}); // 8-bit rgba
+    auto file = std::ofstream{path, std::ios::binary};
+    file.write("\x89PNG\r\n\x1a\n", 8);
+    write_chunk(file, "IHDR", header);
+    write_chunk(file, "IDAT", zlib);
+    write_chunk(file, "IEND", {});
+    return file.good();
+}
+
+bool write_image(
+    const std::filesystem::path& path,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels) {
+    if (path.extension() == ".png") {
+        return write_png(path, width, height, pixels);
+    }
+    return write_ppm(path, width, height, pixels);
+}
+
+std::optional<RgbImage> read_image(const std::filesystem::path& path) {
+    auto width = 0;
+    auto height = 0;
+    auto components = 0;
+    stbi_set_flip_vertically_on_load(true);
+    auto* data = stbi_load(path.c_str(), &width, &height, &components, 3);
+    if (data == nullptr) {
+        return std::nullopt;
+    }
+
+    auto image = RgbImage{width, height, {}};
+    auto size = static_cast<size_t>(width) * static_cast<size_t>(height);
+    image.pixels.resize(size);
+    for (auto i = size_t{0}; i < size; i++) {
+        image.pixels[i] =
+            glm::vec3{data[3 * i], data[3 * i + 1], data[3 * i + 2]} / 255.0F;
+    }
+    stbi_image_free(data);
+    return image;
+}
+
+RgbImage
+to_image(int width, int height, std::span<const glm::u8vec4> pixels) {
+    auto image = RgbImage{width, height, {}};
+    image.pixels.reserve(pixels.size());
+    for (const auto& pixel : pixels) {
+        image.pixels.emplace_back(glm::vec3{pixel} / 255.0F);
+    }
+    return image;
+}
+
+ImageQuality measure_quality(
+    const RgbImage& image,
+    const RgbImage& reference,
+    float pixels_per_degree) {
+    auto squared_sum = 0.0;
+    for (auto i = size_t{0}; i < image.pixels.size(); i++) {
+        auto error = glm::dvec3{image.pixels[i] - reference.pixels[i]};
+        squared_sum += glm::dot(error, error);
+    }
+    auto samples = 3.0 * static_cast<double>(image.pixels.size());
+    auto mse = samples > 0.0 ? squared_sum / samples : 0.0;
+
+    auto quality = ImageQuality{};
+    quality.psnr = mse > 0.0 ? -10.0 * std::log10(mse)
+                             : std::numeric_limits<double>::infinity();
+    quality.ssim_map = ssim_map(image, reference);
+    quality.flip_map = flip_map(image, reference, pixels_per_degree);
+    quality.ssim = mean(quality.ssim_map);
+    quality.flip = mean(quality.flip_map);
+    return quality;
+}
+
+std::vector<RegionScore> region_scores(
+    const ImageQuality& quality,
+    int width,
+    int height,
+    int region_size) {
+    auto scores = std::vector<RegionScore>{};
+    for (auto y = 0; y * region_size < height; y++) {
+        for (auto x = 0; x * region_size < width; x++) {
+            auto score = RegionScore{x, y, 0.0, 0.0};
+            auto count = 0;
+            auto max_y = std::min((y + 1) * region_size, height);
+            auto max_x = std::min((x + 1) * region_size, width);
+            for (auto py = y * region_size; py < max_y; py++) {
+                for (auto px = x * region_size; px < max_x; px++) {
+                    auto i = static_cast<size_t>(py * width + px);
+                    score.ssim += static_cast<double>(quality.ssim_map[i]);
+                    score.flip += static_cast<double>(quality.flip_map[i]);
+                    count++;
+                }
+            }
+            score.ssim /= count;
+            score.flip /= count;
+            scores.emplace_back(score);
+        }
+    }
+    return scores;
+}
+
+std::vector<std::string> quality_failures(
+    const ImageQuality& quality,
+    std::span<const RegionScore> regions,
+    const QualityThresholds& thresholds) {
+    auto failures = std::vector<std::string>{};
+    if (quality.psnr < thresholds.min_psnr) {
+        failures.emplace_back("psnr");
+    }
+    if (quality.ssim < thresholds.min_ssim) {
+        failures.emplace_back("ssim");
+    }
+    if (quality.flip > thresholds.max_flip) {
+        failures.emplace_back("flip");
+    }
+    auto worst = std::max_element(
+        regions.begin(),
+        regions.end(),
+        [](const auto& a, const auto& b) { return a.flip < b.flip; });
+    if (worst != regions.end() && worst->flip > thresholds.max_region_flip) {
+        failures.emplace_back("region flip");
+    }
+    return failures;
+}
+
+std::vector<glm::u8vec4> heatmap(std::span<const float> values) {
+    // Stops of the magma colormap.
+    constexpr auto stops = std::array{
+        glm::vec3{0.0F, 0.0F, 4.0F},
+        glm::vec3{81.0F, 18.0F, 124.0F},
+        glm::vec3{183.0F, 55.0F, 121.0F},
+        glm::vec3{252.0F, 137.0F, 97.0F},
+        glm::vec3{252.0F, 253.0F, 191.0F}};
+    auto pixels = std::vector<glm::u8vec4>{};
+    pixels.reserve(values.size());
+    for (auto value : values) {
+        auto t = std::clamp(value, 0.0F, 1.0F) *
+                 static_cast<float>(stops.size() - 1);
+        auto i = std::min(static_cast<size_t>(t), stops.size() - 2);
+        auto color =
+            glm::mix(stops[i], stops[i + 1], t - static_cast<float>(i));
+        pixels.emplace_back(glm::round(color), 255);
+    }
+    return pixels;
+}
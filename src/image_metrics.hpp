@@ -0,0 +1,112 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// An ImageDifference summarizes how far an image is from a reference.
+struct ImageDifference {
+    double rmse; // root mean square error
+    double psnr; // peak signal-to-noise ratio in decibels, for a peak of 1
+    double max_error; // largest absolute error
+};
+
+// Compare two single-channel images of the same size with values in [0, 1].
+ImageDifference
+compare_images(std::span<const float> image, std::span<const float> reference);
+
+// Write rgba8 pixels, with rows starting from the bottom, to a binary ppm
+// file without the alpha channel, and get whether it succeeded.
+bool write_ppm(
+    const std::filesystem::path&,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels);
+
+// Write rgba8 pixels, with rows starting from the bottom, to an uncompressed
+// png file, and get whether it succeeded.
+bool write_png(
+    const std::filesystem::path&,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels);
+
+// Write rgba8 pixels to a png or ppm file, chosen by the extension of the
+// path, and get whether it succeeded.
+bool write_image(
+    const std::filesystem::path&,
+    int width,
+    int height,
+    std::span<const glm::u8vec4> pixels);
+
+// An RgbImage is an image with encoded srgb values in [0, 1], with rows
+// starting from the bottom.
+struct RgbImage {
+    int width;
+    int height;
+    std::vector<glm::vec3> pixels;
+};
+
+// Read a png, ppm, or other image file that stb_image supports.
+std::optional<RgbImage> read_image(const std::filesystem::path&);
+
+// Convert rgba8 pixels, with rows starting from the bottom, to an image.
+RgbImage
+to_image(int width, int height, std::span<const glm::u8vec4> pixels);
+
+// The viewing distance of FLIP: 0.7 m from a 0.7 m wide 4k monitor.
+constexpr auto default_pixels_per_degree = 67.0F;
+
+// An ImageQuality holds the full-reference metrics of an image.
+struct ImageQuality {
+    double psnr; // over the rgb channels, for a peak of 1
+    double ssim; // mean structural similarity of the luma, 1 when equal
+    double flip; // mean perceptual difference in [0, 1], 0 when equal
+    std::vector<float> ssim_map; // structural similarity of each pixel
+    std::vector<float> flip_map; // perceptual difference of each pixel
+};
+
+// Measure an image against a reference of the same size. The perceptual
+// difference follows LDR-FLIP: color differences after filtering by the
+// contrast sensitivity of the eye, amplified where edges and points differ.
+ImageQuality measure_quality(
+    const RgbImage& image,
+    const RgbImage& reference,
+    float pixels_per_degree = default_pixels_per_degree);
+
+// A RegionScore holds the metrics of one square region of an image.
+struct RegionScore {
+    int x; // column of the region
+    int y; // row of the region, from the bottom
+    double ssim; // mean structural similarity
+    double flip; // mean perceptual difference
+};
+
+// Average the metric maps over square regions of some width in pixels.
+std::vector<RegionScore> region_scores(
+    const ImageQuality&,
+    int width,
+    int height,
+    int region_size);
+
+// The QualityThresholds are the limits an image has to meet to pass.
+struct QualityThresholds {
+    double min_psnr = 0.0;
+    double min_ssim = 0.0;
+    double max_flip = 1.0;
+    double max_region_flip = 1.0; // of the worst region
+};
+
+// Get the names of the thresholds that an image does not meet, empty when
+// it passes.
+std::vector<std::string> quality_failures(
+    const ImageQuality&,
+    std::span<const RegionScore>,
+    const QualityThresholds&);
+
+// Map values in [0, 1] to the colors of a heatmap, dark to bright.
+std::vector<glm::u8vec4> heatmap(std::span<const float> values);
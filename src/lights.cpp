@@ -0,0 +1,154 @@
+#include "lights.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace {
+constexpr auto cluster_x = 16; // screen tiles across
+constexpr auto cluster_y = 16; // screen tiles down
+constexpr auto cluster_z = 24; // depth slices
+constexpr auto max_cluster_lights = 256; // lights kept per cluster
+constexpr auto cluster_count = cluster_x * cluster_y * cluster_z;
+
+constexpr auto transform_group_size = 64; // see transform-comp.glsl
+constexpr auto cull_group_size = 128; // see cull-comp.glsl
+
+constexpr auto spot_fraction = 0.3F; // share of generated spot lights
+constexpr auto min_range = 0.02F; // light range relative to the scene size
+constexpr auto max_range = 0.06F;
+
+// Create an immutable buffer of the given size.
+GLuint create_buffer(GLsizeiptr size, const void* data = nullptr) {
+    auto buffer = GLuint{};
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, data, 0);
+    return buffer;
+}
+} // namespace
+
+std::vector<Light>
+generate_lights(size_t count, const Bounds& bounds, unsigned seed) {
+    auto generator = std::mt19937{seed};
+    auto unit = std::uniform_real_distribution<float>{0.0F, 1.0F};
+    auto signed_unit = std::uniform_real_distribution<float>{-1.0F, 1.0F};
+    auto cone = std::uniform_real_distribution<float>{
+        glm::radians(20.0F),
+        glm::radians(45.0F)};
+    auto size = glm::length(bounds.max - bounds.min);
+    auto range = std::uniform_real_distribution<float>{
+        size * min_range,
+        size * max_range};
+
+    auto lights = std::vector<Light>{};
+    lights.reserve(count);
+    for (auto i = size_t{0}; i < count; i++) {
+        auto light = Light{};
+        auto t = glm::vec3{unit(generator), unit(generator), unit(generator)};
+        light.position = glm::mix(bounds.min, bounds.max, t);
+        light.range = range(generator);
+        light.color = glm::vec3{
+            unit(generator),
+            unit(generator),
+            unit(generator)};
+        if (unit(generator) < spot_fraction) {
+            auto outer = cone(generator);
+            light.cos_outer = std::cos(outer);
+            light.cos_inner = std::cos(outer * 0.8F);
+            // point mostly downwards
+            light.direction = glm::normalize(glm::vec3{
+                signed_unit(generator),
+                -2.0F,
+                signed_unit(generator)});
+        } else {
+            light.cos_outer = -2.0F;
+            light.cos_inner = -1.5F;
+            light.direction = glm::vec3{0.0F, -1.0F, 0.0F};
+        }
+        lights.emplace_back(light);
+    }
+    return lights;
+}
+
+LightClusters::LightClusters()
+    : _transform_shader{"shaders/lights/transform-comp.glsl", defines()},
+      _cull_shader{"shaders/lights/cull-comp.glsl", defines()}, _lights{0},
+      _view_lights{0}, _counts{0}, _indices{0} {
+    _counts = create_buffer(GLsizeiptr{cluster_count * sizeof(GLuint)});
+    _indices = create_buffer(
+        GLsizeiptr{cluster_count * max_cluster_lights * sizeof(GLuint)});
+}
+
+LightClusters::~LightClusters() {
+    glDeleteBuffers(1, &_indices);
+    glDeleteBuffers(1, &_counts);
+    glDeleteBuffers(1, &_view_lights);
+    glDeleteBuffers(1, &_lights);
+}
+
+ShaderDefines LightClusters::defines() {
+    return {
+        {"CLUSTER_X", std::to_string(cluster_x)},
+        {"CLUSTER_Y", std::to_string(cluster_y)},
+        {"CLUSTER_Z", std::to_string(cluster_z)},
+        {"MAX_CLUSTER_LIGHTS", std::to_string(max_cluster_lights)}};
+}
+
+void LightClusters::set_lights(std::span<const Light> lights) {
+    glDeleteBuffers(1, &_view_lights);
+    glDeleteBuffers(1, &_lights);
+    _lights = 0;
+    _view_lights = 0;
+    _light_count = lights.size();
+    if (lights.empty()) {
+        return;
+    }
+    auto size = static_cast<GLsizeiptr>(lights.size_bytes());
+    _lights = create_buffer(size, lights.data());
+    _view_lights = create_buffer(size);
+}
+
+size_t LightClusters::light_count() const {
+    return _light_count;
+}
+
+void LightClusters::cull(const glm::mat4& view, float far) const {
+    if (_light_count == 0) {
+        return;
+    }
+    bind();
+    auto count = static_cast<GLuint>(_light_count);
+
+    _transform_shader.use();
+    auto id = _transform_shader.id();
+    auto location = glGetUniformLocation(id, "u_view");
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(view));
+    location = glGetUniformLocation(id, "u_light_count");
+    glUniform1ui(location, count);
+    glDispatchCompute(
+        (count + transform_group_size - 1) / transform_group_size,
+        1,
+        1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    _cull_shader.use();
+    id = _cull_shader.id();
+    location = glGetUniformLocation(id, "u_light_count");
+    glUniform1ui(location, count);
+    location = glGetUniformLocation(id, "u_cluster_far");
+    glUniform1f(location, far);
+    glDispatchCompute(
+        (cluster_count + cull_group_size - 1) / cull_group_size,
+        1,
+        1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void LightClusters::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _lights);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _view_lights);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _counts);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, _indices);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+// A Light is a point or spot light. The layout matches the std430 Light
+// struct in shaders/common/lights.glsl.
+struct Light {
+    glm::vec3 position; // world-space position
+    float range; // distance at which the light fades to nothing
+    glm::vec3 color;
+    float cos_outer; // cosine of the spot cone's outer angle, -2 for points
+    glm::vec3 direction; // world-space spot direction
+    float cos_inner; // cosine of the spot cone's inner angle
+};
+
+// Generate a reproducible set of randomly placed point and spot lights
+// inside a bounding box.
+std::vector<Light> generate_lights(size_t count, const Bounds&, unsigned seed);
+
+// A LightClusters sorts lights into a froxel grid every frame: the view
+// frustum is split into screen tiles and exponentially spaced depth slices,
+// and a compute shader lists the lights overlapping each cluster.
+class LightClusters {
+  public:
+    LightClusters();
+
+    // Disallow copies and moves.
+    LightClusters(const LightClusters&) = delete;
+    LightClusters(LightClusters&&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+    LightClusters& operator=(LightClusters&&) = delete;
+    ~LightClusters();
+
+    // Get the shader definitions of the grid dimensions.
+    [[nodiscard]] static ShaderDefines defines();
+
+    // Replace the lights.
+    void set_lights(std::span<const Light>);
+
+    // Get the number of lights.
+    [[nodiscard]] size_t light_count() const;
+
+    // Transform the lights into view space and assign them to the clusters
+    // of the view, whose last depth slice starts at the far distance.
+    void cull(const glm::mat4& view, float far) const;
+
+    // Bind the view-space lights and the cluster lists to shader storage
+    // bindings 4-6, matching shaders/common/lights.glsl.
+    void bind() const;
+
+  private:
+    Shader _transform_shader; // moves lights into view space
+    Shader _cull_shader; // fills the cluster lists
+    GLuint _lights; // buffer id of the world-space lights
+    GLuint _view_lights; // buffer id of the view-space lights
+    GLuint _counts; // buffer id of the number of lights per cluster
+    GLuint _indices; // buffer id of the light indices per cluster
+    size_t _light_count = 0;
+};
@@ -1,11 +1,15 @@
 #include "loader.hpp"
+#include "startup.hpp"
 
 #include <fmt/core.h>
 #include <glm/gtx/hash.hpp>
 #include <tiny_obj_loader.hpp>
 #include <stb_image.h>
 
+#include <array>
+#include <cstring>
 #include <fstream>
+#include <optional>
 
 // Use an anonymous namespace for private helper methods.
 namespace {
@@ -18,28 +22,11 @@ struct PathHash {
 
 // A TextureMap is a list of textures and a mapping from filesystem paths to
 // indices in that list.
-struct TextureMap {
-    std::vector<Texture> textures;
+template <typename T> struct TextureMap {
+    std::vector<T> textures;
     std::unordered_map<std::filesystem::path, size_t, PathHash> map;
 };
 
-// Read a wavefront .obj file to an ObjReader and return it.
-tinyobj::ObjReader read_obj(const std::filesystem::path& path) {
-    auto reader = tinyobj::ObjReader{};
-    if (!reader.ParseFromFile(path)) {
-        if (!reader.Error().empty()) {
-            fmt::print(stderr, "TinyObjReader: {}", reader.Error());
-        }
-        std::terminate();
-    }
-
-    if (!reader.Warning().empty()) {
-        fmt::print(stderr, "TinyObjReader: {}", reader.Warning());
-    }
-
-    return reader;
-}
-
 // Replace windows specific path seperators with universal path seperators
 std::string fix_path(std::string path) {
     std::replace(path.begin(), path.end(), '\\', '/');
@@ -63,8 +50,51 @@ TextureData::Format num_components_to_format(int num_components) {
     }
 }
 
-// Read a P3 ppm file to a texture.
-Texture read_ppm(const std::filesystem::path& path) {
+// Create a vertex from face indices to vertex position, normal, and texture-
+// coordinate data.
+Vertex
+gen_vertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& idx) {
+    auto vertex = Vertex{};
+    vertex.position = glm::vec3{
+        attrib.vertices[3 * idx.vertex_index + 0],
+        attrib.vertices[3 * idx.vertex_index + 1],
+        attrib.vertices[3 * idx.vertex_index + 2]};
+    if (idx.normal_index >= 0) {
+        vertex.normal = glm::vec3{
+            attrib.normals[3 * idx.normal_index + 0],
+            attrib.normals[3 * idx.normal_index + 1],
+            attrib.normals[3 * idx.normal_index + 2]};
+    }
+    if (idx.texcoord_index >= 0) {
+        vertex.tex_coord = glm::vec2{
+            attrib.texcoords[2 * idx.texcoord_index + 0],
+            attrib.texcoords[2 * idx.texcoord_index + 1]};
+    }
+    return vertex;
+}
+} // namespace
+
+// Read a wavefront .obj file to an ObjReader and return it.
+tinyobj::ObjReader Loader::read_obj(const std::filesystem::path& path) {
+    auto phase = StartupPhase{"parse obj"};
+    StartupReport::instance().add_read(path);
+    auto reader = tinyobj::ObjReader{};
+    if (!reader.ParseFromFile(path)) {
+        if (!reader.Error().empty()) {
+            fmt::print(stderr, "TinyObjReader: {}", reader.Error());
+        }
+        std::terminate();
+    }
+
+    if (!reader.Warning().empty()) {
+        fmt::print(stderr, "TinyObjReader: {}", reader.Warning());
+    }
+
+    return reader;
+}
+
+// Read a P3 ppm file.
+Loader::PpmImage Loader::read_ppm(const std::filesystem::path& path) {
     auto file = std::ifstream{path};
 
     // skip magic header
@@ -108,20 +138,21 @@ Texture read_ppm(const std::filesystem::path& path) {
         }
     }
 
-    auto texture_data =
-        TextureData{data.data(), width, height, num_components_to_format(3)};
-
-    return Texture(texture_data);
+    return {std::move(data), width, height};
 }
 
 // Read a file to a Texture.
-Texture read_texture(const std::filesystem::path& path) {
+Texture Loader::read_texture(const std::filesystem::path& path) {
     auto width = int{};
     auto height = int{};
     auto num_components = int{};
+    auto phase = std::optional<StartupPhase>{};
+    phase.emplace("decode texture");
+    StartupReport::instance().add_read(path);
     stbi_set_flip_vertically_on_load(true);
     auto* data = stbi_load(path.c_str(), &width, &height, &num_components, 0);
     if (data != nullptr) {
+        phase.reset();
         auto texture_data = TextureData{
             data,
             width,
@@ -131,70 +162,23 @@ Texture read_texture(const std::filesystem::path& path) {
         stbi_image_free(data);
         return texture;
     } else if (path.extension() == ".ppm") {
-        return read_ppm(path);
+        auto image = read_ppm(path);
+        phase.reset();
+        return Texture{TextureData{
+            image.data.data(),
+            image.width,
+            image.height,
+            num_components_to_format(3)}};
     }
 
     fmt::print(stderr, "Bad texture file: {}\n", path.c_str());
     std::terminate();
 }
 
-// Read and load a Texture from a filesystem path if not already loaded.
-void load_texture(TextureMap& data, const std::filesystem::path& path) {
-    if (!data.map.contains(path)) {
-        auto texture = read_texture(path);
-        data.map[path] = data.textures.size();
-        data.textures.emplace_back(std::move(texture));
-    }
-}
-
-// Load all relevant textures used by a wavefront .obj file
-TextureMap load_textures(
-    const std::vector<tinyobj::material_t>& materials,
-    const std::filesystem::path& directory) {
-    auto data = TextureMap{};
-    for (auto& material : materials) {
-        if (!material.diffuse_texname.empty()) {
-            auto path = directory / fix_path(material.diffuse_texname);
-            load_texture(data, path);
-        }
-        if (!material.normal_texname.empty()) {
-            auto path = directory / fix_path(material.normal_texname);
-            load_texture(data, path);
-        }
-        if (!material.specular_texname.empty()) {
-            auto path = directory / fix_path(material.specular_texname);
-            load_texture(data, path);
-        }
-    }
-    return data;
-}
-
-// Create a vertex from face indices to vertex position, normal, and texture-
-// coordinate data.
-Vertex
-gen_vertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& idx) {
-    auto vertex = Vertex{};
-    vertex.position = glm::vec3{
-        attrib.vertices[3 * idx.vertex_index + 0],
-        attrib.vertices[3 * idx.vertex_index + 1],
-        attrib.vertices[3 * idx.vertex_index + 2]};
-    if (idx.normal_index >= 0) {
-        vertex.normal = glm::vec3{
-            attrib.normals[3 * idx.normal_index + 0],
-            attrib.normals[3 * idx.normal_index + 1],
-            attrib.normals[3 * idx.normal_index + 2]};
-    }
-    if (idx.texcoord_index >= 0) {
-        vertex.tex_coord = glm::vec2{
-            attrib.texcoords[2 * idx.texcoord_index + 0],
-            attrib.texcoords[2 * idx.texcoord_index + 1]};
-    }
-    return vertex;
-}
-
 // Generate the texture tangents for a face.
-void generate_tangents(
-    std::vector<Vertex>& vertices, const glm::uvec3& indices) {
+void Loader::generate_tangents(
+    std::vector<Vertex>& vertices,
+    const glm::uvec3& indices) {
     auto& v0 = vertices[indices.x];
     auto& v1 = vertices[indices.y];
     auto& v2 = vertices[indices.z];
@@ -216,13 +200,10 @@ void generate_tangents(
     v2.tex_tangent = tangent;
 }
 
-// Create a Mesh from a wavefront .obj shape.
-Mesh gen_mesh(
+// Create the geometry of a wavefront .obj shape.
+Loader::MeshData Loader::gen_mesh_data(
     const tinyobj::shape_t& s,
-    const tinyobj::attrib_t& attrib,
-    const std::vector<tinyobj::material_t>& materials,
-    const TextureMap& texture_map,
-    const std::filesystem::path& directory) {
+    const tinyobj::attrib_t& attrib) {
     auto offset = 0;
     auto vertices = std::vector<Vertex>{};
     auto indices = std::vector<glm::uvec3>{};
@@ -245,40 +226,144 @@ Mesh gen_mesh(
         generate_tangents(vertices, face);
         indices.emplace_back(face);
     }
+    return {std::move(vertices), std::move(indices)};
+}
+
+// Use an anonymous namespace for private helper methods.
+namespace {
+// Read a file to a HostTexture.
+HostTexture read_host_texture(const std::filesystem::path& path) {
+    auto width = int{};
+    auto height = int{};
+    auto num_components = int{};
+    stbi_set_flip_vertically_on_load(true);
+    auto* data = stbi_load(path.c_str(), &width, &height, &num_components, 4);
+    if (data != nullptr) {
+        auto texels = std::vector<glm::u8vec4>(
+            static_cast<size_t>(width) * static_cast<size_t>(height));
+        std::memcpy(texels.data(), data, texels.size() * sizeof(texels[0]));
+        stbi_image_free(data);
+        return {width, height, std::move(texels)};
+    } else if (path.extension() == ".ppm") {
+        auto image = Loader::read_ppm(path);
+        auto texture = HostTexture{image.width, image.height, {}};
+        for (auto i = size_t{0}; i + 2 < image.data.size(); i += 3) {
+            texture.texels.emplace_back(
+                image.data[i],
+                image.data[i + 1],
+                image.data[i + 2],
+                255);
+        }
+        return texture;
+    }
+
+    fmt::print(stderr, "Bad texture file: {}\n", path.c_str());
+    std::terminate();
+}
+
+// Read and load a texture from a filesystem path if not already loaded.
+template <typename T>
+void load_texture(
+    TextureMap<T>& data,
+    const std::filesystem::path& path,
+    T (*read)(const std::filesystem::path&)) {
+    if (!data.map.contains(path)) {
+        auto phase = StartupPhase{"load texture"};
+        auto texture = read(path);
+        data.map[path] = data.textures.size();
+        data.textures.emplace_back(std::move(texture));
+    }
+}
+
+// Load all relevant textures used by a wavefront .obj file
+template <typename T>
+TextureMap<T> load_textures(
+    const std::vector<tinyobj::material_t>& materials,
+    const std::filesystem::path& directory,
+    T (*read)(const std::filesystem::path&)) {
+    auto data = TextureMap<T>{};
+    for (auto& material : materials) {
+        if (!material.diffuse_texname.empty()) {
+            auto path = directory / fix_path(material.diffuse_texname);
+            load_texture(data, path, read);
+        }
+        if (!material.normal_texname.empty()) {
+            auto path = directory / fix_path(material.normal_texname);
+            load_texture(data, path, read);
+        }
+        if (!material.specular_texname.empty()) {
+            auto path = directory / fix_path(material.specular_texname);
+            load_texture(data, path, read);
+        }
+    }
+    return data;
+}
+
+// Get the indices of the diffuse, normal, and specular textures of a
+// wavefront .obj shape in a texture map.
+template <typename T>
+std::array<std::optional<size_t>, 3> material_textures(
+    const tinyobj::shape_t& s,
+    const std::vector<tinyobj::material_t>& materials,
+    const TextureMap<T>& texture_map,
+    const std::filesystem::path& directory) {
+    auto textures = std::array<std::optional<size_t>, 3>{};
 
     // Assume all faces in a shape share textures
     // and there is at least one face per shape
     auto midx = s.mesh.material_ids[0];
-    auto group = TextureGroup{};
-    if (midx >= 0) {
-        auto mat = materials[midx];
-        if (!mat.diffuse_texname.empty()) {
-            auto path = directory / fix_path(mat.diffuse_texname);
-            if (texture_map.map.contains(path)) {
-                group.diffuse = &texture_map.textures[texture_map.map.at(path)];
-            }
-        }
-        if (!mat.normal_texname.empty()) {
-            auto path = directory / fix_path(mat.normal_texname);
-            if (texture_map.map.contains(path)) {
-                group.normal = &texture_map.textures[texture_map.map.at(path)];
-            }
+    if (midx < 0) {
+        return textures;
+    }
+    const auto& mat = materials[midx];
+    auto names = std::array{
+        mat.diffuse_texname,
+        mat.normal_texname,
+        mat.specular_texname};
+    for (auto i = size_t{0}; i < names.size(); i++) {
+        if (names[i].empty()) {
+            continue;
         }
-        if (!mat.specular_texname.empty()) {
-            auto path = directory / fix_path(mat.specular_texname);
-            if (texture_map.map.contains(path)) {
-                group.specular =
-                    &texture_map.textures[texture_map.map.at(path)];
-            }
+        auto path = directory / fix_path(names[i]);
+        if (texture_map.map.contains(path)) {
+            textures[i] = texture_map.map.at(path);
         }
     }
-    return Mesh{vertices, indices, std::move(group)};
+    return textures;
+}
+
+// Create a Mesh from a wavefront .obj shape.
+Mesh gen_mesh(
+    const tinyobj::shape_t& s,
+    const tinyobj::attrib_t& attrib,
+    const std::vector<tinyobj::material_t>& materials,
+    const TextureMap<Texture>& texture_map,
+    const std::filesystem::path& directory) {
+    auto phase = StartupPhase{"build mesh"};
+    auto data = Loader::gen_mesh_data(s, attrib);
+    auto textures = material_textures(s, materials, texture_map, directory);
+    auto texture = [&texture_map](std::optional<size_t> idx) {
+        return idx ? &texture_map.textures[*idx] : nullptr;
+    };
+    auto group = TextureGroup{
+        texture(textures[0]),
+        texture(textures[1]),
+        texture(textures[2])};
+    return Mesh{data.vertices, data.indices, group};
 }
 } // namespace
 
 Scene Loader::load_obj(const std::filesystem::path& path) {
+    auto phase = StartupPhase{"load obj"};
     auto reader = read_obj(path);
-    auto texture_map = load_textures(reader.GetMaterials(), path.parent_path());
+    auto textures_phase = std::optional<StartupPhase>{};
+    textures_phase.emplace("load textures");
+    auto texture_map = load_textures(
+        reader.GetMaterials(),
+        path.parent_path(),
+        read_texture);
+    textures_phase.reset();
+    auto meshes_phase = StartupPhase{"build meshes"};
     auto meshes = std::vector<Mesh>{};
     for (const auto& s : reader.GetShapes()) {
         meshes.emplace_back(gen_mesh(
@@ -290,3 +375,24 @@ Scene Loader::load_obj(const std::filesystem::path& path) {
     }
     return Scene{std::move(texture_map.textures), std::move(meshes)};
 }
+
+HostScene Loader::load_host_obj(const std::filesystem::path& path) {
+    auto phase = StartupPhase{"load host obj"};
+    auto reader = read_obj(path);
+    const auto& materials = reader.GetMaterials();
+    auto texture_map =
+        load_textures(materials, path.parent_path(), read_host_texture);
+    auto meshes = std::vector<HostMesh>{};
+    for (const auto& s : reader.GetShapes()) {
+        auto data = gen_mesh_data(s, reader.GetAttrib());
+        auto textures =
+            material_textures(s, materials, texture_map, path.parent_path());
+        meshes.emplace_back(HostMesh{
+            std::move(data.vertices),
+            std::move(data.indices),
+            textures[0],
+            textures[1],
+            textures[2]});
+    }
+    return HostScene{std::move(texture_map.textures), std::move(meshes)};
+}
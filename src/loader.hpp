@@ -1,10 +1,56 @@
 #pragma once
 
+#include "host_scene.hpp"
+#include "mesh.hpp"
 #include "scene.hpp"
+#include "texture.hpp"
 
+#include <glm/glm.hpp>
+#include <tiny_obj_loader.hpp>
+
+#include <cstdint>
 #include <filesystem>
+#include <vector>
 
 namespace Loader {
 // Load a wavefront .obj file to a scene.
 Scene load_obj(const std::filesystem::path& path);
+
+// Load a wavefront .obj file to a scene in host memory, without opengl.
+HostScene load_host_obj(const std::filesystem::path& path);
+
+// The steps below make up the loads above, and are exposed so that they can
+// be timed in isolation.
+
+// A MeshData is the geometry of a wavefront .obj shape.
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<glm::uvec3> indices;
+};
+
+// A PpmImage is the rgb pixels of a ppm file, starting from the bottom row.
+struct PpmImage {
+    std::vector<uint8_t> data;
+    int width;
+    int height;
+};
+
+// Parse a wavefront .obj file.
+tinyobj::ObjReader read_obj(const std::filesystem::path& path);
+
+// Read a P3 ppm file.
+PpmImage read_ppm(const std::filesystem::path& path);
+
+// Decode an image file, or a P3 ppm file, and upload it to a texture.
+Texture read_texture(const std::filesystem::path& path);
+
+// Generate the texture tangents of a face.
+void generate_tangents(
+    std::vector<Vertex>& vertices,
+    const glm::uvec3& indices);
+
+// Create the geometry of a wavefront .obj shape, welding the vertices that
+// share position, normal, and texture coordinate indices.
+MeshData
+gen_mesh_data(const tinyobj::shape_t& s, const tinyobj::attrib_t& attrib);
 } // namespace Loader
@@ -1,20 +1,73 @@
 #include "loader.hpp"
 #include "manager.hpp"
+#include "profiler.hpp"
+#include "startup.hpp"
+
+#include <fmt/core.h>
 
 #include <cstdlib>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+void print_usage() {
+    fmt::print(
+        stderr,
+        "usage: project [--headless] [--frames N] [--resolution WxH] "
+        "[--output FILE.png] [--benchmark] [--check-cpu-ssao] "
+        "[--camera-path FILE] [--trace FILE.json] "
+        "[--startup-report FILE.json] [FILE.obj]*\n");
+}
+
+// Parse a positive integer, or get nothing if the text is not one.
+std::optional<int> parse_count(std::string_view text) {
+    auto value = 0;
+    for (auto c : text) {
+        if (c < '0' || c > '9' || value > 100'000'000) {
+            return std::nullopt;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return value > 0 ? std::optional{value} : std::nullopt;
+}
+} // namespace
 
 /*
  * SCREEN SPACE AMBIENT OCCLUSION (SSAO)
  *
  * Usage:
- *  ./project [FILE.obj]*
- * 
- *  Loads the provided sponza model by default.
- *  Additional wavefront .obj scenes can be added via command line arguments.
- *  Beware that the SSAO constants are optimized for the size of the sponza model, and may result in poor looking scenes with differently sized models.
- *  Those constants can be changed in shaders/ssao/depth-frag.glsl.
+ *  ./project [OPTIONS] [FILE.obj]*
+ *
+ *  Loads the wavefront .obj scenes given as command line arguments, or the
+ *  provided sponza model if there are none.
+ *  The SSAO radius and bias are scaled to the bounds of each scene, and the
+ *  SSAO settings can be tuned live with the hotkeys listed below. Sample
+ *  counts are compiled into specialized shader variants.
  *  Scene switching is supported via the hotkeys listed below.
  *
+ * Options:
+ *  --headless: Render offscreen without a window (egl, runs on llvmpipe),
+ *    print the frame timings, and exit
+ *  --frames N: Number of frames to render headless (100, or the whole
+ *    camera path)
+ *  --resolution WxH: Size of the headless frames (1024x1024)
+ *  --output FILE: Write the last headless frame to a png or ppm image
+ *  --benchmark: Run the benchmarks after the headless frames
+ *  --check-cpu-ssao: Compare the cpu ssao and blur to the gpu passes on the
+ *    last headless frame, and exit with 1 if they differ too much
+ *  Any of these options implies --headless.
+ *  --camera-path FILE: Move the camera along a recorded path, looping in a
+ *    window and at a fixed 60 frames per second headless (see paths/)
+ *  --trace FILE.json: Profile cpu scopes and gpu passes, print their rolling
+ *    averages headless, and write the timeline as a chrome trace on exit
+ *  --startup-report FILE.json: Print the time, bytes read and uploaded, and
+ *    peak memory of each startup phase up to the first frame, and write
+ *    them as json
+ *
  * Controls:
  *  - W: Move camera forward
  *  - A: Move camera left
@@ -29,6 +82,28 @@
  *  - Q: Quit
  *  - E: Toggle SSAO
  *  - F: Toggle wireframe mode
+ *  - B: Run the benchmarks (shaders, g-buffer, ssao, cpu and software
+ *    pipelines, lights, frame pacing) and write software.ppm
+ *  - V: Toggle low-latency mode (wait for the gpu before sampling input)
+ *  - Y: Cycle frames in flight (1-3)
+ *  - T: Cycle frame-rate cap (none, 30, 60, 120)
+ *  - R: Toggle dynamic resolution scaling
+ *  - 0: Cycle light count (0, 10, 100, 1000, 10000)
+ *  - H: Cycle ssao resolution divisor (1, 2, 4)
+ *  - /: Toggle deinterleaved ssao
+ *  - C: Toggle compute-shader ssao (hemisphere method)
+ *  - U: Toggle temporal ssao accumulation
+ *  - N: Cycle ssao blur (box, bilateral, bilateral compute)
+ *  - M: Cycle ssao kernel (random, hammersley, halton, poisson disk)
+ *  - X: Toggle blue/white ssao rotation noise
+ *  - [/]: Shrink/grow the ssao radius
+ *  - -/=: Halve/double the ssao sample count (4-64)
+ *  - ,/.: Decrease/increase the ssao intensity
+ *  - ;/': Decrease/increase the ssao power
+ *  - O: Cycle ambient occlusion method (hemisphere, hbao, gtao, sao)
+ *  - G: Toggle the visibility buffer (needs GL_ARB_bindless_texture)
+ *  - P: Toggle the multithreaded software rasterizer (cpu pipeline)
+ *  - Z: Start/stop recording the camera path (to camera.path)
  *  - 1-9: Switch scene
  *
  * Libraries used:
@@ -39,12 +114,95 @@
  *  - fmt
  */
 int main(int argc, char* argv[]) {
-    auto& manager = Manager::instance();
-    manager.add_scene(Loader::load_obj("sponza/sponza.obj"));
+    // Startup is timed from here.
+    auto& startup = StartupReport::instance();
     auto args = std::span(argv + 1, static_cast<size_t>(argc - 1));
-    for (auto& obj_file : args) {
-        manager.add_scene(Loader::load_obj(obj_file));
+    auto headless = std::optional<HeadlessSettings>{};
+    auto obj_files = std::vector<const char*>{};
+    auto camera_path = std::optional<CameraPath>{};
+    auto trace = std::optional<std::string_view>{};
+    for (auto i = size_t{0}; i < args.size(); i++) {
+        auto arg = std::string_view{args[i]};
+        if (!arg.starts_with("--")) {
+            obj_files.emplace_back(args[i]);
+            continue;
+        }
+        if (arg == "--camera-path" && i + 1 < args.size()) {
+            camera_path = CameraPath::load(args[++i]);
+            if (!camera_path) {
+                fmt::print(stderr, "could not load {}\n", args[i]);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+        if (arg == "--trace" && i + 1 < args.size()) {
+            trace = args[++i];
+            continue;
+        }
+        if (arg == "--startup-report" && i + 1 < args.size()) {
+            startup.set_output(args[++i]);
+            continue;
+        }
+        if (!headless) {
+            headless.emplace();
+        }
+        if (arg == "--headless") {
+            continue;
+        }
+        if (arg == "--benchmark") {
+            headless->benchmark = true;
+            continue;
+        }
+        if (arg == "--check-cpu-ssao") {
+            headless->check_cpu_ssao = true;
+            continue;
+        }
+        if (i + 1 == args.size()) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+        auto value = std::string_view{args[++i]};
+        auto x = value.find('x');
+        auto frames = parse_count(value);
+        auto width = parse_count(value.substr(0, x));
+        auto height = x == std::string_view::npos
+                          ? std::nullopt
+                          : parse_count(value.substr(x + 1));
+        if (arg == "--frames" && frames) {
+            headless->frames = *frames;
+        } else if (arg == "--resolution" && width && height) {
+            headless->resolution = {*width, *height};
+        } else if (arg == "--output") {
+            headless->output = value;
+        } else {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Profile from the start so that loading is part of the trace.
+    auto& profiler = Profiler::instance();
+    profiler.set_enabled(trace.has_value());
+    profiler.set_thread_name("main");
+
+    auto& manager = Manager::instance(headless);
+    if (camera_path) {
+        manager.set_camera_path(std::move(*camera_path));
+    }
+    if (obj_files.empty()) {
+        obj_files.emplace_back("sponza/sponza.obj");
+    }
+    for (const auto* obj_file : obj_files) {
+        manager.add_scene(Loader::load_obj(obj_file), obj_file);
     }
     manager.loop();
-    return EXIT_SUCCESS;
+
+    if (trace) {
+        if (profiler.write_chrome_trace(*trace)) {
+            fmt::print("wrote the trace to {}\n", *trace);
+        } else {
+            fmt::print(stderr, "could not write {}\n", *trace);
+        }
+    }
+    return manager.checks_passed() ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -1,20 +1,90 @@
 #include "manager.hpp"
 
+#include "benchmarks.hpp"
+#include "bindless.hpp"
+#include "cpu_ssao.hpp"
+#include "frame_pacer.hpp"
+#include "gpu_timer.hpp"
+#include "image_metrics.hpp"
+#include "loader.hpp"
+#include "profiler.hpp"
+#include "render_graph.hpp"
+#include "sampling.hpp"
+#include "startup.hpp"
+
 #include <fmt/core.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Use the anonymous namespace for applicable private constants/functions
 namespace {
-constexpr auto g_width = uint16_t{1024}; // window width
-constexpr auto g_height = uint16_t{1024}; // window height
+constexpr auto g_width = uint16_t{1024}; // initial window width
+constexpr auto g_height = uint16_t{1024}; // initial window height
 
 constexpr auto fov = glm::radians(45.0F); // field-of-view
-auto projection = glm::infinitePerspective(fov, 1.0F, 1.0F);
+
+constexpr auto capacity_step = 256; // granularity of render target sizes
+constexpr auto frame_timer_count = size_t{4}; // frames timed at once
+constexpr auto frame_time_headroom = 0.9; // fraction of a frame for the gpu
+constexpr auto default_target_fps = 60; // resolution target without a cap
+
+// The FrameUniforms are the per-frame values shared by every pass. The layout
+// matches the std140 Frame block in shaders/common/frame.glsl.
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::mat4 inverse_projection;
+    glm::vec2 uv_scale; // fraction of each render target covered by the frame
+    glm::vec2 render_size; // size of the frame in pixels
+};
+
+constexpr auto min_sample_count = 4; // fewest live-tuned kernel samples
+
+// The SsaoUniforms are the ssao settings read by the ssao, blur, and
+// lighting passes. The layout matches the std140 Ssao block in
+// shaders/common/ssao.glsl.
+struct SsaoUniforms {
+    float radius;
+    float bias;
+    float intensity;
+    float power;
+    int sample_count;
+    int noise_size;
+    int directions;
+    int slices;
+    int steps;
+    int blur_radius;
+    alignas(16) std::array<glm::vec4, max_sample_count> samples; // kernel
+};
+
+constexpr auto ssao_radius_fraction = 0.1F; // of the scene bounds diagonal
+constexpr auto ssao_bias_fraction = 0.05F; // of the ssao radius
+constexpr auto ao_method_count = 4; // number of AoMethod values
+constexpr auto sao_max_level = 5; // coarsest pyramid level read by sao
+constexpr auto pyramid_group_size = 8; // see pyramid-comp.glsl
+constexpr auto blur_method_count = 3; // number of BlurMethod values
+constexpr auto kernel_pattern_count = 5; // number of KernelPattern values
+
+constexpr auto light_seed = 1U; // seed of the generated lights
+constexpr auto lit_ambient = 0.1F; // ambient intensity when lights are on
+constexpr auto light_counts = std::array<size_t, 5>{0, 10, 100, 1000, 10000};
+
+constexpr auto tick_rate = 240; // simulation updates per second
+constexpr auto record_interval = tick_rate / 4; // ticks between camera keys
+constexpr auto recorded_path = "camera.path"; // file of recorded paths
+constexpr auto path_frame_rate = 60.0F; // headless frames per path second
+constexpr auto default_headless_frames = 100; // frames without a path
 
 // Handle debug messages coming from opengl
 void GLAPIENTRY gl_message_callback(
@@ -31,11 +101,9 @@ void GLAPIENTRY gl_message_callback(
     }
 };
 
-// Toggle opengl wireframe mode
-void toggle_wireframe() {
-    static GLenum mode = GL_FILL;
-    mode = mode == GL_FILL ? GL_LINE : GL_FILL;
-    glPolygonMode(GL_FRONT_AND_BACK, mode);
+// Set opengl wireframe mode
+void set_wireframe(bool wireframe) {
+    glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
 }
 
 // Initialize the geometry shader
@@ -44,9 +112,6 @@ Shader geometry_shader() {
         Shader{"shaders/geometry/vert.glsl", "shaders/geometry/frag.glsl"};
 
     sh.use();
-    auto projection_loc = glGetUniformLocation(sh.id(), "u_projection");
-    glUniformMatrix4fv(projection_loc, 1, GL_FALSE, glm::value_ptr(projection));
-
     auto diff_loc = glGetUniformLocation(sh.id(), "u_diffuse");
     glUniform1i(diff_loc, 0);
 
@@ -59,11 +124,53 @@ Shader geometry_shader() {
     return sh;
 }
 
-// Initialize the lighting shader.
-Shader lighting_shader(bool enable_ssao) {
-    auto sh =
-        Shader{"shaders/lighting/vert.glsl", "shaders/lighting/frag.glsl"};
+// Initialize the visibility shader.
+Shader visibility_shader() {
+    return Shader{
+        "shaders/visibility/vert.glsl",
+        "shaders/visibility/frag.glsl"};
+}
+
+// Initialize the visibility resolve shader.
+Shader resolve_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/visibility/resolve-frag.glsl"};
 
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_visibility");
+    glUniform1i(location, 0);
+
+    return sh;
+}
+
+// Set the model and view matrices of a shader that transforms the scene.
+void set_transforms(GLuint program, const glm::mat4& view) {
+    auto scale = 1.0F / 1.0F;
+    auto model = glm::scale(glm::mat4{1.0}, glm::vec3{scale});
+    auto model_loc = glGetUniformLocation(program, "u_model");
+    glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
+
+    auto view_loc = glGetUniformLocation(program, "u_view");
+    glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
+}
+
+// Start counting the samples that pass the depth test, if the query exists.
+void begin_samples(GLuint query) {
+    if (query != 0) {
+        glBeginQuery(GL_SAMPLES_PASSED, query);
+    }
+}
+
+// Stop counting passed samples, if the query exists.
+void end_samples(GLuint query) {
+    if (query != 0) {
+        glEndQuery(GL_SAMPLES_PASSED);
+    }
+}
+
+// Initialize a lighting shader variant.
+void init_lighting_shader(const Shader& sh, const ShaderDefines&) {
     sh.use();
     auto location = glGetUniformLocation(sh.id(), "u_diffuse_spec");
     glUniform1i(location, 0);
@@ -71,77 +178,277 @@ Shader lighting_shader(bool enable_ssao) {
     location = glGetUniformLocation(sh.id(), "u_occlusion");
     glUniform1i(location, 1);
 
-    location = glGetUniformLocation(sh.id(), "u_enable_ssao");
-    glUniform1i(location, enable_ssao);
+    location = glGetUniformLocation(sh.id(), "u_normal");
+    glUniform1i(location, 2);
+
+    location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 3);
+}
+
+// Initialize an ambient occlusion shader variant.
+void init_ao_shader(const Shader& sh, const ShaderDefines&) {
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 0);
+
+    location = glGetUniformLocation(sh.id(), "u_normal");
+    glUniform1i(location, 1);
+
+    location = glGetUniformLocation(sh.id(), "u_noise");
+    glUniform1i(location, 2);
+}
+
+// Print the live-tuned ssao settings of a simulation state.
+void print_ssao_tuning(const FrameState& state) {
+    fmt::print(
+        "ssao radius x{:.2f}, {} samples, intensity {:.2f}, power {:.2f}\n",
+        state.ssao_radius_scale,
+        state.ssao_sample_count,
+        state.ssao_intensity,
+        state.ssao_power);
+}
+
+// Get the number of hemisphere kernel samples taken per frame.
+int frame_sample_count(const SsaoSettings& settings) {
+    return settings.temporal ? settings.temporal_sample_count
+                             : settings.sample_count;
+}
+
+// Initialize the shader that builds the view distance pyramid of sao.
+Shader sao_pyramid_shader() {
+    auto sh = Shader{"shaders/ssao/pyramid-comp.glsl"};
+
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 0);
+
+    location = glGetUniformLocation(sh.id(), "u_pyramid");
+    glUniform1i(location, 1);
+
     return sh;
 }
 
-// Generate the position offsets that will be used to sample around each
-// fragment in the ssao shader.
-std::array<glm::vec3, 64> generate_sample_kernel() {
-    auto generator = std::default_random_engine{std::random_device{}()};
-    auto random_float = std::uniform_real_distribution<GLfloat>{0.0, 1.0};
-    auto kernel = std::array<glm::vec3, 64>{};
-    for (auto i = unsigned{0}; i < kernel.size(); i++) {
-        auto sample = glm::vec3(
-            random_float(generator) * 2.0 - 1.0,
-            random_float(generator) * 2.0 - 1.0,
-            random_float(generator));
-        sample = glm::normalize(sample);
-        sample *= random_float(generator);
-        auto scale = i / 64.0F;
-        scale = glm::mix(0.1F, 1.0F, scale * scale);
-        sample *= scale;
-        kernel[i] = sample;
-    }
-    return kernel;
-};
+// Initialize the box blur shader.
+Shader ssao_box_blur_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/box-blur-frag.glsl"};
 
-// Initialize the ssao shader.
-Shader ssao_shader() {
-    auto sh =
-        Shader{"shaders/lighting/vert.glsl", "shaders/ssao/depth-frag.glsl"};
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_occlusion");
+    glUniform1i(location, 0);
+
+    return sh;
+}
+
+// Initialize a bilateral blur shader variant.
+void init_blur_shader(const Shader& sh, const ShaderDefines&) {
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_occlusion");
+    glUniform1i(location, 0);
+
+    location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 1);
+
+    location = glGetUniformLocation(sh.id(), "u_normal");
+    glUniform1i(location, 2);
+}
+
+// Initialize the shader that reduces depth and normals for ssao.
+Shader ssao_downsample_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/downsample-frag.glsl"};
 
     sh.use();
-    auto location = glGetUniformLocation(sh.id(), "u_position");
+    auto location = glGetUniformLocation(sh.id(), "u_depth");
     glUniform1i(location, 0);
 
     location = glGetUniformLocation(sh.id(), "u_normal");
     glUniform1i(location, 1);
 
-    location = glGetUniformLocation(sh.id(), "u_noise");
+    return sh;
+}
+
+// Initialize the shader that upsamples reduced-resolution occlusion.
+Shader ssao_upsample_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/upsample-frag.glsl"};
+
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_occlusion");
+    glUniform1i(location, 0);
+
+    location = glGetUniformLocation(sh.id(), "u_reduced_depth");
+    glUniform1i(location, 1);
+
+    location = glGetUniformLocation(sh.id(), "u_depth");
     glUniform1i(location, 2);
 
-    auto samples = generate_sample_kernel();
-    for (auto i = size_t{0}; i < samples.size(); i++) {
-        location = glGetUniformLocation(
-            sh.id(),
-            fmt::format("u_samples[{}]", i).c_str());
-        glUniform3fv(location, 1, glm::value_ptr(samples[i]));
-    }
+    return sh;
+}
+
+// Initialize the shader that splits ssao inputs into an atlas of tiles.
+Shader ssao_deinterleave_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/deinterleave-frag.glsl"};
 
-    location = glGetUniformLocation(sh.id(), "u_projection");
-    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(projection));
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 0);
 
-    auto scale = glm::vec2{g_width / 4.0, g_height / 4.0};
-    location = glGetUniformLocation(sh.id(), "u_noise_scale");
-    glUniform2fv(location, 1, glm::value_ptr(scale));
+    location = glGetUniformLocation(sh.id(), "u_normal");
+    glUniform1i(location, 1);
 
     return sh;
 }
 
-// Initialize the blur shader.
-Shader ssao_blur_shader() {
-    auto sh =
-        Shader{"shaders/lighting/vert.glsl", "shaders/ssao/blur-frag.glsl"};
+// Initialize the shader that puts atlas tiles back in place.
+Shader ssao_reinterleave_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/reinterleave-frag.glsl"};
+
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_occlusion");
+    glUniform1i(location, 0);
+
+    return sh;
+}
+
+// Initialize the shader that accumulates occlusion over frames.
+Shader ssao_temporal_shader() {
+    auto sh = Shader{
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/temporal-frag.glsl"};
 
     sh.use();
     auto location = glGetUniformLocation(sh.id(), "u_occlusion");
     glUniform1i(location, 0);
 
+    location = glGetUniformLocation(sh.id(), "u_depth");
+    glUniform1i(location, 1);
+
+    location = glGetUniformLocation(sh.id(), "u_normal");
+    glUniform1i(location, 2);
+
+    location = glGetUniformLocation(sh.id(), "u_history");
+    glUniform1i(location, 3);
+
+    return sh;
+}
+
+// Initialize the upscale shader.
+Shader upscale_shader() {
+    auto sh = Shader{"shaders/lighting/vert.glsl", "shaders/upscale/frag.glsl"};
+
+    sh.use();
+    auto location = glGetUniformLocation(sh.id(), "u_color");
+    glUniform1i(location, 0);
+
     return sh;
 }
 
+// Create a sampler that filters linearly and clamps to the edges.
+GLuint generate_linear_sampler() {
+    auto sampler = GLuint{};
+    glCreateSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return sampler;
+}
+
+// Create the uniform buffer holding the FrameUniforms and bind it to the
+// Frame block binding.
+GLuint generate_frame_buffer() {
+    auto ubo = GLuint{};
+    glCreateBuffers(1, &ubo);
+    glNamedBufferStorage(
+        ubo,
+        sizeof(FrameUniforms),
+        nullptr,
+        GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+    return ubo;
+}
+
+// Create the uniform buffer holding the SsaoUniforms and bind it to the Ssao
+// block binding.
+GLuint generate_ssao_buffer() {
+    auto ubo = GLuint{};
+    glCreateBuffers(1, &ubo);
+    glNamedBufferStorage(
+        ubo,
+        sizeof(SsaoUniforms),
+        nullptr,
+        GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 1, ubo);
+    return ubo;
+}
+
+// Print the mean and spread of some frame times after the first frame, and
+// the time of the first frame when it is known.
+void print_frame_times(
+    const char* name,
+    std::optional<double> first,
+    std::span<const double> times) {
+    if (times.empty()) {
+        return;
+    }
+    auto sorted = std::vector<double>(times.begin(), times.end());
+    std::sort(sorted.begin(), sorted.end());
+    auto mean = 0.0;
+    for (auto ms : sorted) {
+        mean += ms / static_cast<double>(sorted.size());
+    }
+    auto percentile = [&sorted](double p) {
+        auto i = static_cast<size_t>(
+            p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[i];
+    };
+    fmt::print(
+        "{:<8} {:>8} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f}\n",
+        name,
+        first ? fmt::format("{:.2f}", *first) : "-",
+        mean,
+        sorted.front(),
+        percentile(0.5),
+        percentile(0.95),
+        sorted.back());
+}
+
+// Generate a framebuffer with color and depth renderbuffers of some size,
+// and return its opengl id.
+GLuint generate_output_framebuffer(
+    glm::ivec2 size,
+    std::array<GLuint, 2>& renderbuffers) {
+    glCreateRenderbuffers(2, renderbuffers.data());
+    glNamedRenderbufferStorage(renderbuffers[0], GL_RGBA8, size.x, size.y);
+    glNamedRenderbufferStorage(
+        renderbuffers[1],
+        GL_DEPTH_COMPONENT24,
+        size.x,
+        size.y);
+
+    auto fbo = GLuint{};
+    glCreateFramebuffers(1, &fbo);
+    glNamedFramebufferRenderbuffer(
+        fbo,
+        GL_COLOR_ATTACHMENT0,
+        GL_RENDERBUFFER,
+        renderbuffers[0]);
+    glNamedFramebufferRenderbuffer(
+        fbo,
+        GL_DEPTH_ATTACHMENT,
+        GL_RENDERBUFFER,
+        renderbuffers[1]);
+    return fbo;
+}
+
 // Generate a screen-filling quad Vertex Array Object and return its opengl id.
 GLuint generate_quad() {
     auto data = std::array<float, 20>{
@@ -183,33 +490,100 @@ GLuint generate_quad() {
     return vao;
 }
 
-// Create a texture of random noise for use in the ssao shader.
-GLuint generate_noise() {
-    auto generator = std::default_random_engine{std::random_device{}()};
-    auto random_float = std::uniform_real_distribution<GLfloat>{0.0, 1.0};
-    auto noise = std::vector<glm::vec3>{};
-    for (auto i = 0; i < 16; i++) {
-        auto sample = glm::vec3(
-            random_float(generator) * 2.0 - 1.0,
-            random_float(generator) * 2.0 - 1.0,
-            0.0);
-        noise.emplace_back(sample);
-    }
+// Create a texture to copy the frame region of a render target into.
+GLuint create_capture(GLenum format, glm::ivec2 size) {
+    auto tex = GLuint{};
+    glCreateTextures(GL_TEXTURE_2D, 1, &tex);
+    glTextureStorage2D(tex, 1, format, size.x, size.y);
+    return tex;
+}
+
+// Read back the frame region of a capture texture as floats.
+std::vector<float> read_capture(
+    GLuint tex,
+    glm::ivec2 size,
+    GLenum format,
+    size_t components) {
+    auto pixels = std::vector<float>(
+        static_cast<size_t>(size.x) * static_cast<size_t>(size.y) *
+        components);
+    glGetTextureSubImage(
+        tex,
+        0,
+        0,
+        0,
+        0,
+        size.x,
+        size.y,
+        1,
+        format,
+        GL_FLOAT,
+        static_cast<GLsizei>(pixels.size() * sizeof(float)),
+        pixels.data());
+    return pixels;
+}
 
+// Create a square texture of kernel rotations for use in the ssao shader.
+GLuint generate_noise(const std::vector<glm::vec3>& noise, int size) {
     auto tex = GLuint{};
     glCreateTextures(GL_TEXTURE_2D, 1, &tex);
     glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(tex, 1, GL_RGBA32F, 4, 4);
-    glTextureSubImage2D(tex, 0, 0, 0, 4, 4, GL_RGBA, GL_FLOAT, noise.data());
+    glTextureStorage2D(tex, 1, GL_RGBA32F, size, size);
+    glTextureSubImage2D(
+        tex,
+        0,
+        0,
+        0,
+        size,
+        size,
+        GL_RGB,
+        GL_FLOAT,
+        noise.data());
 
     return tex;
 }
 
-// Update the camera based on change in time and held keys.
-void update_camera(Camera& camera, uint32_t delta_time) {
+// Create the ring of whole-frame gpu timers. They enclose the pass timers of
+// the render graph, so they use timestamps.
+std::vector<GpuTimer> generate_frame_timers() {
+    auto timers = std::vector<GpuTimer>{};
+    for (auto i = size_t{0}; i < frame_timer_count; i++) {
+        timers.emplace_back(GpuTimer::Kind::timestamps);
+    }
+    return timers;
+}
+
+// Print the rolling average cpu and gpu time of every profiled scope, and
+// how many frames of pass timers were reused before their results came.
+void print_profile(size_t skipped_timer_sets) {
+    auto averages = Profiler::instance().averages();
+    fmt::print("{:<24} {:>8} {:>8}\n", "scope", "cpu ms", "gpu ms");
+    for (auto i = size_t{0}; i < averages.size(); i++) {
+        const auto& average = averages[i];
+        auto cpu = average.gpu ? std::string{"-"}
+                               : fmt::format("{:.3f}", average.ms);
+        auto gpu = average.gpu ? fmt::format("{:.3f}", average.ms)
+                               : std::string{"-"};
+        // The cpu time of a pass comes right before its gpu time.
+        if (!average.gpu && i + 1 < averages.size() &&
+            averages[i + 1].gpu && averages[i + 1].name == average.name) {
+            gpu = fmt::format("{:.3f}", averages[++i].ms);
+        }
+        fmt::print("{:<24} {:>8} {:>8}\n", average.name, cpu, gpu);
+    }
+    if (skipped_timer_sets > 0) {
+        fmt::print(
+            "{} frames of gpu pass times were still in flight and are "
+            "missing\n",
+            skipped_timer_sets);
+    }
+}
+
+// Update the camera based on change in time (ms) and held keys.
+void update_camera(Camera& camera, float delta_time) {
     auto step = delta_time / 100.0F;
     const auto* state = SDL_GetKeyboardState(nullptr);
 
@@ -246,37 +620,50 @@ void update_camera(Camera& camera, uint32_t delta_time) {
 }
 } // namespace
 
-Manager::Manager() {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::terminate();
-    }
-
-    constexpr auto gl_major_version = 4;
-    constexpr auto gl_minor_version = 6;
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, gl_major_version);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, gl_minor_version);
-    SDL_GL_SetAttribute(
-        SDL_GL_CONTEXT_PROFILE_MASK,
-        SDL_GL_CONTEXT_PROFILE_CORE);
-
-    _window = SDL_CreateWindow(
-        "rend",
-        SDL_WINDOWPOS_CENTERED,
-        SDL_WINDOWPOS_CENTERED,
-        g_width,
-        g_height,
-        SDL_WINDOW_OPENGL);
+Manager::Manager(std::optional<HeadlessSettings> headless)
+    : _headless(std::move(headless)) {
+    auto phase = StartupPhase{"create manager"};
+    auto step = std::optional<StartupPhase>{};
+    step.emplace("create context");
+    auto size = glm::ivec2{g_width, g_height};
+    auto get_proc_address = GLADloadproc{};
+    if (_headless) {
+        size = _headless->resolution;
+        _headless_context.emplace();
+        get_proc_address = HeadlessContext::get_proc_address;
+    } else {
+        if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+            std::terminate();
+        }
 
-    if (_window == nullptr) {
-        std::terminate();
-    }
+        constexpr auto gl_major_version = 4;
+        constexpr auto gl_minor_version = 6;
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, gl_major_version);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, gl_minor_version);
+        SDL_GL_SetAttribute(
+            SDL_GL_CONTEXT_PROFILE_MASK,
+            SDL_GL_CONTEXT_PROFILE_CORE);
+
+        _window = SDL_CreateWindow(
+            "rend",
+            SDL_WINDOWPOS_CENTERED,
+            SDL_WINDOWPOS_CENTERED,
+            size.x,
+            size.y,
+            SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE);
+
+        if (_window == nullptr) {
+            std::terminate();
+        }
 
-    _context = SDL_GL_CreateContext(_window);
-    if (_context == nullptr) {
-        std::terminate();
+        _context = SDL_GL_CreateContext(_window);
+        if (_context == nullptr) {
+            std::terminate();
+        }
+        get_proc_address = SDL_GL_GetProcAddress;
     }
 
-    if (gladLoadGLLoader(SDL_GL_GetProcAddress) == 0) {
+    if (gladLoadGLLoader(get_proc_address) == 0) {
         std::terminate();
     }
 
@@ -287,91 +674,93 @@ Manager::Manager() {
     glEnable(GL_LINE_SMOOTH);
     glEnable(GL_POLYGON_SMOOTH);
 
-    glViewport(0, 0, g_width, g_height);
+    // Without a window, the last pass renders into a framebuffer of the
+    // frame size, and the resolution stays fixed.
+    if (_headless) {
+        _output = generate_output_framebuffer(size, _output_renderbuffers);
+        glBindFramebuffer(GL_FRAMEBUFFER, _output);
+        _state.dynamic_resolution = false;
+    }
+
+    _state.window_size = size;
+    _window_size = _state.window_size;
+    _render_size = _window_size;
+    _capacity = _window_size;
+    glViewport(0, 0, size.x, size.y);
+    step.emplace("create shaders");
     _geometry_shader.emplace(geometry_shader());
-    _ssao_shader.emplace(ssao_shader());
-    _ssao_blur_shader.emplace(ssao_blur_shader());
-    _lighting_shader.emplace(lighting_shader(_enable_ssao));
-    construct_gbuffer();
-    construct_ssao_buffers();
+    _bindless = load_bindless_textures(get_proc_address);
+    if (_bindless) {
+        _visibility_shader.emplace(visibility_shader());
+        _resolve_shader.emplace(resolve_shader());
+    }
+    _ssao_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/depth-frag.glsl",
+        init_ao_shader);
+    _ssao_compute_shaders.emplace(
+        "shaders/ssao/compute-comp.glsl",
+        init_ao_shader);
+    _hbao_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/hbao-frag.glsl",
+        init_ao_shader);
+    _gtao_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/gtao-frag.glsl",
+        init_ao_shader);
+    _sao_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/sao-frag.glsl",
+        init_ao_shader);
+    _sao_pyramid_shader.emplace(sao_pyramid_shader());
+    _ssao_box_blur_shader.emplace(ssao_box_blur_shader());
+    _ssao_blur_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/ssao/blur-frag.glsl",
+        init_blur_shader);
+    _ssao_blur_compute_shaders.emplace(
+        "shaders/ssao/blur-comp.glsl",
+        init_blur_shader);
+    _ssao_downsample_shader.emplace(ssao_downsample_shader());
+    _ssao_upsample_shader.emplace(ssao_upsample_shader());
+    _ssao_deinterleave_shader.emplace(ssao_deinterleave_shader());
+    _ssao_reinterleave_shader.emplace(ssao_reinterleave_shader());
+    _ssao_temporal_shader.emplace(ssao_temporal_shader());
+    _lighting_shaders.emplace(
+        "shaders/lighting/vert.glsl",
+        "shaders/lighting/frag.glsl",
+        init_lighting_shader);
+    _upscale_shader.emplace(upscale_shader());
+    step.emplace("create resources");
+    _lights.emplace();
+    _graph.emplace();
+    _graph->set_output(_output);
+    _frame_ubo = generate_frame_buffer();
+    _ssao_ubo = generate_ssao_buffer();
+    _linear_sampler = generate_linear_sampler();
     _quad = generate_quad();
-    _noise_tex = generate_noise();
-}
-
-void Manager::construct_gbuffer() {
-    glCreateFramebuffers(1, &_gbuffer);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &_gposition);
-    glTextureParameteri(_gposition, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gposition, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gposition, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(_gposition, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(_gposition, 1, GL_RGBA16F, g_width, g_height);
-    glNamedFramebufferTexture(_gbuffer, GL_COLOR_ATTACHMENT0, _gposition, 0);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &_gnormal);
-    glTextureParameteri(_gnormal, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gnormal, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gnormal, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(_gnormal, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(_gnormal, 1, GL_RGBA16F, g_width, g_height);
-    glNamedFramebufferTexture(_gbuffer, GL_COLOR_ATTACHMENT1, _gnormal, 0);
-
-    glCreateTextures(GL_TEXTURE_2D, 1, &_gdiffuse);
-    glTextureParameteri(_gdiffuse, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gdiffuse, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(_gdiffuse, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(_gdiffuse, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(_gdiffuse, 1, GL_RGBA8, g_width, g_height);
-    glNamedFramebufferTexture(_gbuffer, GL_COLOR_ATTACHMENT2, _gdiffuse, 0);
-
-    auto buffers = std::array<GLenum, 3>{
-        GL_COLOR_ATTACHMENT0,
-        GL_COLOR_ATTACHMENT1,
-        GL_COLOR_ATTACHMENT2};
-    glNamedFramebufferDrawBuffers(_gbuffer, 3, buffers.data());
-
-    auto render_buffer = GLuint{};
-    glCreateRenderbuffers(1, &render_buffer);
-    glNamedRenderbufferStorage(
-        render_buffer,
-        GL_DEPTH_COMPONENT,
-        g_width,
-        g_height);
-    glNamedFramebufferRenderbuffer(
-        _gbuffer,
-        GL_DEPTH_ATTACHMENT,
-        GL_RENDERBUFFER,
-        render_buffer);
-}
-
-void Manager::construct_ssao_buffers() {
-    auto tex = GLuint{};
-    glCreateFramebuffers(1, &_ssao_buffer);
-    glCreateTextures(GL_TEXTURE_2D, 1, &tex);
-    glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(tex, 1, GL_R16F, g_width, g_height);
-    glNamedFramebufferTexture(_ssao_buffer, GL_COLOR_ATTACHMENT0, tex, 0);
-    _ssao_color_tex = tex;
-
-    glCreateFramebuffers(1, &_ssao_blur_buffer);
-    glCreateTextures(GL_TEXTURE_2D, 1, &tex);
-    glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTextureStorage2D(tex, 1, GL_R16F, g_width, g_height);
-    glNamedFramebufferTexture(_ssao_blur_buffer, GL_COLOR_ATTACHMENT0, tex, 0);
-    _ssao_color_blur_tex = tex;
+    if (_ssao_settings.seed == 0) {
+        _ssao_settings.seed = std::random_device{}();
+    }
 }
 
 Manager::~Manager() {
-    SDL_GL_DeleteContext(_context);
-    SDL_DestroyWindow(_window);
-    SDL_Quit();
+    _graph.reset();
+    glDeleteTextures(2, _ssao_history.data());
+    glDeleteTextures(1, &_sao_pyramid);
+    _frame_timers.clear();
+    _scenes.clear();
+    _lights.reset();
+    glDeleteFramebuffers(1, &_output);
+    glDeleteRenderbuffers(2, _output_renderbuffers.data());
+    if (_headless_context) {
+        _headless_context.reset();
+    } else {
+        SDL_GL_DeleteContext(_context);
+        SDL_DestroyWindow(_window);
+        SDL_Quit();
+    }
 }
 
 void Manager::render() {
@@ -379,58 +768,954 @@ void Manager::render() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (_scene_idx) {
-        // PASS 1: Fill the G-buffer
-        _geometry_shader->use();
-        auto scale = 1.0F / 1.0F;
-        auto model = glm::scale(glm::mat4{1.0}, glm::vec3{scale});
-        auto model_loc =
-            glGetUniformLocation(_geometry_shader->id(), "u_model");
-        glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
-
-        auto view = _camera.transform();
-        auto view_loc = glGetUniformLocation(_geometry_shader->id(), "u_view");
-        glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
-
-        glBindFramebuffer(GL_FRAMEBUFFER, _gbuffer);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        _scenes[*_scene_idx].render();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // PASS 2: Generate the ssao texture
-        glBindFramebuffer(GL_FRAMEBUFFER, _ssao_buffer);
-        glClear(GL_COLOR_BUFFER_BIT);
-        _ssao_shader->use();
-        glBindTextureUnit(0, _gposition);
-        glBindTextureUnit(1, _gnormal);
-        glBindTextureUnit(2, _noise_tex);
-        draw_quad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // PASS 3: Blur the ssao texture
-        glBindFramebuffer(GL_FRAMEBUFFER, _ssao_blur_buffer);
-        glClear(GL_COLOR_BUFFER_BIT);
-        _ssao_blur_shader->use();
-        glBindTextureUnit(0, _ssao_color_tex);
-        draw_quad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // PASS 4: Calculate the final lighting and output to screen
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        _lighting_shader->use();
-        glBindTextureUnit(0, _gdiffuse);
-        glBindTextureUnit(1, _ssao_color_blur_tex);
-        draw_quad();
-    }
-
-    SDL_GL_SwapWindow(_window);
-}
-
-void Manager::toggle_ssao() {
-    _enable_ssao = !_enable_ssao;
-    _lighting_shader->use();
-    auto location =
-        glGetUniformLocation(_lighting_shader->id(), "u_enable_ssao");
-    glUniform1i(location, _enable_ssao);
+        auto aspect = static_cast<float>(_window_size.x) /
+                      static_cast<float>(_window_size.y);
+        auto uniforms = FrameUniforms{};
+        uniforms.projection = glm::infinitePerspective(fov, aspect, 1.0F);
+        uniforms.inverse_projection = glm::inverse(uniforms.projection);
+        _projection = uniforms.projection;
+        uniforms.uv_scale = glm::vec2{_render_size} / glm::vec2{_capacity};
+        uniforms.render_size = _render_size;
+        glNamedBufferSubData(_frame_ubo, 0, sizeof(uniforms), &uniforms);
+
+        const auto& settings = _ssao_settings;
+        auto ssao = SsaoUniforms{
+            settings.radius,
+            settings.bias,
+            settings.intensity,
+            settings.power,
+            frame_sample_count(settings),
+            settings.noise_size,
+            settings.directions,
+            settings.slices,
+            settings.steps,
+            settings.blur_radius,
+            {}};
+        update_sampling();
+        for (auto i = size_t{0}; i < _kernel.size(); i++) {
+            ssao.samples[i] = _kernel[i];
+        }
+        glNamedBufferSubData(_ssao_ubo, 0, sizeof(ssao), &ssao);
+
+        // Render targets are allocated at the capacity size, and every pass
+        // but the last renders into the bottom-left render size corner.
+        auto& graph = *_graph;
+        graph.set_viewport_scale(uniforms.uv_scale.x, uniforms.uv_scale.y);
+        auto target = [this](GLenum format) {
+            return TextureDesc{format, _capacity.x, _capacity.y};
+        };
+
+        // With the software rasterizer, the whole pipeline runs on the cpu,
+        // and its output is uploaded for the upscale pass. The cpu stages
+        // keep their results in host memory, so they write no textures.
+        if (_software) {
+            if (!_software_pool) {
+                _software_pool.emplace();
+            }
+            auto& pool = *_software_pool;
+            auto lit = graph.create("lit", target(GL_RGBA8));
+            graph.add_pass(
+                {"software_raster",
+                 {},
+                 {},
+                 [this, &pool](const RenderGraph&) {
+                     rasterize_software(pool);
+                 }});
+            if (_enable_ssao) {
+                graph.add_pass(
+                    {"software_ssao",
+                     {},
+                     {},
+                     [this, &pool](const RenderGraph&) {
+                         software_ssao(pool);
+                     }});
+                graph.add_pass(
+                    {"software_ssao_blur",
+                     {},
+                     {},
+                     [this, &pool](const RenderGraph&) {
+                         blur_software_ssao(pool);
+                     }});
+            }
+            graph.add_pass(
+                {"software_lighting",
+                 {},
+                 {lit},
+                 [this, &pool, lit](const RenderGraph& g) {
+                     auto pixels = light_software(pool);
+                     glTextureSubImage2D(
+                         g.texture(lit),
+                         0,
+                         0,
+                         0,
+                         _render_size.x,
+                         _render_size.y,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         pixels.data());
+                 }});
+            add_upscale_pass(graph, lit);
+            graph.execute();
+            report_graph_stats();
+            return;
+        }
+
+        auto normal = graph.create("gnormal", target(GL_RG16));
+        auto diffuse = graph.create("gdiffuse", target(GL_RGBA8));
+        auto depth = graph.create("gdepth", target(GL_DEPTH_COMPONENT32F));
+        auto noise_size = _ssao_settings.noise_size;
+        auto noise = graph.import(
+            "noise",
+            _noise_tex,
+            TextureDesc{GL_RGBA32F, noise_size, noise_size});
+
+        // PASS 1: Fill the G-buffer, either directly, or by rasterizing
+        // triangle ids and resolving them once per visible pixel.
+        if (_visibility_buffer) {
+            auto visibility = graph.create("visibility", target(GL_R32UI));
+            graph.add_pass(
+                {"visibility",
+                 {},
+                 {visibility, depth},
+                 [this](const RenderGraph&) {
+                     constexpr auto empty = std::array<GLuint, 4>{};
+                     glClearBufferuiv(GL_COLOR, 0, empty.data());
+                     glClear(GL_DEPTH_BUFFER_BIT);
+                     _visibility_shader->use();
+                     auto id = _visibility_shader->id();
+                     set_transforms(id, _camera.transform());
+                     auto location =
+                         glGetUniformLocation(id, "u_first_triangle");
+                     begin_samples(_sample_queries[0]);
+                     _scenes[*_scene_idx].render_visibility(location);
+                     end_samples(_sample_queries[0]);
+                 }});
+            graph.add_pass(
+                {"resolve",
+                 {visibility},
+                 {normal, diffuse},
+                 [this, visibility](const RenderGraph& g) {
+                     glClear(GL_COLOR_BUFFER_BIT);
+                     _resolve_shader->use();
+                     set_transforms(_resolve_shader->id(), _camera.transform());
+                     _scenes[*_scene_idx].visibility().bind();
+                     glBindTextureUnit(0, g.texture(visibility));
+                     begin_samples(_sample_queries[1]);
+                     draw_quad();
+                     end_samples(_sample_queries[1]);
+                 }});
+        } else {
+            graph.add_pass(
+                {"geometry",
+                 {},
+                 {normal, diffuse, depth},
+                 [this](const RenderGraph&) {
+                     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                     _geometry_shader->use();
+                     set_transforms(
+                         _geometry_shader->id(),
+                         _camera.transform());
+                     begin_samples(_sample_queries[0]);
+                     _scenes[*_scene_idx].render();
+                     end_samples(_sample_queries[0]);
+                 }});
+        }
+
+        if (_depth_capture != 0) {
+            add_capture_pass(
+                graph,
+                depth,
+                _depth_capture,
+                GL_DEPTH_COMPONENT32F);
+            add_capture_pass(graph, normal, _normal_capture, GL_RG16);
+        }
+
+        // PASSES 2-3: Generate the occlusion texture
+        auto occlusion = add_ssao_passes(graph, depth, normal, noise);
+        if (_occlusion_capture != 0) {
+            add_capture_pass(graph, occlusion, _occlusion_capture, GL_R16F);
+        }
+
+        // PASS 4: Sort the lights into clusters of the view frustum. The
+        // last depth slice starts at the size of the scene.
+        update_lights();
+        const auto& bounds = _scenes[*_scene_idx].bounds();
+        auto cluster_far = std::max(glm::length(bounds.max - bounds.min), 2.0F);
+        auto enable_lights = _lights->light_count() > 0;
+        if (enable_lights) {
+            graph.add_pass(
+                {"light_cull",
+                 {},
+                 {},
+                 [this, cluster_far](const RenderGraph&) {
+                     _lights->cull(_camera.transform(), cluster_far);
+                 }});
+        }
+
+        // PASS 5: Calculate the final lighting and output to screen. Without
+        // ssao the occlusion is not read, so passes 2-3 are culled.
+        // Below the window resolution, the output goes to the upscale pass.
+        auto upscale = _render_size != _window_size;
+        auto lit = graph.create("lit", target(GL_RGBA8));
+        auto lighting_reads =
+            std::vector<RenderGraph::Handle>{diffuse, normal, depth};
+        if (_enable_ssao) {
+            lighting_reads.emplace_back(occlusion);
+        }
+        graph.add_pass(
+            {"lighting",
+             lighting_reads,
+             upscale ? std::vector<RenderGraph::Handle>{lit}
+                     : std::vector<RenderGraph::Handle>{},
+             [this,
+              diffuse,
+              occlusion,
+              normal,
+              depth,
+              upscale,
+              enable_lights,
+              cluster_far](const RenderGraph& g) {
+                 if (!upscale) {
+                     glViewport(0, 0, _window_size.x, _window_size.y);
+                 }
+                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                 const auto& shader =
+                     _lighting_shaders->get(lighting_defines());
+                 shader.use();
+                 auto id = shader.id();
+                 if (!_specialize_shaders) {
+                     auto location = glGetUniformLocation(id, "u_enable_ssao");
+                     glUniform1i(location, _enable_ssao);
+                     location = glGetUniformLocation(id, "u_enable_lights");
+                     glUniform1i(location, enable_lights);
+                 }
+                 auto location = glGetUniformLocation(id, "u_ambient");
+                 glUniform1f(location, enable_lights ? lit_ambient : 1.0F);
+                 location = glGetUniformLocation(id, "u_cluster_far");
+                 glUniform1f(location, cluster_far);
+                 _lights->bind();
+                 glBindTextureUnit(0, g.texture(diffuse));
+                 glBindTextureUnit(1, _enable_ssao ? g.texture(occlusion) : 0);
+                 glBindTextureUnit(2, g.texture(normal));
+                 glBindTextureUnit(3, g.texture(depth));
+                 draw_quad();
+             },
+             !upscale});
+
+        // PASS 6: Upscale the frame to the window
+        if (upscale) {
+            add_upscale_pass(graph, lit);
+        }
+
+        graph.execute();
+        report_graph_stats();
+    }
+}
+
+void Manager::add_upscale_pass(RenderGraph& graph, RenderGraph::Handle lit) {
+    graph.add_pass(
+        {"upscale",
+         {lit},
+         {},
+         [this, lit](const RenderGraph& g) {
+             glViewport(0, 0, _window_size.x, _window_size.y);
+             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+             _upscale_shader->use();
+             glBindTextureUnit(0, g.texture(lit));
+             glBindSampler(0, _linear_sampler);
+             draw_quad();
+             glBindSampler(0, 0);
+         },
+         true});
+}
+
+const HostScene& Manager::host_scene() {
+    auto& scene = _host_scenes[*_scene_idx];
+    if (!scene) {
+        scene.emplace(Loader::load_host_obj(_scene_paths[*_scene_idx]));
+    }
+    return *scene;
+}
+
+std::vector<glm::u8vec4> Manager::render_software(ThreadPool& pool) {
+    rasterize_software(pool);
+    if (_enable_ssao) {
+        software_ssao(pool);
+        blur_software_ssao(pool);
+    }
+    return light_software(pool);
+}
+
+void Manager::rasterize_software(ThreadPool& pool) {
+    _rasterizer.render(
+        host_scene(),
+        _camera.transform(),
+        _projection,
+        _render_size,
+        pool);
+    _software_occlusion.assign(
+        _rasterizer.frame().gbuffer.depth.size(),
+        1.0F);
+}
+
+// The cpu pipeline always runs hemisphere ssao with the bilateral blur.
+void Manager::software_ssao(ThreadPool& pool) {
+    _software_occlusion = cpu_ssao(
+        _rasterizer.frame().gbuffer,
+        software_ssao_settings(),
+        pool);
+}
+
+void Manager::blur_software_ssao(ThreadPool& pool) {
+    _software_occlusion = cpu_bilateral_blur(
+        _software_occlusion,
+        _rasterizer.frame().gbuffer,
+        software_ssao_settings(),
+        pool);
+}
+
+std::vector<glm::u8vec4> Manager::light_software(ThreadPool& pool) {
+    return cpu_lighting(
+        _rasterizer.frame(),
+        _software_occlusion,
+        _ssao_settings.intensity,
+        _ssao_settings.power,
+        pool);
+}
+
+CpuSsaoSettings Manager::software_ssao_settings() const {
+    return CpuSsaoSettings{
+        _projection,
+        _kernel,
+        _rotations,
+        _ssao_settings.noise_size,
+        _ssao_settings.radius,
+        _ssao_settings.bias,
+        _ssao_settings.blur_radius};
+}
+
+void Manager::report_graph_stats() {
+    const auto& stats = _graph->stats();
+    if (stats == _graph_stats) {
+        return;
+    }
+    _graph_stats = stats;
+
+    // Print to stderr so that the line stays out of the benchmark tables.
+    constexpr auto mib = 1024.0 * 1024.0;
+    fmt::print(
+        stderr,
+        "render graph: {} passes ({} culled), {} render targets in {} "
+        "textures, peak {:.1f} MiB, allocated {:.1f} MiB\n",
+        stats.passes,
+        stats.culled,
+        stats.textures,
+        stats.physical,
+        static_cast<double>(stats.peak_bytes) / mib,
+        static_cast<double>(stats.allocated_bytes) / mib);
+}
+
+ShaderDefines Manager::ssao_defines() const {
+    const auto& settings = _ssao_settings;
+    auto hemisphere = settings.method == AoMethod::Hemisphere;
+    auto defines = ShaderDefines{};
+    if (settings.deinterleaved && hemisphere) {
+        defines["DEINTERLEAVED"] = "1";
+    } else if (settings.compute && hemisphere) {
+        defines["TILE_SIZE"] = fmt::format("{}", settings.tile_size);
+    }
+    if (settings.method == AoMethod::Sao) {
+        auto max_level = settings.sao_pyramid ? sao_max_level : 0;
+        defines["SAO_MAX_LEVEL"] = fmt::format("{}", max_level);
+    }
+    if (!_specialize_shaders) {
+        return defines;
+    }
+    defines["NOISE_SIZE"] = fmt::format("{}", settings.noise_size);
+    switch (settings.method) {
+    case AoMethod::Hemisphere:
+    case AoMethod::Sao:
+        defines["SAMPLE_COUNT"] =
+            fmt::format("{}", frame_sample_count(settings));
+        break;
+    case AoMethod::Hbao:
+        defines["DIRECTIONS"] = fmt::format("{}", settings.directions);
+        defines["STEPS"] = fmt::format("{}", settings.steps);
+        break;
+    case AoMethod::Gtao:
+        defines["SLICES"] = fmt::format("{}", settings.slices);
+        defines["STEPS"] = fmt::format("{}", settings.steps);
+        break;
+    }
+    return defines;
+}
+
+ShaderVariants& Manager::ssao_variants() {
+    const auto& settings = _ssao_settings;
+    if (settings.compute && !settings.deinterleaved &&
+        settings.method == AoMethod::Hemisphere) {
+        return *_ssao_compute_shaders;
+    }
+    switch (settings.method) {
+    case AoMethod::Hbao:
+        return *_hbao_shaders;
+    case AoMethod::Gtao:
+        return *_gtao_shaders;
+    case AoMethod::Sao:
+        return *_sao_shaders;
+    default:
+        return *_ssao_shaders;
+    }
+}
+
+RenderGraph::Handle Manager::add_ssao_passes(
+    RenderGraph& graph,
+    RenderGraph::Handle depth,
+    RenderGraph::Handle normal,
+    RenderGraph::Handle noise) {
+    auto divisor = _ssao_settings.resolution_divisor;
+    auto target = [this](GLenum format, int divisor) {
+        return TextureDesc{
+            format,
+            (_capacity.x + divisor - 1) / divisor,
+            (_capacity.y + divisor - 1) / divisor};
+    };
+
+    // Reduce depth and normals to the ssao resolution.
+    auto ssao_depth = depth;
+    auto ssao_normal = normal;
+    if (divisor > 1) {
+        ssao_depth = graph.create("ssao_depth", target(GL_R32F, divisor));
+        ssao_normal = graph.create("ssao_normal", target(GL_RG16, divisor));
+        graph.add_pass(
+            {"ssao_downsample",
+             {depth, normal},
+             {ssao_depth, ssao_normal},
+             [this, depth, normal, divisor](const RenderGraph& g) {
+                 _ssao_downsample_shader->use();
+                 auto location = glGetUniformLocation(
+                     _ssao_downsample_shader->id(),
+                     "u_divisor");
+                 glUniform1i(location, divisor);
+                 glBindTextureUnit(0, g.texture(depth));
+                 glBindTextureUnit(1, g.texture(normal));
+                 draw_quad();
+             }});
+    }
+
+    // Split the inputs into an atlas of tiles that each hold the pixels
+    // sharing one kernel rotation (hemisphere sampling only).
+    auto deinterleaved = _ssao_settings.deinterleaved &&
+                         _ssao_settings.method == AoMethod::Hemisphere;
+    auto factor = _ssao_settings.noise_size;
+    auto source = (_render_size + divisor - 1) / divisor;
+    auto reduced = target(GL_R16F, divisor);
+    auto tile = glm::ivec2{
+        (reduced.width + factor - 1) / factor,
+        (reduced.height + factor - 1) / factor};
+    auto atlas = [tile, factor](GLenum format) {
+        return TextureDesc{format, tile.x * factor, tile.y * factor};
+    };
+    auto kernel_depth = ssao_depth;
+    auto kernel_normal = ssao_normal;
+    if (deinterleaved) {
+        auto atlas_depth = graph.create("ssao_atlas_depth", atlas(GL_R32F));
+        auto atlas_normal = graph.create("ssao_atlas_normal", atlas(GL_RG16));
+        graph.add_pass(
+            {"ssao_deinterleave",
+             {ssao_depth, ssao_normal},
+             {atlas_depth, atlas_normal},
+             [=, this](const RenderGraph& g) {
+                 glViewport(0, 0, tile.x * factor, tile.y * factor);
+                 _ssao_deinterleave_shader->use();
+                 auto id = _ssao_deinterleave_shader->id();
+                 auto location = glGetUniformLocation(id, "u_factor");
+                 glUniform1i(location, factor);
+                 location = glGetUniformLocation(id, "u_tile_size");
+                 glUniform2i(location, tile.x, tile.y);
+                 location = glGetUniformLocation(id, "u_source_size");
+                 glUniform2i(location, source.x, source.y);
+                 glBindTextureUnit(0, g.texture(ssao_depth));
+                 glBindTextureUnit(1, g.texture(ssao_normal));
+                 draw_quad();
+             }});
+        kernel_depth = atlas_depth;
+        kernel_normal = atlas_normal;
+    }
+
+    // Replace depth with a view distance pyramid for sao.
+    if (_ssao_settings.method == AoMethod::Sao && _enable_ssao) {
+        kernel_depth = add_sao_pyramid_pass(graph, ssao_depth, reduced);
+    }
+
+    // Generate the ssao texture, either with a quad or with tiles of compute
+    // work groups (hemisphere sampling only).
+    auto compute = _ssao_settings.compute && !deinterleaved &&
+                   _ssao_settings.method == AoMethod::Hemisphere;
+    auto frame_noise = glm::vec2{};
+    if (_ssao_settings.temporal) {
+        // Offset the noise along the R2 sequence so that successive frames
+        // sample different kernel rotations.
+        constexpr auto r2 = glm::vec2{0.7548777F, 0.5698403F};
+        _ssao_frame++;
+        frame_noise = glm::fract(static_cast<float>(_ssao_frame) * r2);
+    }
+    auto occlusion = graph.create(
+        "ssao",
+        deinterleaved ? atlas(GL_R16F) : target(GL_R16F, divisor));
+    graph.add_pass(
+        {"ssao",
+         {kernel_depth, kernel_normal, noise},
+         {occlusion},
+         [=, this](const RenderGraph& g) {
+             if (deinterleaved) {
+                 glViewport(0, 0, tile.x * factor, tile.y * factor);
+             }
+             glClear(GL_COLOR_BUFFER_BIT);
+             const auto& shader = ssao_variants().get(ssao_defines());
+             shader.use();
+             if (deinterleaved || compute) {
+                 auto location =
+                     glGetUniformLocation(shader.id(), "u_source_size");
+                 glUniform2i(location, source.x, source.y);
+             }
+             auto location = glGetUniformLocation(shader.id(), "u_frame_noise");
+             glUniform2fv(location, 1, glm::value_ptr(frame_noise));
+             glBindTextureUnit(0, g.texture(kernel_depth));
+             glBindTextureUnit(1, g.texture(kernel_normal));
+             glBindTextureUnit(2, g.texture(noise));
+             if (!compute) {
+                 draw_quad();
+                 return;
+             }
+             auto groups = (source + _ssao_settings.tile_size - 1) /
+                           _ssao_settings.tile_size;
+             glBindImageTexture(
+                 0,
+                 g.texture(occlusion),
+                 0,
+                 GL_FALSE,
+                 0,
+                 GL_WRITE_ONLY,
+                 GL_R16F);
+             glDispatchCompute(
+                 static_cast<GLuint>(groups.x),
+                 static_cast<GLuint>(groups.y),
+                 1);
+             glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+         }});
+
+    // Put the atlas pixels back in place.
+    if (deinterleaved) {
+        auto interleaved = graph.create("ssao_reinterleave", reduced);
+        graph.add_pass(
+            {"ssao_reinterleave",
+             {occlusion},
+             {interleaved},
+             [this, occlusion, factor, tile](const RenderGraph& g) {
+                 _ssao_reinterleave_shader->use();
+                 auto id = _ssao_reinterleave_shader->id();
+                 auto location = glGetUniformLocation(id, "u_factor");
+                 glUniform1i(location, factor);
+                 location = glGetUniformLocation(id, "u_tile_size");
+                 glUniform2i(location, tile.x, tile.y);
+                 glBindTextureUnit(0, g.texture(occlusion));
+                 draw_quad();
+             }});
+        occlusion = interleaved;
+    }
+
+    // Accumulate the occlusion over frames.
+    if (_ssao_settings.temporal && _enable_ssao) {
+        occlusion = add_ssao_temporal_pass(
+            graph,
+            occlusion,
+            ssao_depth,
+            ssao_normal,
+            reduced);
+    } else {
+        _ssao_history_valid = false;
+    }
+
+    // Blur the ssao texture
+    auto blurred = add_ssao_blur_passes(
+        graph,
+        occlusion,
+        ssao_depth,
+        ssao_normal,
+        reduced);
+    if (divisor == 1) {
+        return blurred;
+    }
+
+    // Upsample to the frame resolution, guided by the full-resolution depth.
+    auto upsampled = graph.create("ssao_upsample", target(GL_R16F, 1));
+    graph.add_pass(
+        {"ssao_upsample",
+         {blurred, ssao_depth, depth},
+         {upsampled},
+         [this, blurred, ssao_depth, depth](const RenderGraph& g) {
+             _ssao_upsample_shader->use();
+             glBindTextureUnit(0, g.texture(blurred));
+             glBindTextureUnit(1, g.texture(ssao_depth));
+             glBindTextureUnit(2, g.texture(depth));
+             draw_quad();
+         }});
+    return upsampled;
+}
+
+RenderGraph::Handle Manager::add_sao_pyramid_pass(
+    RenderGraph& graph,
+    RenderGraph::Handle depth,
+    const TextureDesc& size) {
+    auto desc = TextureDesc{GL_R32F, size.width, size.height};
+    if (desc != _sao_pyramid_desc) {
+        auto largest = static_cast<float>(std::max(desc.width, desc.height));
+        _sao_pyramid_levels = std::min(
+            static_cast<int>(std::floor(std::log2(largest))) + 1,
+            sao_max_level + 1);
+        graph.forget(_sao_pyramid);
+        glDeleteTextures(1, &_sao_pyramid);
+        glCreateTextures(GL_TEXTURE_2D, 1, &_sao_pyramid);
+        glTextureParameteri(_sao_pyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_sao_pyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(
+            _sao_pyramid,
+            GL_TEXTURE_MIN_FILTER,
+            GL_NEAREST_MIPMAP_NEAREST);
+        glTextureParameteri(_sao_pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureStorage2D(
+            _sao_pyramid,
+            _sao_pyramid_levels,
+            desc.format,
+            desc.width,
+            desc.height);
+        _sao_pyramid_desc = desc;
+    }
+
+    // Build every level from the one below it, in the frame's corner.
+    auto uv_scale = glm::vec2{_render_size} / glm::vec2{_capacity};
+    auto source = glm::ivec2{
+        glm::ceil(glm::vec2{desc.width, desc.height} * uv_scale)};
+    auto pyramid = graph.import("sao_pyramid", _sao_pyramid, desc);
+    graph.add_pass(
+        {"ssao_pyramid",
+         {depth},
+         {pyramid},
+         [this, depth, source](const RenderGraph& g) {
+             _sao_pyramid_shader->use();
+             auto id = _sao_pyramid_shader->id();
+             glBindTextureUnit(0, g.texture(depth));
+             glBindTextureUnit(1, _sao_pyramid);
+             for (auto level = 0; level < _sao_pyramid_levels; level++) {
+                 auto scale = 1 << level;
+                 auto level_size = (source + scale - 1) / scale;
+                 auto location = glGetUniformLocation(id, "u_level");
+                 glUniform1i(location, level);
+                 location = glGetUniformLocation(id, "u_level_size");
+                 glUniform2i(location, level_size.x, level_size.y);
+                 glBindImageTexture(
+                     0,
+                     _sao_pyramid,
+                     level,
+                     GL_FALSE,
+                     0,
+                     GL_WRITE_ONLY,
+                     GL_R32F);
+                 auto groups = (level_size + pyramid_group_size - 1) /
+                               pyramid_group_size;
+                 glDispatchCompute(
+                     static_cast<GLuint>(groups.x),
+                     static_cast<GLuint>(groups.y),
+                     1);
+                 glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+             }
+         }});
+    return pyramid;
+}
+
+RenderGraph::Handle Manager::add_ssao_blur_passes(
+    RenderGraph& graph,
+    RenderGraph::Handle occlusion,
+    RenderGraph::Handle depth,
+    RenderGraph::Handle normal,
+    const TextureDesc& size) {
+    auto blur = _ssao_settings.blur;
+    if (blur == BlurMethod::Box) {
+        auto blurred = graph.create("ssao_blur", size);
+        graph.add_pass(
+            {"ssao_blur",
+             {occlusion},
+             {blurred},
+             [this, occlusion](const RenderGraph& g) {
+                 glClear(GL_COLOR_BUFFER_BIT);
+                 _ssao_box_blur_shader->use();
+                 glBindTextureUnit(0, g.texture(occlusion));
+                 draw_quad();
+             }});
+        return blurred;
+    }
+
+    // Blur rows, then columns. The compute variant runs one work group per
+    // GROUP_SIZE pixels of a line.
+    constexpr auto group_size = 128; // GROUP_SIZE in blur-comp.glsl
+    auto compute = blur == BlurMethod::BilateralCompute;
+    auto uv_scale = glm::vec2{_render_size} / glm::vec2{_capacity};
+    auto extent = glm::ivec2{
+        glm::ceil(glm::vec2{size.width, size.height} * uv_scale)};
+    auto add_pass = [&](const char* name,
+                        RenderGraph::Handle input,
+                        glm::ivec2 direction) {
+        auto output = graph.create(name, size);
+        graph.add_pass(
+            {name,
+             {input, depth, normal},
+             {output},
+             [=, this](const RenderGraph& g) {
+                 auto& variants = compute ? *_ssao_blur_compute_shaders
+                                          : *_ssao_blur_shaders;
+                 const auto& shader = variants.get(blur_defines());
+                 shader.use();
+                 auto id = shader.id();
+                 auto location = glGetUniformLocation(id, "u_direction");
+                 glUniform2i(location, direction.x, direction.y);
+                 glBindTextureUnit(0, g.texture(input));
+                 glBindTextureUnit(1, g.texture(depth));
+                 glBindTextureUnit(2, g.texture(normal));
+                 if (!compute) {
+                     draw_quad();
+                     return;
+                 }
+                 auto length = direction.x == 1 ? extent.x : extent.y;
+                 auto count = direction.x == 1 ? extent.y : extent.x;
+                 auto groups = (length + group_size - 1) / group_size;
+                 glBindImageTexture(
+                     0,
+                     g.texture(output),
+                     0,
+                     GL_FALSE,
+                     0,
+                     GL_WRITE_ONLY,
+                     GL_R16F);
+                 glDispatchCompute(
+                     static_cast<GLuint>(groups),
+                     static_cast<GLuint>(count),
+                     1);
+                 glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+             }});
+        return output;
+    };
+    auto rows = add_pass("ssao_blur_rows", occlusion, {1, 0});
+    return add_pass("ssao_blur", rows, {0, 1});
+}
+
+RenderGraph::Handle Manager::add_ssao_temporal_pass(
+    RenderGraph& graph,
+    RenderGraph::Handle occlusion,
+    RenderGraph::Handle depth,
+    RenderGraph::Handle normal,
+    const TextureDesc& size) {
+    auto desc = TextureDesc{GL_RGBA16F, size.width, size.height};
+    if (desc != _ssao_history_desc) {
+        for (auto tex : _ssao_history) {
+            graph.forget(tex);
+        }
+        glDeleteTextures(2, _ssao_history.data());
+        glCreateTextures(GL_TEXTURE_2D, 2, _ssao_history.data());
+        for (auto tex : _ssao_history) {
+            glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureStorage2D(tex, 1, desc.format, desc.width, desc.height);
+        }
+        _ssao_history_desc = desc;
+        _ssao_history_valid = false;
+    }
+
+    // The history is imported, so the pass always runs and the textures
+    // can swap roles every frame.
+    auto idx = _ssao_history_idx;
+    auto previous = graph.import(
+        "ssao_history_previous",
+        _ssao_history[1 - idx],
+        desc);
+    auto current = graph.import("ssao_history", _ssao_history[idx], desc);
+    auto view = _camera.transform();
+    auto reprojection = _ssao_history_view * glm::inverse(view);
+    auto history_uv_scale = _ssao_history_uv_scale;
+    auto weight = _ssao_history_valid ? _ssao_settings.history_weight : 0.0F;
+    graph.add_pass(
+        {"ssao_temporal",
+         {occlusion, depth, normal, previous},
+         {current},
+         [=, this](const RenderGraph& g) {
+             _ssao_temporal_shader->use();
+             auto id = _ssao_temporal_shader->id();
+             auto location = glGetUniformLocation(id, "u_reprojection");
+             glUniformMatrix4fv(
+                 location,
+                 1,
+                 GL_FALSE,
+                 glm::value_ptr(reprojection));
+             location = glGetUniformLocation(id, "u_history_uv_scale");
+             glUniform2fv(location, 1, glm::value_ptr(history_uv_scale));
+             location = glGetUniformLocation(id, "u_history_weight");
+             glUniform1f(location, weight);
+             glBindTextureUnit(0, g.texture(occlusion));
+             glBindTextureUnit(1, g.texture(depth));
+             glBindTextureUnit(2, g.texture(normal));
+             glBindTextureUnit(3, g.texture(previous));
+             draw_quad();
+         }});
+
+    _ssao_history_idx = 1 - idx;
+    _ssao_history_valid = true;
+    _ssao_history_view = view;
+    _ssao_history_uv_scale = glm::vec2{_render_size} / glm::vec2{_capacity};
+    return current;
+}
+
+ShaderDefines Manager::blur_defines() const {
+    auto defines = ShaderDefines{};
+    if (_specialize_shaders) {
+        defines["BLUR_RADIUS"] =
+            fmt::format("{}", _ssao_settings.blur_radius);
+    }
+    return defines;
+}
+
+void Manager::update_sampling() {
+    const auto& settings = _ssao_settings;
+    auto count = static_cast<size_t>(frame_sample_count(settings));
+    auto reseeded = settings.seed != _sampling_seed;
+    if (settings.kernel != _kernel_pattern || count != _kernel.size() ||
+        reseeded) {
+        _kernel = generate_kernel(
+            settings.kernel,
+            static_cast<int>(count),
+            settings.seed);
+        _kernel_pattern = settings.kernel;
+    }
+    if (settings.noise != _noise_pattern || _noise_tex == 0 || reseeded) {
+        _graph->forget(_noise_tex);
+        glDeleteTextures(1, &_noise_tex);
+        _rotations = generate_rotations(
+            settings.noise,
+            settings.noise_size,
+            settings.seed);
+        _noise_tex = generate_noise(_rotations, settings.noise_size);
+        _noise_pattern = settings.noise;
+    }
+    _sampling_seed = settings.seed;
+}
+
+ShaderDefines Manager::lighting_defines() const {
+    auto defines = LightClusters::defines();
+    if (_specialize_shaders) {
+        auto enable_lights = _lights->light_count() > 0;
+        defines["ENABLE_SSAO"] = _enable_ssao ? "true" : "false";
+        defines["ENABLE_LIGHTS"] = enable_lights ? "true" : "false";
+    }
+    return defines;
+}
+
+void Manager::update_lights() {
+    if (_lights_scene == _scene_idx &&
+        _lights->light_count() == _light_count) {
+        return;
+    }
+    const auto& bounds = _scenes[*_scene_idx].bounds();
+    _lights->set_lights(generate_lights(_light_count, bounds, light_seed));
+    _lights_scene = _scene_idx;
+}
+
+void Manager::add_capture_pass(
+    RenderGraph& graph,
+    RenderGraph::Handle source,
+    GLuint capture,
+    GLenum format) {
+    auto handle = graph.import(
+        "capture",
+        capture,
+        TextureDesc{format, _capacity.x, _capacity.y});
+    graph.add_pass(
+        {"capture",
+         {source},
+         {handle},
+         [this, source, capture](const RenderGraph& g) {
+             glCopyImageSubData(
+                 g.texture(source),
+                 GL_TEXTURE_2D,
+                 0,
+                 0,
+                 0,
+                 0,
+                 capture,
+                 GL_TEXTURE_2D,
+                 0,
+                 0,
+                 0,
+                 0,
+                 _render_size.x,
+                 _render_size.y,
+                 1);
+         }});
+}
+
+std::vector<float> Manager::capture_occlusion() {
+    _occlusion_capture = create_capture(GL_R16F, _capacity);
+    render();
+
+    auto pixels = read_capture(_occlusion_capture, _render_size, GL_RED, 1);
+    _graph->forget(_occlusion_capture);
+    glDeleteTextures(1, &_occlusion_capture);
+    _occlusion_capture = 0;
+    return pixels;
+}
+
+CpuGBuffer Manager::capture_gbuffer() {
+    _depth_capture = create_capture(GL_DEPTH_COMPONENT32F, _capacity);
+    _normal_capture = create_capture(GL_RG16, _capacity);
+    render();
+
+    auto gbuffer = CpuGBuffer{
+        _render_size.x,
+        _render_size.y,
+        read_capture(_depth_capture, _render_size, GL_DEPTH_COMPONENT, 1),
+        {}};
+    auto encoded = read_capture(_normal_capture, _render_size, GL_RG, 2);
+    for (auto i = size_t{0}; i < encoded.size(); i += 2) {
+        gbuffer.normals.emplace_back(
+            decode_normal({encoded[i], encoded[i + 1]}));
+    }
+    _graph->forget(_depth_capture);
+    _graph->forget(_normal_capture);
+    glDeleteTextures(1, &_depth_capture);
+    glDeleteTextures(1, &_normal_capture);
+    _depth_capture = 0;
+    _normal_capture = 0;
+    return gbuffer;
+}
+
+std::vector<std::pair<std::string, double>>
+Manager::time_passes(int warmup_frames, int timed_frames) {
+    _graph->set_timing(true);
+    auto totals = std::vector<std::pair<std::string, double>>{};
+    for (auto i = 0; i < warmup_frames + timed_frames; i++) {
+        render();
+        if (i >= warmup_frames) {
+            auto timings = _graph->timings();
+            totals.resize(timings.size());
+            for (auto p = size_t{0}; p < timings.size(); p++) {
+                totals[p].first = timings[p].first;
+                totals[p].second += timings[p].second / timed_frames;
+            }
+        }
+        present();
+    }
+    _graph->set_timing(Profiler::instance().enabled());
+    return totals;
 }
 
 void Manager::draw_quad() {
@@ -439,50 +1724,564 @@ void Manager::draw_quad() {
     glBindVertexArray(0);
 }
 
-Manager& Manager::instance() {
-    static auto m = Manager{};
+Manager& Manager::instance(std::optional<HeadlessSettings> headless) {
+    static auto m = Manager{std::move(headless)};
     return m;
 }
 
 void Manager::loop() {
-    auto last_frame = 0U;
-    auto quit = false;
-    auto event = SDL_Event{};
+    if (_headless) {
+        run_headless();
+        return;
+    }
+
+    // Hand the context over to the render thread.
+    SDL_GL_MakeCurrent(_window, nullptr);
+    _state.time = std::chrono::steady_clock::now();
+    _frames.back() = _state;
+    _frames.publish();
+
+    _quit = false;
+    auto renderer = std::thread{[this] { render_loop(); }};
+    update_loop();
+    renderer.join();
+
+    SDL_GL_MakeCurrent(_window, _context);
+}
+
+bool Manager::checks_passed() const {
+    return _checks_passed;
+}
+
+void Manager::update_loop() {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto tick = std::chrono::nanoseconds{1'000'000'000 / tick_rate};
+    constexpr auto tick_ms = 1000.0F / tick_rate;
 
-    while (!quit) {
-        auto curr_frame = SDL_GetTicks();
+    auto event = SDL_Event{};
+    auto next_tick = Clock::now();
+    auto ticks = 0U;
+    Profiler::instance().set_thread_name("update");
+    while (!_quit) {
+        auto tick_begin_ns = Profiler::instance().now_ns();
         while (SDL_PollEvent(&event) != 0) {
-            quit |= handle_event(event);
+            if (handle_event(event)) {
+                _quit = true;
+            }
         }
 
-        update_camera(_camera, curr_frame - last_frame);
-        render();
+        // Play the camera path at the tick rate, or move with the keyboard.
+        _state.previous_camera = _state.camera;
+        const auto* bounds =
+            _state.scene_idx ? &_scenes[*_state.scene_idx].bounds() : nullptr;
+        if (_camera_path && bounds != nullptr) {
+            auto time = static_cast<float>(ticks) / tick_rate;
+            auto duration = _camera_path->duration();
+            _state.camera = _camera_path->camera(
+                duration > 0.0F ? std::fmod(time, duration) : 0.0F,
+                *bounds);
+        } else {
+            update_camera(_state.camera, tick_ms);
+        }
+        if (_recording && bounds != nullptr &&
+            _recording_ticks % record_interval == 0) {
+            auto time = static_cast<float>(_recording_ticks) / tick_rate;
+            _recording->add(time, _state.camera, *bounds);
+        }
+        ticks++;
+        _recording_ticks++;
+        _state.time = Clock::now();
+        _frames.back() = _state;
+        _frames.publish();
+        if (Profiler::instance().enabled()) {
+            auto& profiler = Profiler::instance();
+            profiler.record({"tick", tick_begin_ns, profiler.now_ns(), false});
+        }
+
+        // Skip ticks rather than trying to catch up after a stall.
+        next_tick = std::max(next_tick + tick, Clock::now() - tick);
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+void Manager::render_loop() {
+    SDL_GL_MakeCurrent(_window, _context);
+    Profiler::instance().set_thread_name("render");
+    _pacer.emplace();
+    _frame_timers = generate_frame_timers();
+    _frame_count = 0;
+    auto benchmarks = 0U;
+    while (!_quit) {
+        run_frame(_frames.front().pacing);
+        if (_frames.front().benchmarks != benchmarks) {
+            benchmarks = _frames.front().benchmarks;
+            Benchmarks{*this}.run();
+        }
+    }
+    _pacer.reset();
+    SDL_GL_MakeCurrent(_window, nullptr);
+}
+
+void Manager::run_headless() {
+    using Clock = std::chrono::steady_clock;
+
+    _pacer.emplace();
+    _frame_timers = generate_frame_timers();
+    _frame_count = 0;
+
+    // Each frame waits for the gpu time of the frame that last used its
+    // timer, and the times still in flight are read at the end.
+    auto frame_ms = std::vector<double>{};
+    auto gpu_ms = std::vector<double>{};
+    auto start = Clock::now();
+    auto last = start;
+    auto frames = _headless->frames.value_or(default_headless_frames);
+    if (_camera_path && !_headless->frames) {
+        frames = static_cast<int>(
+                     std::ceil(_camera_path->duration() * path_frame_rate)) +
+                 1;
+    }
+    for (auto i = 0; i < frames; i++) {
+        // Step the camera path at a fixed rate, so that every run renders the
+        // same frames.
+        if (_camera_path && _state.scene_idx) {
+            _state.camera = _camera_path->camera(
+                static_cast<float>(i) / path_frame_rate,
+                _scenes[*_state.scene_idx].bounds());
+        }
+        if (_frame_count >= _frame_timers.size()) {
+            const auto& timer =
+                _frame_timers[_frame_count % _frame_timers.size()];
+            gpu_ms.emplace_back(timer.elapsed_ms());
+        }
+        run_frame(_state.pacing);
+        auto now = Clock::now();
+        frame_ms.emplace_back(
+            std::chrono::duration<double, std::milli>{now - last}.count());
+        last = now;
+    }
+    auto in_flight = std::min(_frame_count, _frame_timers.size());
+    for (auto i = _frame_count - in_flight; i < _frame_count; i++) {
+        gpu_ms.emplace_back(
+            _frame_timers[i % _frame_timers.size()].elapsed_ms());
+    }
+    auto total_s = std::chrono::duration<double>{last - start}.count();
+
+    fmt::print(
+        "headless: {} frames at {}x{} in {:.2f} s\n",
+        frames,
+        _window_size.x,
+        _window_size.y,
+        total_s);
+    if (frames > 1) {
+        fmt::print(
+            "{:<8} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}\n",
+            "",
+            "first",
+            "mean",
+            "min",
+            "median",
+            "p95",
+            "max");
+        // The gpu time of the first frame is unreliable on llvmpipe, where
+        // it overlaps shader compilation.
+        print_frame_times(
+            "frame ms",
+            frame_ms.front(),
+            std::span{frame_ms}.subspan(1));
+        print_frame_times("gpu ms", {}, std::span{gpu_ms}.subspan(1));
+    }
+
+    if (!_headless->output.empty()) {
+        auto pixels = std::vector<glm::u8vec4>(
+            static_cast<size_t>(_window_size.x) *
+            static_cast<size_t>(_window_size.y));
+        glNamedFramebufferReadBuffer(_output, GL_COLOR_ATTACHMENT0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _output);
+        glReadPixels(
+            0,
+            0,
+            _window_size.x,
+            _window_size.y,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            pixels.data());
+
+        // A window ignores the alpha of the last pass, so an image does too.
+        for (auto& pixel : pixels) {
+            pixel.a = 255;
+        }
+        const auto& path = _headless->output;
+        if (write_image(path, _window_size.x, _window_size.y, pixels)) {
+            fmt::print("wrote the last frame to {}\n", path.string());
+        } else {
+            fmt::print(stderr, "could not write {}\n", path.string());
+            _checks_passed = false;
+        }
+    }
 
-        last_frame = curr_frame;
+    if (Profiler::instance().enabled()) {
+        print_profile(_graph->skipped_timer_sets());
     }
+
+    if (_headless->check_cpu_ssao) {
+        _checks_passed =
+            Benchmarks{*this}.check_cpu_ssao() && _checks_passed;
+    }
+    if (_headless->benchmark) {
+        Benchmarks{*this}.run();
+    }
+    _pacer.reset();
+}
+
+void Manager::publish_state() {
+    // Without interpolation the snapshot renders the same at any age.
+    _state.previous_camera = _state.camera;
+    _state.time = std::chrono::steady_clock::now();
+    _frames.back() = _state;
+    _frames.publish();
+}
+
+void Manager::present() {
+    if (!_headless) {
+        auto scope = ProfileScope{"swap"};
+        SDL_GL_SwapWindow(_window);
+    }
+    if (Profiler::instance().enabled()) {
+        Profiler::instance().collect();
+    }
+}
+
+void Manager::run_frame(PacingSettings pacing) {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto tick = std::chrono::duration<float>{1.0F / tick_rate};
+
+    // The first frame, which compiles the shader variants it uses, is the
+    // last phase of startup.
+    auto startup_phase = std::optional<StartupPhase>{};
+    if (!StartupReport::instance().finished()) {
+        startup_phase.emplace("first frame");
+    }
+
+    // Pace before taking the snapshot so that it is as fresh as possible.
+    auto scope = ProfileScope{"frame"};
+    {
+        auto pace_scope = ProfileScope{"pace"};
+        _pacer->wait(pacing);
+    }
+    if (_headless) {
+        publish_state();
+    }
+    _frames.update();
+    const auto& frame = _frames.front();
+
+    // Render one tick behind the simulation so the camera can always be
+    // interpolated between the two latest snapshots.
+    auto alpha = std::chrono::duration<float>{Clock::now() - frame.time};
+    _camera = Camera::interpolate(
+        frame.previous_camera,
+        frame.camera,
+        std::clamp(alpha / tick, 0.0F, 1.0F));
+    _scene_idx = frame.scene_idx;
+    _enable_ssao = frame.enable_ssao;
+    _visibility_buffer = frame.visibility_buffer;
+    _software = frame.software;
+    _light_count = frame.light_count;
+    _ssao_settings.resolution_divisor = frame.ssao_divisor;
+    _ssao_settings.deinterleaved = frame.ssao_deinterleaved;
+    _ssao_settings.compute = frame.ssao_compute;
+    _ssao_settings.temporal = frame.ssao_temporal;
+    _ssao_settings.blur = frame.ssao_blur;
+    _ssao_settings.kernel = frame.ssao_kernel;
+    _ssao_settings.noise = frame.ssao_noise;
+    _ssao_settings.method = frame.ao_method;
+    _ssao_settings.sample_count = frame.ssao_sample_count;
+    _ssao_settings.intensity = frame.ssao_intensity;
+    _ssao_settings.power = frame.ssao_power;
+    if (_scene_idx) {
+        const auto& bounds = _scenes[*_scene_idx].bounds();
+        auto diagonal = glm::length(bounds.max - bounds.min);
+        _ssao_settings.radius =
+            ssao_radius_fraction * diagonal * frame.ssao_radius_scale;
+        _ssao_settings.bias = ssao_bias_fraction * _ssao_settings.radius;
+    }
+    if (frame.wireframe != _wireframe) {
+        _wireframe = frame.wireframe;
+        set_wireframe(_wireframe);
+    }
+
+    update_resolution(frame);
+
+    auto& timer = _frame_timers[_frame_count % _frame_timers.size()];
+    _graph->set_timing(Profiler::instance().enabled());
+    timer.begin();
+    render();
+    timer.end();
+    _frame_count++;
+
+    present();
+    _pacer->submit(frame.time);
+    if (startup_phase) {
+        startup_phase.reset();
+        StartupReport::instance().finish();
+    }
+}
+
+void Manager::update_resolution(const FrameState& frame) {
+    // The oldest timer is the next one to be reused, and has had the most
+    // time to finish. Skip its result rather than wait for it.
+    auto target_fps = frame.pacing.target_fps > 0 ? frame.pacing.target_fps
+                                                  : default_target_fps;
+    auto target_ms = 1000.0 / target_fps * frame_time_headroom;
+    const auto& oldest = _frame_timers[_frame_count % _frame_timers.size()];
+    if (!frame.dynamic_resolution) {
+        _resolution.reset();
+    } else if (_frame_count >= _frame_timers.size() && oldest.ready()) {
+        _resolution.update(oldest.elapsed_ms(), target_ms);
+    }
+
+    _window_size = glm::max(frame.window_size, glm::ivec2{1});
+    auto scaled = glm::vec2{_window_size} * _resolution.scale();
+    _render_size = glm::max(glm::ivec2{glm::round(scaled)}, glm::ivec2{1});
+
+    // Grow the render targets in steps so that resizing the window does not
+    // reallocate them every frame.
+    if (glm::any(glm::greaterThan(_render_size, _capacity))) {
+        auto steps = (_render_size + capacity_step - 1) / capacity_step;
+        _capacity = glm::max(_capacity, steps * capacity_step);
+        _graph->clear_pool();
+    }
+}
+
+void Manager::set_camera_path(CameraPath path) {
+    _camera_path.emplace(std::move(path));
 }
 
-void Manager::add_scene(Scene m) {
+void Manager::add_scene(Scene m, std::filesystem::path source) {
     _scenes.emplace_back(std::move(m));
-    if (!_scene_idx) {
-        _scene_idx.emplace(0);
+    _scene_paths.emplace_back(std::move(source));
+    _host_scenes.emplace_back();
+    if (!_state.scene_idx) {
+        _state.scene_idx.emplace(0);
     }
 }
 
+bool Manager::has_scene() const {
+    return _scene_idx.has_value();
+}
+
+RenderSettings Manager::render_settings() const {
+    return RenderSettings{
+        _ssao_settings,
+        _enable_ssao,
+        _specialize_shaders,
+        _visibility_buffer,
+        _software,
+        _light_count};
+}
+
+void Manager::set_render_settings(const RenderSettings& settings) {
+    _ssao_settings = settings.ssao;
+    _enable_ssao = settings.enable_ssao;
+    _specialize_shaders = settings.specialize_shaders;
+    _visibility_buffer = settings.visibility_buffer;
+    _software = settings.software;
+    _light_count = settings.light_count;
+}
+
+bool Manager::bindless() const {
+    return _bindless;
+}
+
+glm::ivec2 Manager::render_size() const {
+    return _render_size;
+}
+
+const RenderGraph::Stats& Manager::graph_stats() const {
+    return _graph->stats();
+}
+
+void Manager::count_samples(bool count) {
+    if (count && _sample_queries[0] == 0) {
+        glCreateQueries(
+            GL_SAMPLES_PASSED,
+            static_cast<GLsizei>(_sample_queries.size()),
+            _sample_queries.data());
+    } else if (!count && _sample_queries[0] != 0) {
+        glDeleteQueries(
+            static_cast<GLsizei>(_sample_queries.size()),
+            _sample_queries.data());
+        _sample_queries = {};
+    }
+}
+
+std::array<GLuint64, 2> Manager::sample_counts() const {
+    auto samples = std::array<GLuint64, 2>{};
+    glGetQueryObjectui64v(_sample_queries[0], GL_QUERY_RESULT, &samples[0]);
+    samples[1] = samples[0];
+    if (_visibility_buffer) {
+        glGetQueryObjectui64v(
+            _sample_queries[1],
+            GL_QUERY_RESULT,
+            &samples[1]);
+    }
+    return samples;
+}
+
+PacingSettings Manager::pacing() const {
+    return _frames.front().pacing;
+}
+
+const FramePacer&
+Manager::pace_frames(PacingSettings pacing, int warmup, int timed) {
+    for (auto i = 0; i < warmup; i++) {
+        run_frame(pacing);
+    }
+    _pacer->reset_stats();
+    for (auto i = 0; i < timed; i++) {
+        run_frame(pacing);
+    }
+    return *_pacer;
+}
+
 bool Manager::handle_event(const SDL_Event& event) {
     if (event.type == SDL_QUIT) {
         return true;
     }
+    if (event.type == SDL_WINDOWEVENT &&
+        event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        _state.window_size = glm::ivec2{event.window.data1, event.window.data2};
+    }
     if (event.type == SDL_KEYDOWN) {
         auto keycode = event.key.keysym.sym;
         switch (keycode) {
         case SDLK_q:
             return true;
         case SDLK_f:
-            toggle_wireframe();
+            _state.wireframe = !_state.wireframe;
             break;
         case SDLK_e:
-            toggle_ssao();
+            _state.enable_ssao = !_state.enable_ssao;
+            break;
+        case SDLK_b:
+            _state.benchmarks++;
+            break;
+        case SDLK_g:
+            if (_bindless) {
+                _state.visibility_buffer = !_state.visibility_buffer;
+            } else {
+                fmt::print("visibility buffer needs bindless textures\n");
+            }
+            break;
+        case SDLK_p:
+            _state.software = !_state.software;
+            break;
+        case SDLK_z:
+            if (!_recording) {
+                _recording.emplace();
+                _recording_ticks = 0;
+                fmt::print("recording the camera path\n");
+            } else {
+                if (_recording->save(recorded_path)) {
+                    fmt::print("saved the camera path to {}\n", recorded_path);
+                } else {
+                    fmt::print("could not write {}\n", recorded_path);
+                }
+                _recording.reset();
+            }
+            break;
+        case SDLK_0: {
+            const auto* count = std::find(
+                light_counts.begin(),
+                light_counts.end(),
+                _state.light_count);
+            _state.light_count = count + 1 < light_counts.end()
+                                     ? *(count + 1)
+                                     : light_counts.front();
+            break;
+        }
+        case SDLK_h:
+            _state.ssao_divisor = _state.ssao_divisor < 4
+                                      ? _state.ssao_divisor * 2
+                                      : 1;
+            break;
+        case SDLK_SLASH:
+            _state.ssao_deinterleaved = !_state.ssao_deinterleaved;
+            break;
+        case SDLK_c:
+            _state.ssao_compute = !_state.ssao_compute;
+            break;
+        case SDLK_u:
+            _state.ssao_temporal = !_state.ssao_temporal;
+            break;
+        case SDLK_n:
+            _state.ssao_blur = static_cast<BlurMethod>(
+                (static_cast<int>(_state.ssao_blur) + 1) % blur_method_count);
+            break;
+        case SDLK_o:
+            _state.ao_method = static_cast<AoMethod>(
+                (static_cast<int>(_state.ao_method) + 1) % ao_method_count);
+            break;
+        case SDLK_r:
+            _state.dynamic_resolution = !_state.dynamic_resolution;
+            break;
+        case SDLK_v:
+            _state.pacing.low_latency = !_state.pacing.low_latency;
+            break;
+        case SDLK_y:
+            _state.pacing.frames_in_flight =
+                _state.pacing.frames_in_flight % max_frames_in_flight + 1;
+            break;
+        case SDLK_t: {
+            constexpr auto caps = std::array{0, 30, 60, 120};
+            const auto* cap = std::find(
+                caps.begin(),
+                caps.end(),
+                _state.pacing.target_fps);
+            _state.pacing.target_fps =
+                cap + 1 < caps.end() ? *(cap + 1) : caps.front();
+            break;
+        }
+        case SDLK_m:
+            _state.ssao_kernel = static_cast<KernelPattern>(
+                (static_cast<int>(_state.ssao_kernel) + 1) %
+                kernel_pattern_count);
+            break;
+        case SDLK_x:
+            _state.ssao_noise = _state.ssao_noise == NoisePattern::Blue
+                                    ? NoisePattern::White
+                                    : NoisePattern::Blue;
+            break;
+        case SDLK_LEFTBRACKET:
+        case SDLK_RIGHTBRACKET:
+            _state.ssao_radius_scale *=
+                keycode == SDLK_LEFTBRACKET ? 0.8F : 1.25F;
+            print_ssao_tuning(_state);
+            break;
+        case SDLK_MINUS:
+        case SDLK_EQUALS:
+            _state.ssao_sample_count = std::clamp(
+                keycode == SDLK_MINUS ? _state.ssao_sample_count / 2
+                                      : _state.ssao_sample_count * 2,
+                min_sample_count,
+                max_sample_count);
+            print_ssao_tuning(_state);
+            break;
+        case SDLK_COMMA:
+        case SDLK_PERIOD:
+            _state.ssao_intensity = std::max(
+                _state.ssao_intensity +
+                    (keycode == SDLK_COMMA ? -0.25F : 0.25F),
+                0.0F);
+            print_ssao_tuning(_state);
+            break;
+        case SDLK_SEMICOLON:
+        case SDLK_QUOTE:
+            _state.ssao_power = std::max(
+                _state.ssao_power +
+                    (keycode == SDLK_SEMICOLON ? -0.25F : 0.25F),
+                0.25F);
+            print_ssao_tuning(_state);
             break;
         case SDLK_1:
         case SDLK_2:
@@ -496,7 +2295,7 @@ bool Manager::handle_event(const SDL_Event& event) {
             auto idx =
                 static_cast<size_t>(std::stoi(SDL_GetKeyName(keycode)) - 1);
             if (idx < _scenes.size()) {
-                _scene_idx.emplace(idx);
+                _state.scene_idx.emplace(idx);
             }
         }
     }
@@ -1,20 +1,134 @@
 #pragma once
 
 #include "camera.hpp"
+#include "camera_path.hpp"
+#include "cpu_ssao.hpp"
+#include "frame_pacer.hpp"
+#include "gpu_timer.hpp"
+#include "headless.hpp"
+#include "lights.hpp"
 #include "mesh.hpp"
+#include "rasterizer.hpp"
+#include "render_graph.hpp"
+#include "resolution.hpp"
+#include "sampling.hpp"
 #include "scene.hpp"
 #include "shader.hpp"
+#include "triple_buffer.hpp"
 
 #include <glm/glm.hpp>
 #include <SDL2/SDL.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <optional>
 
-// The manager is a program controller singleton.
+// An AoMethod is an algorithm for the ambient occlusion pass.
+enum class AoMethod {
+    Hemisphere, // random samples in a normal-oriented hemisphere
+    Hbao, // horizon-based, per-sample form of HBAO+
+    Gtao, // ground-truth, analytic integration between horizons
+    Sao, // scalable obscurance, spiral taps on a view distance pyramid
+};
+
+// A BlurMethod is a filter that removes noise from the occlusion.
+enum class BlurMethod {
+    Box, // 4x4 box filter
+    Bilateral, // separable, weighted by depth and normal similarity
+    BilateralCompute, // separable bilateral in compute with cached lines
+};
+
+constexpr auto max_sample_count = 64; // kernel size of the ssao block
+
+// The SsaoSettings are the tunable parameters of the ssao pass. The radius
+// and bias are rescaled to the bounds of every scene.
+struct SsaoSettings {
+    AoMethod method = AoMethod::Hemisphere;
+    int sample_count = 16; // number of kernel samples per fragment
+    float radius = 500.0F; // radius of the sample hemisphere in view units
+    float bias = 25.0F; // depth bias that avoids self-occlusion
+    int noise_size = 4; // width and height of the tiled rotation texture
+    int resolution_divisor = 1; // ratio of the frame and ssao resolutions
+    bool deinterleaved = false; // render one tile per kernel rotation
+    int directions = 8; // screen directions searched by hbao
+    int slices = 3; // view-aligned slices integrated by gtao
+    int steps = 6; // samples per direction or slice side
+    float intensity = 1.0F; // scale of the occlusion
+    float power = 1.0F; // exponent applied to the unoccluded fraction
+    bool compute = false; // run hemisphere ssao as a compute shader
+    int tile_size = 16; // work group width and height of compute ssao
+    bool temporal = false; // accumulate occlusion over frames
+    int temporal_sample_count = 8; // kernel samples per frame when temporal
+    float history_weight = 0.9F; // weight of the reprojected history
+    BlurMethod blur = BlurMethod::Bilateral;
+    int blur_radius = 4; // taps on either side of the bilateral blur
+    KernelPattern kernel = KernelPattern::Hammersley;
+    NoisePattern noise = NoisePattern::Blue;
+    unsigned seed = 1; // seed of the kernel and noise, 0 for a new one per run
+    bool sao_pyramid = true; // read distant sao taps from coarser levels
+};
+
+// A FrameState is a snapshot of the simulation that the update thread hands
+// to the render thread.
+struct FrameState {
+    Camera camera; // camera at the time of the snapshot
+    Camera previous_camera; // camera one update earlier
+    std::chrono::steady_clock::time_point time; // time of the snapshot
+    std::optional<size_t> scene_idx; // index of the scene to render
+    bool enable_ssao = true;
+    bool wireframe = false;
+    bool visibility_buffer = false; // fill the g-buffer from triangle ids
+    bool software = false; // render on the cpu with the software rasterizer
+    size_t light_count = 0; // number of generated point and spot lights
+    int ssao_divisor = 1; // ratio of the frame and ssao resolutions
+    bool ssao_deinterleaved = false; // render one tile per kernel rotation
+    bool ssao_compute = false; // run hemisphere ssao as a compute shader
+    bool ssao_temporal = false; // accumulate occlusion over frames
+    BlurMethod ssao_blur = BlurMethod::Bilateral;
+    float ssao_radius_scale = 1.0F; // multiple of the scene's ssao radius
+    int ssao_sample_count = 16; // hemisphere kernel samples per fragment
+    float ssao_intensity = 1.0F; // scale of the occlusion
+    float ssao_power = 1.0F; // exponent applied to the unoccluded fraction
+    KernelPattern ssao_kernel = KernelPattern::Hammersley;
+    NoisePattern ssao_noise = NoisePattern::Blue;
+    AoMethod ao_method = AoMethod::Hemisphere;
+    bool dynamic_resolution = true; // scale resolution to hold frame time
+    glm::ivec2 window_size{}; // size of the window in pixels
+    unsigned benchmarks = 0; // number of benchmark requests so far
+    PacingSettings pacing; // frame queueing and rate limits
+};
+
+// The HeadlessSettings configure a run without a window, which renders a
+// fixed number of frames offscreen, prints their timings, and exits.
+struct HeadlessSettings {
+    std::optional<int> frames; // number of frames (100 or the camera path)
+    glm::ivec2 resolution{1024, 1024}; // size of the frames
+    std::filesystem::path output; // image of the last frame, if not empty
+    bool benchmark = false; // run the benchmarks after the frames
+    bool check_cpu_ssao = false; // compare the cpu and gpu ssao at the end
+};
+
+// The RenderSettings select the pipeline that frames render with. Frames of
+// the loop take them from their snapshot.
+struct RenderSettings {
+    SsaoSettings ssao;
+    bool enable_ssao = true;
+    bool specialize_shaders = true; // compile settings into shader variants
+    bool visibility_buffer = false; // fill the g-buffer from triangle ids
+    bool software = false; // render on the cpu with the software rasterizer
+    size_t light_count = 0; // number of generated point and spot lights
+};
+
+// The manager is a program controller singleton. Input and simulation run
+// at a fixed rate on the calling thread while a render thread owns the
+// opengl context and draws the latest snapshot.
 class Manager {
   public:
-    // Get a reference to the singleton.
-    static Manager& instance();
+    // Get a reference to the singleton. The first call creates it, with a
+    // window, or offscreen given headless settings.
+    static Manager& instance(std::optional<HeadlessSettings> = std::nullopt);
 
     // Disallow copies and moves.
     Manager(Manager&) = delete;
@@ -25,56 +139,269 @@ class Manager {
     // Enter the main control loop.
     void loop();
 
-    // Add a scene to the list of scenes to render.
-    void add_scene(Scene);
+    // Get whether the checks of a headless run passed, and its frame was
+    // written if an output was given.
+    [[nodiscard]] bool checks_passed() const;
+
+    // Drive the camera along a path instead of the keyboard. The path loops
+    // in a window, and is stepped at a fixed frame rate when headless.
+    void set_camera_path(CameraPath);
+
+    // Add a scene loaded from a file to the list of scenes to render.
+    void add_scene(Scene, std::filesystem::path source);
+
+    // Get whether there is a scene to render.
+    [[nodiscard]] bool has_scene() const;
+
+    // Get or set the pipeline that frames render with.
+    [[nodiscard]] RenderSettings render_settings() const;
+    void set_render_settings(const RenderSettings&);
+
+    // Get whether bindless textures, which the visibility buffer needs, are
+    // available.
+    [[nodiscard]] bool bindless() const;
+
+    // Get the size the passes render at.
+    [[nodiscard]] glm::ivec2 render_size() const;
+
+    // Get the statistics of the last frame of the render graph.
+    [[nodiscard]] const RenderGraph::Stats& graph_stats() const;
+
+    // Start or stop counting the samples of the g-buffer passes.
+    void count_samples(bool);
+
+    // Get the samples that the g-buffer passes of the last frame rasterized
+    // and shaded, which are the same without the visibility buffer. Call it
+    // while counting.
+    [[nodiscard]] std::array<GLuint64, 2> sample_counts() const;
+
+    // Run the full rendering pipeline (all passes).
+    void render();
+
+    // Render frames and get the average gpu time of every pass.
+    std::vector<std::pair<std::string, double>>
+    time_passes(int warmup_frames, int timed_frames);
+
+    // Render a frame and read back its occlusion texture.
+    std::vector<float> capture_occlusion();
+
+    // Render a frame and read back the depth and normals of its g-buffer.
+    CpuGBuffer capture_gbuffer();
+
+    // Get the host copy of the current scene, and load it on first use.
+    const HostScene& host_scene();
+
+    // Rasterize, occlude, and light the current scene on the cpu at the
+    // render size, and get its rgba8 pixels.
+    std::vector<glm::u8vec4> render_software(ThreadPool&);
+
+    // Get the inputs of the cpu ssao and blur for the current frame.
+    [[nodiscard]] CpuSsaoSettings software_ssao_settings() const;
+
+    // Get the pacing settings of the latest snapshot.
+    [[nodiscard]] PacingSettings pacing() const;
+
+    // Pace, render, and present frames, and get the pacer, whose statistics
+    // cover the frames after a warmup.
+    const FramePacer& pace_frames(PacingSettings, int warmup, int timed);
 
   private:
-    SDL_Window* _window;
-    SDL_GLContext _context;
+    SDL_Window* _window = nullptr;
+    SDL_GLContext _context = nullptr;
+    std::optional<HeadlessSettings> _headless; // settings of a headless run
+    std::optional<HeadlessContext> _headless_context; // context of that run
+    bool _checks_passed = true; // the checks of a headless run passed
+    GLuint _output = 0; // framebuffer of the last pass (0 for the window)
+    std::array<GLuint, 2> _output_renderbuffers{}; // headless color/depth
 
-    Camera _camera;
+    FrameState _state; // simulation state (update thread)
+    TripleBuffer<FrameState> _frames; // snapshots from update to render thread
+    std::atomic<bool> _quit = false;
+    std::optional<CameraPath> _camera_path; // drives the camera when set
+    std::optional<CameraPath> _recording; // path recorded from the camera
+    unsigned _recording_ticks = 0; // ticks since the recording started
+
+    std::optional<FramePacer> _pacer; // paces frames (render thread)
+    bool _wireframe = false; // wireframe mode applied to the context
+    ResolutionController _resolution; // picks the render scale
+    std::vector<GpuTimer> _frame_timers; // ring of whole-frame gpu timers
+    size_t _frame_count = 0; // frames rendered since the render loop started
+    glm::ivec2 _window_size{}; // size of the window
+    glm::ivec2 _render_size{}; // size the passes render at
+    glm::ivec2 _capacity{}; // size of the render targets
+    Camera _camera; // interpolated camera of the rendered frame
     std::vector<Scene> _scenes; // list of scenes to render
+    std::vector<std::filesystem::path> _scene_paths; // files of the scenes
     std::optional<size_t> _scene_idx; // index of currently rendering scene
 
     GLuint _quad; // vertex array object id for screen quad (passes 2-4)
-    GLuint _noise_tex; // texture id for random noise
+    GLuint _noise_tex = 0; // texture id for the kernel rotations
+    NoisePattern _noise_pattern{}; // pattern of the kernel rotations
+    std::vector<glm::vec3> _rotations; // kernel rotations in the texture
+    std::vector<glm::vec4> _kernel; // hemisphere kernel in the ssao block
+    KernelPattern _kernel_pattern{}; // pattern of the kernel
+    unsigned _sampling_seed = 0; // seed of the kernel and rotations
+    GLuint _frame_ubo; // buffer id for per-frame uniforms
+    GLuint _ssao_ubo; // buffer id for the ssao settings
+    GLuint _linear_sampler; // sampler id for bilinear filtering
+
+    std::optional<RenderGraph> _graph; // schedules passes 1-4 every frame
+    RenderGraph::Stats _graph_stats{}; // last reported graph statistics
 
     std::optional<Shader> _geometry_shader; // geometry pass shader
-    GLuint _gbuffer; // framebuffer id for geometry pass
-    GLuint _gposition; // texture id for g-buffer position data
-    GLuint _gnormal; // texture id g-buffer normal data
-    GLuint _gdiffuse; // texture id g-buffer color data
+    std::optional<Shader> _visibility_shader; // triangle id pass shader
+    std::optional<Shader> _resolve_shader; // triangle id to g-buffer shader
+    bool _bindless = false; // bindless textures are available
+    bool _visibility_buffer = false; // fill the g-buffer from triangle ids
+    std::array<GLuint, 2> _sample_queries{}; // geometry/shading sample counts
+
+    bool _software = false; // render on the cpu with the software rasterizer
+    std::vector<std::optional<HostScene>> _host_scenes; // loaded on first use
+    std::optional<ThreadPool> _software_pool; // threads of the cpu pipeline
+    Rasterizer _rasterizer; // fills the g-buffer of the cpu pipeline
+    std::vector<float> _software_occlusion; // of the cpu pipeline's frame
 
-    std::optional<Shader> _ssao_shader; // ssao pass shader
-    GLuint _ssao_buffer; // framebuffer id for ssao pass
-    GLuint _ssao_color_tex; // texture id for ssao pass output
+    SsaoSettings _ssao_settings; // parameters of the ssao pass
+    std::optional<ShaderVariants> _ssao_shaders; // hemisphere ssao shaders
+    std::optional<ShaderVariants> _ssao_compute_shaders; // tiled hemisphere
+    std::optional<ShaderVariants> _hbao_shaders; // hbao shaders
+    std::optional<ShaderVariants> _gtao_shaders; // gtao shaders
+    std::optional<ShaderVariants> _sao_shaders; // sao shaders
+    std::optional<Shader> _sao_pyramid_shader; // builds the sao pyramid
+    GLuint _sao_pyramid = 0; // mipmapped view distances for sao
+    TextureDesc _sao_pyramid_desc{}; // storage of the sao pyramid
+    int _sao_pyramid_levels = 0; // mip levels of the sao pyramid
 
-    std::optional<Shader> _ssao_blur_shader; // blur pass shader
-    GLuint _ssao_blur_buffer; // framebuffer id for blur pass
-    GLuint _ssao_color_blur_tex; // texture id for blur pass output
+    std::optional<Shader> _ssao_box_blur_shader; // box blur pass shader
+    std::optional<ShaderVariants> _ssao_blur_shaders; // bilateral blur
+    std::optional<ShaderVariants> _ssao_blur_compute_shaders; // cached lines
+    std::optional<Shader> _ssao_downsample_shader; // reduces depth/normals
+    std::optional<Shader> _ssao_upsample_shader; // joint bilateral upsample
+    std::optional<Shader> _ssao_deinterleave_shader; // splits into tiles
+    std::optional<Shader> _ssao_reinterleave_shader; // merges tiles
+    std::optional<Shader> _ssao_temporal_shader; // blends in the history
+    std::array<GLuint, 2> _ssao_history{}; // accumulated occlusion ping-pong
+    TextureDesc _ssao_history_desc{}; // storage of the history textures
+    size_t _ssao_history_idx = 0; // history written by the next frame
+    bool _ssao_history_valid = false; // the last frame wrote a history
+    glm::mat4 _ssao_history_view{}; // camera transform of the last history
+    glm::vec2 _ssao_history_uv_scale{}; // frame coverage of the last history
+    unsigned _ssao_frame = 0; // frame counter that varies the ssao noise
+    GLuint _occlusion_capture = 0; // texture to copy the occlusion into
+    GLuint _depth_capture = 0; // texture to copy the g-buffer depth into
+    GLuint _normal_capture = 0; // texture to copy the g-buffer normals into
+    glm::mat4 _projection{}; // projection of the last rendered frame
 
-    std::optional<Shader> _lighting_shader; // final pass shader
+    std::optional<ShaderVariants> _lighting_shaders; // lighting pass shaders
+    std::optional<LightClusters> _lights; // lights of the current scene
+    size_t _light_count = 0; // number of lights to generate
+    std::optional<size_t> _lights_scene; // scene the lights were made for
+    std::optional<Shader> _upscale_shader; // final pass shader
     bool _enable_ssao = true;
+    bool _specialize_shaders = true; // compile settings into shader variants
 
     // Keep constructor/destructor private for singletons.
-    Manager();
+    explicit Manager(std::optional<HeadlessSettings>);
     ~Manager();
 
-    // Run the full rendering pipeline (all passes).
-    void render();
+    // Render the frames of a headless run, print their timings, and write
+    // the last one to an image.
+    void run_headless();
+
+    // Publish the simulation state as a snapshot sampled now, with the
+    // camera still. Headless frames take one each, as there is no update
+    // thread.
+    void publish_state();
+
+    // Show the rendered frame in the window, if there is one.
+    void present();
+
+    // Get the shader definitions for the active ssao settings.
+    ShaderDefines ssao_defines() const;
+
+    // Regenerate the kernel and rotation texture when their settings change.
+    void update_sampling();
+
+    // Get the shader variants of the active ambient occlusion method.
+    ShaderVariants& ssao_variants();
+
+    // Get the shader definitions for the active blur settings.
+    ShaderDefines blur_defines() const;
+
+    // Get the shader definitions for the active lighting settings.
+    ShaderDefines lighting_defines() const;
+
+    // Regenerate the lights when the scene or light count changes.
+    void update_lights();
+
+    // Add the passes that compute ambient occlusion from the g-buffer, and
+    // get the frame-resolution occlusion texture.
+    RenderGraph::Handle add_ssao_passes(
+        RenderGraph&,
+        RenderGraph::Handle depth,
+        RenderGraph::Handle normal,
+        RenderGraph::Handle noise);
+
+    // Add the pass that fills the view distance pyramid of sao from depth,
+    // and get the pyramid texture.
+    RenderGraph::Handle add_sao_pyramid_pass(
+        RenderGraph&,
+        RenderGraph::Handle depth,
+        const TextureDesc&);
+
+    // Add the passes that blur the occlusion, and get the blurred texture.
+    RenderGraph::Handle add_ssao_blur_passes(
+        RenderGraph&,
+        RenderGraph::Handle occlusion,
+        RenderGraph::Handle depth,
+        RenderGraph::Handle normal,
+        const TextureDesc&);
+
+    // Add the pass that blends the occlusion into the history reprojected
+    // from the previous frame, and get the accumulated occlusion texture.
+    RenderGraph::Handle add_ssao_temporal_pass(
+        RenderGraph&,
+        RenderGraph::Handle occlusion,
+        RenderGraph::Handle depth,
+        RenderGraph::Handle normal,
+        const TextureDesc&);
+
+    // Add the pass that upscales the lit frame to the window.
+    void add_upscale_pass(RenderGraph&, RenderGraph::Handle lit);
+
+    // The stages of render_software, which the graph runs as separate
+    // passes. Rasterizing resets the occlusion to none.
+    void rasterize_software(ThreadPool&);
+    void software_ssao(ThreadPool&);
+    void blur_software_ssao(ThreadPool&);
+    std::vector<glm::u8vec4> light_software(ThreadPool&);
+
+    // Add a pass that copies the frame region of a texture into a capture
+    // texture.
+    void add_capture_pass(
+        RenderGraph&,
+        RenderGraph::Handle source,
+        GLuint capture,
+        GLenum format);
 
     // Draw the screen-filling quad.
     void draw_quad();
 
-    // Toggle ssao appearance in output.
-    void toggle_ssao();
+    // Poll input and advance the simulation at a fixed rate until quit.
+    void update_loop();
+
+    // Render the latest simulation snapshot until quit.
+    void render_loop();
+
+    // Pace, render, and present one frame of the latest snapshot.
+    void run_frame(PacingSettings);
+
+    // Pick the window, render, and render target sizes for the next frame.
+    void update_resolution(const FrameState&);
 
     // Handle certain SDL events for user input.
     bool handle_event(const SDL_Event& event);
 
-    // Create the g-buffer framebuffer and all associated textures.
-    void construct_gbuffer();
-
-    // Create the ssao framebuffers and all associated textures.
-    void construct_ssao_buffers();
+    // Print the render graph statistics when they change.
+    void report_graph_stats();
 };
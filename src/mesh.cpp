@@ -1,23 +1,36 @@
 #include "mesh.hpp"
+#include "startup.hpp"
+
+#include <glm/common.hpp>
 
 Mesh::Mesh(
     std::span<Vertex> vertices,
     std::span<glm::uvec3> indices,
     TextureGroup texture)
-    : _texture{texture}, _vao{0}, _vert_count{static_cast<GLsizei>(
-                                      indices.size_bytes())} {
-    auto vbo = GLuint{};
-    glCreateBuffers(1, &vbo);
+    : _texture{texture}, _vao{0}, _vbo{0}, _ebo{0},
+      _vertex_count{static_cast<GLsizei>(vertices.size())},
+      _vert_count{static_cast<GLsizei>(indices.size() * 3)} {
+    auto phase = StartupPhase{"upload mesh"};
+    StartupReport::instance().add_uploaded(
+        vertices.size_bytes() + indices.size_bytes());
+    if (!vertices.empty()) {
+        _bounds = {vertices.front().position, vertices.front().position};
+    }
+    for (const auto& vertex : vertices) {
+        _bounds.min = glm::min(_bounds.min, vertex.position);
+        _bounds.max = glm::max(_bounds.max, vertex.position);
+    }
+
+    glCreateBuffers(1, &_vbo);
     glNamedBufferStorage(
-        vbo,
+        _vbo,
         static_cast<GLsizei>(vertices.size_bytes()),
         vertices.data(),
         GL_DYNAMIC_STORAGE_BIT);
 
-    auto ebo = GLuint{};
-    glCreateBuffers(1, &ebo);
+    glCreateBuffers(1, &_ebo);
     glNamedBufferStorage(
-        ebo,
+        _ebo,
         static_cast<GLsizei>(indices.size_bytes()),
         indices.data(),
         GL_DYNAMIC_STORAGE_BIT);
@@ -25,8 +38,8 @@ Mesh::Mesh(
     glCreateVertexArrays(1, &_vao);
 
     constexpr auto binding_idx = 0;
-    glVertexArrayVertexBuffer(_vao, binding_idx, vbo, 0, sizeof(Vertex));
-    glVertexArrayElementBuffer(_vao, ebo);
+    glVertexArrayVertexBuffer(_vao, binding_idx, _vbo, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(_vao, _ebo);
 
     auto attrib_idx = 0;
     glEnableVertexArrayAttrib(_vao, attrib_idx);
@@ -71,12 +84,9 @@ Mesh::Mesh(
         GL_FLOAT,
         GL_FALSE,
         offsetof(Vertex, tex_tangent));
-
-    glDeleteBuffers(1, &ebo);
-    glDeleteBuffers(1, &vbo);
 }
 
-Mesh::Mesh(Mesh&& m) noexcept : _vao{0} {
+Mesh::Mesh(Mesh&& m) noexcept : _vao{0}, _vbo{0}, _ebo{0} {
     Mesh::_swap(*this, m);
 }
 
@@ -87,6 +97,8 @@ Mesh& Mesh::operator=(Mesh&& m) noexcept {
 
 Mesh::~Mesh() {
     glDeleteVertexArrays(1, &_vao);
+    glDeleteBuffers(1, &_ebo);
+    glDeleteBuffers(1, &_vbo);
 }
 
 void Mesh::draw() const {
@@ -96,13 +108,45 @@ void Mesh::draw() const {
     glBindTextureUnit(0, diffuse);
     glBindTextureUnit(1, normal);
     glBindTextureUnit(2, specular);
+    draw_geometry();
+}
+
+void Mesh::draw_geometry() const {
     glBindVertexArray(_vao);
     glDrawElements(GL_TRIANGLES, _vert_count, GL_UNSIGNED_INT, nullptr);
     glBindVertexArray(0);
 }
 
+const TextureGroup& Mesh::texture() const {
+    return _texture;
+}
+
+GLuint Mesh::vertex_buffer() const {
+    return _vbo;
+}
+
+GLuint Mesh::index_buffer() const {
+    return _ebo;
+}
+
+GLsizei Mesh::vertex_count() const {
+    return _vertex_count;
+}
+
+GLsizei Mesh::triangle_count() const {
+    return _vert_count / 3;
+}
+
+const Bounds& Mesh::bounds() const {
+    return _bounds;
+}
+
 void Mesh::_swap(Mesh& a, Mesh& b) {
     std::swap(a._texture, b._texture);
     std::swap(a._vao, b._vao);
+    std::swap(a._vbo, b._vbo);
+    std::swap(a._ebo, b._ebo);
+    std::swap(a._vertex_count, b._vertex_count);
     std::swap(a._vert_count, b._vert_count);
+    std::swap(a._bounds, b._bounds);
 }
@@ -16,6 +16,12 @@ struct Vertex {
     glm::vec3 tex_tangent;
 };
 
+// A Bounds is an axis-aligned bounding box.
+struct Bounds {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
 // A mesh is a piece of geometry.
 class Mesh {
   public:
@@ -32,10 +38,35 @@ class Mesh {
     // Render this geometry.
     void draw() const;
 
+    // Render this geometry without binding its textures.
+    void draw_geometry() const;
+
+    // Get the textures associated with this mesh.
+    const TextureGroup& texture() const;
+
+    // Get the opengl id of the vertex buffer.
+    GLuint vertex_buffer() const;
+
+    // Get the opengl id of the index buffer.
+    GLuint index_buffer() const;
+
+    // Get the number of vertices in the vertex buffer.
+    GLsizei vertex_count() const;
+
+    // Get the number of triangles in the index buffer.
+    GLsizei triangle_count() const;
+
+    // Get the bounding box of the vertices.
+    const Bounds& bounds() const;
+
   private:
     TextureGroup _texture{}; // textures associated with this mesh
     GLuint _vao; // vertex array object id
+    GLuint _vbo; // vertex buffer id
+    GLuint _ebo; // index buffer id
+    GLsizei _vertex_count{}; // number of vertices to this mesh
     GLsizei _vert_count{}; // number of elements to this mesh
+    Bounds _bounds{}; // bounding box of the vertices
 
     // Swap the contents of two meshes.
     static void _swap(Mesh&, Mesh&);
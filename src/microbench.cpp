@@ -0,0 +1,411 @@
+#include "camera.hpp"
+#include "headless.hpp"
+#include "image_metrics.hpp"
+#include "loader.hpp"
+#include "sampling.hpp"
+
+#include <fmt/core.h>
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto min_samples = 10; // runs timed per benchmark at least
+constexpr auto max_samples = 1000; // runs timed per benchmark at most
+constexpr auto min_seconds = 0.5; // time spent per benchmark at least
+constexpr auto default_tolerance = 0.25; // median slowdown marked
+constexpr auto grid_size = 128; // quads along each side of the test mesh
+constexpr auto png_size = 512; // width of the test png texture
+constexpr auto ppm_size = 128; // width of the test ascii ppm texture
+constexpr auto kernel_size = 64; // samples of the generated kernels
+constexpr auto noise_size = 4; // width of the generated rotations
+constexpr auto camera_steps = 1000; // camera updates per run
+constexpr auto usage_error = 2; // exit code of invalid arguments
+
+// A Result is the distribution of the times of one benchmark.
+struct Result {
+    std::string name;
+    int samples;
+    double min_us;
+    double median_us;
+    double p99_us;
+};
+
+// Keep the compiler from optimizing away a value that is never used.
+#if defined(__GNUC__) || defined(__clang__)
+template <typename T> void keep(const T& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+#else
+const void* volatile kept = nullptr; // escapes the kept values
+
+template <typename T> void keep(const T& value) {
+    kept = &value;
+}
+#endif
+
+// A Suite is the results of the benchmarks that match a filter.
+struct Suite {
+    std::string filter; // part of the names of the benchmarks to run
+    std::vector<Result> results;
+
+    // Time a function until enough runs are collected, after one warm-up
+    // run, if its name matches the filter.
+    void measure(std::string name, const std::function<void()>& run);
+};
+
+void Suite::measure(std::string name, const std::function<void()>& run) {
+    using Clock = std::chrono::steady_clock;
+    if (name.find(filter) == std::string::npos) {
+        return;
+    }
+    run();
+    auto times = std::vector<double>{};
+    auto start = Clock::now();
+    while (static_cast<int>(times.size()) < max_samples &&
+           (static_cast<int>(times.size()) < min_samples ||
+            std::chrono::duration<double>(Clock::now() - start).count() <
+                min_seconds)) {
+        auto begin = Clock::now();
+        run();
+        times.emplace_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - begin)
+                .count());
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) {
+        auto i = static_cast<size_t>(
+            p * static_cast<double>(times.size() - 1) + 0.5);
+        return times[i];
+    };
+    results.emplace_back(Result{
+        std::move(name),
+        static_cast<int>(times.size()),
+        times.front(),
+        percentile(0.5),
+        percentile(0.99)});
+}
+
+// Write a square grid of triangles with normals and texture coordinates as a
+// wavefront .obj file. Vertices are shared between faces, so loading welds
+// them.
+void write_grid_obj(const std::filesystem::path& path, int size) {
+    auto file = std::ofstream{path};
+    for (auto y = 0; y <= size; y++) {
+        for (auto x = 0; x <= size; x++) {
+            auto height = 0.1F * static_cast<float>((x * 7 + y * 13) % 5);
+            file << fmt::format("v {} {} {}\n", x, height, y);
+            file << fmt::format(
+                "vt {} {}\n",
+                static_cast<float>(x) / static_cast<float>(size),
+                static_cast<float>(y) / static_cast<float>(size));
+        }
+    }
+    file << "vn 0 1 0\n";
+    for (auto y = 0; y < size; y++) {
+        for (auto x = 0; x < size; x++) {
+            auto i = y * (size + 1) + x + 1;
+            auto j = i + size + 1;
+            file << fmt::format(
+                "f {0}/{0}/1 {1}/{1}/1 {2}/{2}/1\n"
+                "f {0}/{0}/1 {2}/{2}/1 {3}/{3}/1\n",
+                i,
+                i + 1,
+                j + 1,
+                j);
+        }
+    }
+}
+
+// Write a square of random colors as an ascii (P3) ppm file.
+void write_ascii_ppm(const std::filesystem::path& path, int size) {
+    auto random = std::mt19937{1};
+    auto file = std::ofstream{path};
+    file << fmt::format("P3\n# microbench\n{} {}\n255\n", size, size);
+    for (auto i = 0; i < size * size * 3; i++) {
+        file << random() % 256 << (i % 12 == 11 ? '\n' : ' ');
+    }
+}
+
+// Write a square of random colors as a png file.
+void write_random_png(const std::filesystem::path& path, int size) {
+    auto random = std::mt19937{2};
+    auto pixels = std::vector<glm::u8vec4>(static_cast<size_t>(size * size));
+    for (auto& pixel : pixels) {
+        auto color = random();
+        pixel = glm::u8vec4{color, color >> 8U, color >> 16U, 255};
+    }
+    write_png(path, size, size, pixels);
+}
+
+// Time the steps of the loader on generated files.
+void benchmark_loader(Suite& suite, const std::filesystem::path& directory) {
+    auto obj = directory / "grid.obj";
+    auto png = directory / "texture.png";
+    auto ppm = directory / "texture.ppm";
+    write_grid_obj(obj, grid_size);
+    write_random_png(png, png_size);
+    write_ascii_ppm(ppm, ppm_size);
+
+    auto reader = Loader::read_obj(obj);
+    const auto& shape = reader.GetShapes().front();
+    auto mesh = Loader::gen_mesh_data(shape, reader.GetAttrib());
+
+    suite.measure("loader/read_obj", [&obj] {
+        keep(Loader::read_obj(obj));
+    });
+    suite.measure("loader/gen_mesh_data", [&] {
+        keep(Loader::gen_mesh_data(shape, reader.GetAttrib()));
+    });
+    suite.measure("loader/generate_tangents", [&mesh] {
+        for (const auto& face : mesh.indices) {
+            Loader::generate_tangents(mesh.vertices, face);
+        }
+        keep(mesh.vertices);
+    });
+    suite.measure("loader/read_ppm", [&ppm] {
+        keep(Loader::read_ppm(ppm));
+    });
+
+    // Uploads go to a headless context, and finish before the time is taken.
+    suite.measure("loader/read_texture_png", [&png] {
+        keep(Loader::read_texture(png));
+        glFinish();
+    });
+    suite.measure("loader/read_texture_ppm", [&ppm] {
+        keep(Loader::read_texture(ppm));
+        glFinish();
+    });
+}
+
+// Time the camera updates of a simulation tick and the view matrix.
+void benchmark_camera(Suite& suite) {
+    suite.measure("camera/move_rotate", [] {
+        auto camera = Camera{};
+        for (auto i = 0; i < camera_steps; i++) {
+            camera.move_forward(0.01F);
+            camera.move_right(0.01F);
+            camera.rotate(0.1F, 0.2F);
+        }
+        keep(camera);
+    });
+    suite.measure("camera/interpolate_transform", [] {
+        auto from = Camera{glm::vec3{0.0F}, 0.0F, -90.0F};
+        auto to = Camera{glm::vec3{1.0F}, 10.0F, 30.0F};
+        auto sum = glm::mat4{0.0F};
+        for (auto i = 0; i < camera_steps; i++) {
+            auto t = static_cast<float>(i) / camera_steps;
+            sum += Camera::interpolate(from, to, t).transform();
+        }
+        keep(sum);
+    });
+}
+
+// Time the generation of every ssao kernel pattern and the rotations.
+void benchmark_sampling(Suite& suite) {
+    constexpr auto patterns = std::array{
+        std::pair{"classic", KernelPattern::Classic},
+        std::pair{"random", KernelPattern::Random},
+        std::pair{"hammersley", KernelPattern::Hammersley},
+        std::pair{"halton", KernelPattern::Halton},
+        std::pair{"poisson", KernelPattern::PoissonDisk}};
+    for (const auto& [name, pattern] : patterns) {
+        suite.measure(fmt::format("sampling/kernel_{}", name), [pattern] {
+            keep(generate_kernel(pattern, kernel_size, 1));
+        });
+    }
+    suite.measure("sampling/rotations_white", [] {
+        keep(generate_rotations(NoisePattern::White, noise_size, 1));
+    });
+    suite.measure("sampling/rotations_blue", [] {
+        keep(generate_rotations(NoisePattern::Blue, noise_size, 1));
+    });
+}
+
+// Write results as json.
+bool write_results(
+    const std::filesystem::path& path,
+    std::span<const Result> results) {
+    auto file = std::ofstream{path};
+    file << "{\n  \"benchmarks\": [";
+    for (auto i = size_t{0}; i < results.size(); i++) {
+        const auto& r = results[i];
+        file << fmt::format(
+            "{}\n    {{\"name\": \"{}\", \"samples\": {}, \"min_us\": {:.3f}, "
+            "\"median_us\": {:.3f}, \"p99_us\": {:.3f}}}",
+            i == 0 ? "" : ",",
+            r.name,
+            r.samples,
+            r.min_us,
+            r.median_us,
+            r.p99_us);
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
+
+// Read the median time of every benchmark from results written by
+// write_results, or get nothing if the file cannot be read.
+std::optional<std::map<std::string, double>>
+read_baseline(const std::filesystem::path& path) {
+    auto file = std::ifstream{path};
+    if (!file) {
+        return std::nullopt;
+    }
+    auto text = (std::stringstream{} << file.rdbuf()).str();
+    auto medians = std::map<std::string, double>{};
+    constexpr auto name_key = std::string_view{"\"name\": \""};
+    constexpr auto median_key = std::string_view{"\"median_us\": "};
+    for (auto at = text.find(name_key); at != std::string::npos;
+         at = text.find(name_key, at)) {
+        at += name_key.size();
+        auto name_end = text.find('"', at);
+        auto median = text.find(median_key, name_end);
+        if (name_end == std::string::npos || median == std::string::npos) {
+            return std::nullopt;
+        }
+        medians[text.substr(at, name_end - at)] =
+            std::strtod(text.c_str() + median + median_key.size(), nullptr);
+    }
+    return medians;
+}
+
+void print_usage() {
+    fmt::print(
+        stderr,
+        "usage: microbench [--output FILE.json] [--baseline FILE.json] "
+        "[--tolerance F] [--filter TEXT]\n");
+}
+} // namespace
+
+/*
+ * MICROBENCHMARKS
+ *
+ * Usage:
+ *  ./microbench [OPTIONS]
+ *
+ *  Times the hot paths of the loader, the camera, and the ssao sample
+ *  generation in isolation, on generated inputs. Texture uploads run in a
+ *  headless egl context. Prints the min, median and 99th percentile time of
+ *  each benchmark, and how each median compares to a baseline. Run through
+ *  meson with `meson test --benchmark` (or `ninja benchmark`), which compares
+ *  to benchmarks/baseline.json. Timings depend on the machine, so regenerate
+ *  that file on yours with --output before relying on the comparison.
+ *
+ * Options:
+ *  --output FILE.json: Write the results (microbench.json)
+ *  --baseline FILE.json: Compare the medians to earlier results of the
+ *    same machine, e.g. benchmarks/baseline.json, marking those slower by
+ *    more than the tolerance
+ *  --tolerance F: Exit with 1 when a median is slower than the baseline by
+ *    more than this fraction (only marked, by 0.25, without it)
+ *  --filter TEXT: Run only the benchmarks whose name contains the text
+ */
+int main(int argc, char* argv[]) {
+    auto args = std::span(argv + 1, static_cast<size_t>(argc - 1));
+    auto output = std::filesystem::path{"microbench.json"};
+    auto baseline_path = std::optional<std::filesystem::path>{};
+    auto tolerance = default_tolerance;
+    auto strict = false; // fail on regressions
+    auto suite = Suite{};
+    for (auto i = size_t{0}; i < args.size(); i++) {
+        auto arg = std::string_view{args[i]};
+        if (i + 1 == args.size()) {
+            print_usage();
+            return usage_error;
+        }
+        const auto* value = args[++i];
+        if (arg == "--output") {
+            output = value;
+        } else if (arg == "--baseline") {
+            baseline_path = value;
+        } else if (arg == "--tolerance") {
+            tolerance = std::strtod(value, nullptr);
+            strict = true;
+        } else if (arg == "--filter") {
+            suite.filter = value;
+        } else {
+            print_usage();
+            return usage_error;
+        }
+    }
+
+    auto baseline = std::optional<std::map<std::string, double>>{};
+    if (baseline_path) {
+        baseline = read_baseline(*baseline_path);
+        if (!baseline) {
+            fmt::print(stderr, "could not read {}\n", baseline_path->string());
+            return usage_error;
+        }
+    }
+
+    auto context = HeadlessContext{};
+    if (gladLoadGLLoader(HeadlessContext::get_proc_address) == 0) {
+        std::terminate();
+    }
+    auto directory = std::filesystem::temp_directory_path() / "microbench";
+    std::filesystem::create_directories(directory);
+
+    benchmark_loader(suite, directory);
+    benchmark_camera(suite);
+    benchmark_sampling(suite);
+    std::filesystem::remove_all(directory);
+
+    auto regressions = 0;
+    fmt::print(
+        "{:<32} {:>7} {:>10} {:>10} {:>10} {:>10}\n",
+        "benchmark",
+        "samples",
+        "min us",
+        "median us",
+        "p99 us",
+        "vs base");
+    for (const auto& r : suite.results) {
+        auto change = std::string{"-"};
+        if (baseline && baseline->contains(r.name)) {
+            auto ratio = r.median_us / baseline->at(r.name);
+            change = fmt::format("{:+.1f}%", (ratio - 1.0) * 100.0);
+            if (ratio > 1.0 + tolerance) {
+                change += " !";
+                regressions++;
+            }
+        }
+        fmt::print(
+            "{:<32} {:>7} {:>10.2f} {:>10.2f} {:>10.2f} {:>10}\n",
+            r.name,
+            r.samples,
+            r.min_us,
+            r.median_us,
+            r.p99_us,
+            change);
+    }
+
+    if (!write_results(output, suite.results)) {
+        fmt::print(stderr, "could not write {}\n", output.string());
+        return EXIT_FAILURE;
+    }
+    fmt::print("wrote {}\n", output.string());
+    if (regressions > 0) {
+        fmt::print("{} benchmarks regressed\n", regressions);
+        if (strict) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
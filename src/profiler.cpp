@@ -0,0 +1,181 @@
+#include "profiler.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <utility>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto max_timeline_events = size_t{1} << 20;
+constexpr auto gpu_thread = size_t{0}; // trace thread id of the gpu timeline
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Escape a name for a json string.
+std::string escape(std::string_view name) {
+    auto escaped = std::string{};
+    for (auto c : name) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+    return escaped;
+}
+} // namespace
+
+Profiler& Profiler::instance() {
+    static auto profiler = Profiler{};
+    return profiler;
+}
+
+Profiler::Profiler() : _start_ns{steady_ns()} {}
+
+void Profiler::set_enabled(bool enabled) {
+    _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::enabled() const {
+    return _enabled.load(std::memory_order_relaxed);
+}
+
+int64_t Profiler::now_ns() const {
+    return steady_ns() - _start_ns;
+}
+
+void Profiler::set_thread_name(std::string name) {
+    auto& r = ring();
+    auto lock = std::lock_guard{_mutex};
+    r.name = std::move(name);
+}
+
+const char* Profiler::intern(std::string_view name) {
+    auto lock = std::lock_guard{_mutex};
+    return _names.emplace(name).first->c_str();
+}
+
+void Profiler::record(const Event& event) {
+    auto& r = ring();
+    auto head = r.head.load(std::memory_order_relaxed);
+    if (head - r.tail.load(std::memory_order_acquire) == ring_size) {
+        r.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    r.events[head % ring_size] = event;
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::collect() {
+    auto lock = std::lock_guard{_mutex};
+    for (auto t = size_t{0}; t < _rings.size(); t++) {
+        auto& r = *_rings[t];
+        auto head = r.head.load(std::memory_order_acquire);
+        auto tail = r.tail.load(std::memory_order_relaxed);
+        for (; tail != head; tail++) {
+            const auto& event = r.events[tail % ring_size];
+            if (_timeline.size() < max_timeline_events) {
+                _timeline.emplace_back(TimelineEvent{event, t});
+            } else {
+                _dropped++;
+            }
+
+            // Replace the oldest sample of the window.
+            auto& window = _windows[{event.name, event.gpu}];
+            auto& sample = window.samples[window.count % average_window];
+            auto ms = static_cast<double>(event.end_ns - event.begin_ns) / 1e6;
+            window.sum += ms - sample;
+            sample = ms;
+            window.count++;
+        }
+        r.tail.store(tail, std::memory_order_release);
+    }
+}
+
+std::vector<Profiler::Average> Profiler::averages() const {
+    auto lock = std::lock_guard{_mutex};
+    auto averages = std::vector<Average>{};
+    for (const auto& [key, window] : _windows) {
+        auto count = std::min(window.count, average_window);
+        averages.emplace_back(Average{
+            key.first,
+            key.second,
+            window.sum / static_cast<double>(count)});
+    }
+    return averages;
+}
+
+const std::vector<Profiler::TimelineEvent>& Profiler::timeline() const {
+    return _timeline;
+}
+
+size_t Profiler::dropped() const {
+    auto lock = std::lock_guard{_mutex};
+    auto dropped = _dropped;
+    for (const auto& r : _rings) {
+        dropped += r->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+bool Profiler::write_chrome_trace(const std::filesystem::path& path) {
+    collect();
+    auto lock = std::lock_guard{_mutex};
+    auto file = std::ofstream{path};
+    file << "{\"traceEvents\":[\n";
+    file << fmt::format(
+        "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"gpu\"}}}}",
+        gpu_thread);
+    for (auto t = size_t{0}; t < _rings.size(); t++) {
+        auto name = _rings[t]->name.empty() ? fmt::format("thread {}", t)
+                                            : escape(_rings[t]->name);
+        file << fmt::format(
+            ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+            "\"args\":{{\"name\":\"{}\"}}}}",
+            t + 1,
+            name);
+    }
+    for (const auto& [event, thread] : _timeline) {
+        file << fmt::format(
+            ",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+            "\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+            escape(event.name),
+            event.gpu ? "gpu" : "cpu",
+            static_cast<double>(event.begin_ns) / 1e3,
+            static_cast<double>(event.end_ns - event.begin_ns) / 1e3,
+            event.gpu ? gpu_thread : thread + 1);
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+Profiler::Ring& Profiler::ring() {
+    thread_local Ring* ring = nullptr;
+    if (ring == nullptr) {
+        auto lock = std::lock_guard{_mutex};
+        ring = _rings.emplace_back(std::make_unique<Ring>()).get();
+    }
+    return *ring;
+}
+
+ProfileScope::ProfileScope(const char* name) : _name{nullptr} {
+    auto& profiler = Profiler::instance();
+    if (profiler.enabled()) {
+        _name = name;
+        _begin_ns = profiler.now_ns();
+    }
+}
+
+ProfileScope::~ProfileScope() {
+    if (_name != nullptr) {
+        auto& profiler = Profiler::instance();
+        profiler.record({_name, _begin_ns, profiler.now_ns(), false});
+    }
+}
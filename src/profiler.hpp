@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// A Profiler collects cpu scopes and gpu pass times into one timeline.
+// Threads record events into their own lock-free ring buffer, which is
+// drained by collect(), so recording never waits for another thread.
+class Profiler {
+  public:
+    // An Event is a timed range, in nanoseconds since the profiler started.
+    struct Event {
+        const char* name; // static or interned name
+        int64_t begin_ns;
+        int64_t end_ns;
+        bool gpu; // on the gpu timeline instead of the recording thread
+    };
+
+    // A TimelineEvent is a collected event and the thread that recorded it.
+    struct TimelineEvent {
+        Event event;
+        size_t thread; // index of the recording thread
+    };
+
+    // An Average is the mean time of a scope or pass over its latest runs.
+    struct Average {
+        std::string name;
+        bool gpu;
+        double ms;
+    };
+
+    // Get the profiler shared by all threads.
+    static Profiler& instance();
+
+    // Disallow copies and moves.
+    Profiler(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    Profiler& operator=(Profiler&&) = delete;
+    ~Profiler() = default;
+
+    // Start or stop recording. Scopes cost one relaxed load while stopped.
+    void set_enabled(bool);
+    [[nodiscard]] bool enabled() const;
+
+    // Get the current time on the timeline.
+    [[nodiscard]] int64_t now_ns() const;
+
+    // Name the calling thread in exported traces.
+    void set_thread_name(std::string);
+
+    // Get a pointer to a copy of a name that lives as long as the profiler,
+    // for events with names that are not string literals.
+    const char* intern(std::string_view);
+
+    // Record an event from the calling thread. It is dropped if the thread's
+    // ring buffer is full.
+    void record(const Event&);
+
+    // Move the recorded events of all threads into the timeline and update
+    // the averages.
+    void collect();
+
+    // Get the mean time of every scope and pass over its latest runs,
+    // ordered by name.
+    [[nodiscard]] std::vector<Average> averages() const;
+
+    // Get the collected timeline. Not synchronized with collect().
+    [[nodiscard]] const std::vector<TimelineEvent>& timeline() const;
+
+    // Get the number of events dropped because a ring buffer or the
+    // timeline was full.
+    [[nodiscard]] size_t dropped() const;
+
+    // Collect the latest events, and write the timeline as chrome trace
+    // json (chrome://tracing or ui.perfetto.dev).
+    bool write_chrome_trace(const std::filesystem::path&);
+
+  private:
+    static constexpr auto ring_size = size_t{1} << 14;
+    static constexpr auto average_window = size_t{64};
+
+    // A Ring is the buffer of one thread. The thread only writes the head,
+    // and collect() only writes the tail.
+    struct Ring {
+        std::array<Event, ring_size> events;
+        std::atomic<size_t> head = 0;
+        std::atomic<size_t> tail = 0;
+        std::atomic<size_t> dropped = 0;
+        std::string name;
+    };
+
+    // A Window holds the latest times of a scope or pass.
+    struct Window {
+        std::array<double, average_window> samples{};
+        size_t count = 0; // number of samples ever added
+        double sum = 0.0; // of the samples in the window
+    };
+
+    Profiler();
+
+    std::atomic<bool> _enabled = false;
+    int64_t _start_ns; // steady clock time of the timeline origin
+    mutable std::mutex _mutex; // guards everything below
+    std::vector<std::unique_ptr<Ring>> _rings; // of every recording thread
+    std::unordered_set<std::string> _names; // interned names
+    std::vector<TimelineEvent> _timeline;
+    std::map<std::pair<std::string, bool>, Window> _windows; // name, gpu
+    size_t _dropped = 0; // events that did not fit in the timeline
+
+    // Get the ring buffer of the calling thread, creating it if needed.
+    Ring& ring();
+};
+
+// A ProfileScope records the cpu time from its creation to its destruction.
+// The name must outlive the profiler (e.g. a string literal).
+class ProfileScope {
+  public:
+    explicit ProfileScope(const char* name);
+
+    // Disallow copies and moves.
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope(ProfileScope&&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    ProfileScope& operator=(ProfileScope&&) = delete;
+    ~ProfileScope();
+
+  private:
+    const char* _name; // nullptr while the profiler is stopped
+    int64_t _begin_ns = 0;
+};
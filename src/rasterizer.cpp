@@ -0,0 +1,456 @@
+#include "rasterizer.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RASTERIZER_AVX2
+#include <immintrin.h>
+#endif
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto chunk_faces = size_t{8192}; // faces set up by one task
+constexpr auto triangle_bits = 16; // bits of the triangle index in an id
+constexpr auto no_triangle = std::numeric_limits<uint32_t>::max();
+
+static_assert(2 * chunk_faces <= size_t{1} << triangle_bits);
+
+// Get the edge function that is positive on the left of the edge from a to
+// b, as coefficients of (x, y, 1).
+glm::vec3 edge_function(glm::vec2 a, glm::vec2 b) {
+    auto normal = glm::vec2{a.y - b.y, b.x - a.x};
+    return {normal, -glm::dot(normal, a)};
+}
+
+// Evaluate a pixel-space plane at a point. The scalar and vectorized
+// rasterizers evaluate planes in the same order to cover the same pixels.
+float evaluate(glm::vec3 plane, float x, float y) {
+    return plane.x * x + (plane.y * y + plane.z);
+}
+
+// Rasterize a triangle into the rows of a rectangle (min x, min y, max x,
+// max y) of the visibility buffer.
+void rasterize_scalar(
+    const std::array<glm::vec3, 3>& edges,
+    glm::vec3 depth_plane,
+    glm::ivec4 rect,
+    uint32_t id,
+    int width,
+    float* depth,
+    uint32_t* ids) {
+    for (auto y = rect.y; y <= rect.w; y++) {
+        auto py = static_cast<float>(y) + 0.5F;
+        for (auto x = rect.x; x <= rect.z; x++) {
+            auto px = static_cast<float>(x) + 0.5F;
+            if (evaluate(edges[0], px, py) < 0.0F ||
+                evaluate(edges[1], px, py) < 0.0F ||
+                evaluate(edges[2], px, py) < 0.0F) {
+                continue;
+            }
+            auto z = evaluate(depth_plane, px, py);
+            auto index = static_cast<size_t>(y * width + x);
+            if (z < depth[index]) {
+                depth[index] = z;
+                ids[index] = id;
+            }
+        }
+    }
+}
+
+#ifdef RASTERIZER_AVX2
+#define AVX2 __attribute__((target("avx2")))
+
+// Evaluate a pixel-space plane at 8 points.
+AVX2 __m256 evaluate(glm::vec3 plane, __m256 x, __m256 y) {
+    return _mm256_add_ps(
+        _mm256_mul_ps(_mm256_set1_ps(plane.x), x),
+        _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(plane.y), y),
+            _mm256_set1_ps(plane.z)));
+}
+
+// Rasterize a triangle as rasterize_scalar does, 8 pixels of a row at a
+// time.
+AVX2 void rasterize_avx2(
+    const std::array<glm::vec3, 3>& edges,
+    glm::vec3 depth_plane,
+    glm::ivec4 rect,
+    uint32_t id,
+    int width,
+    float* depth,
+    uint32_t* ids) {
+    auto zero = _mm256_setzero_ps();
+    auto lane = _mm256_setr_ps(0.5F, 1.5F, 2.5F, 3.5F, 4.5F, 5.5F, 6.5F, 7.5F);
+    auto last = _mm256_set1_ps(static_cast<float>(rect.z) + 0.5F);
+    auto value = _mm256_set1_epi32(static_cast<int>(id));
+    for (auto y = rect.y; y <= rect.w; y++) {
+        auto py = _mm256_set1_ps(static_cast<float>(y) + 0.5F);
+        for (auto x = rect.x; x <= rect.z; x += 8) {
+            auto px =
+                _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lane);
+            auto valid = _mm256_cmp_ps(px, last, _CMP_LE_OQ);
+            auto inside = valid;
+            for (const auto& edge : edges) {
+                inside = _mm256_and_ps(
+                    inside,
+                    _mm256_cmp_ps(evaluate(edge, px, py), zero, _CMP_GE_OQ));
+            }
+            if (_mm256_movemask_ps(inside) == 0) {
+                continue;
+            }
+            auto* row_depth = depth + y * width + x;
+            auto* row_ids = ids + y * width + x;
+            auto z = evaluate(depth_plane, px, py);
+            auto current =
+                _mm256_maskload_ps(row_depth, _mm256_castps_si256(valid));
+            auto pass = _mm256_castps_si256(
+                _mm256_and_ps(inside, _mm256_cmp_ps(z, current, _CMP_LT_OQ)));
+            _mm256_maskstore_ps(row_depth, pass, z);
+            _mm256_maskstore_epi32(
+                reinterpret_cast<int*>(row_ids),
+                pass,
+                value);
+        }
+    }
+}
+#endif
+} // namespace
+
+Rasterizer::Rasterizer(int tile_size) : _tile_size{tile_size} {}
+
+void Rasterizer::render(
+    const HostScene& scene,
+    const glm::mat4& view,
+    const glm::mat4& projection,
+    glm::ivec2 size,
+    ThreadPool& pool,
+    bool vectorize) {
+    auto pixels = static_cast<size_t>(size.x) * static_cast<size_t>(size.y);
+    _depth.resize(pixels);
+    _ids.resize(pixels);
+    _frame.gbuffer.width = size.x;
+    _frame.gbuffer.height = size.y;
+    _frame.gbuffer.depth.resize(pixels);
+    _frame.gbuffer.normals.resize(pixels);
+    _frame.diffuse_spec.resize(pixels);
+    _tiles = (size + _tile_size - 1) / _tile_size;
+    auto tile_count = static_cast<size_t>(_tiles.x * _tiles.y);
+
+    // Set up and bin the faces in chunks.
+    _first_faces.clear();
+    auto face_count = size_t{0};
+    for (const auto& mesh : scene.meshes) {
+        _first_faces.emplace_back(face_count);
+        face_count += mesh.faces.size();
+    }
+    _chunks.resize((face_count + chunk_faces - 1) / chunk_faces);
+    auto view_projection = projection * view;
+    pool.run(_chunks.size(), [&](size_t c) {
+        auto scope = ProfileScope{"setup chunk"};
+        auto& chunk = _chunks[c];
+        chunk.triangles.clear();
+        chunk.bins.resize(tile_count);
+        for (auto& bin : chunk.bins) {
+            bin.clear();
+        }
+        auto first = c * chunk_faces;
+        auto last = std::min(first + chunk_faces, face_count);
+        setup(chunk, scene, view_projection, size, first, last);
+    });
+
+    // Rasterize the tiles, and resolve the visible triangles.
+    auto avx2 = vectorize && cpu_ssao_vectorized();
+    pool.run(tile_count, [&](size_t tile) {
+        auto scope = ProfileScope{"rasterize tile"};
+        rasterize_tile(static_cast<int>(tile), size, avx2);
+    });
+    auto scope = ProfileScope{"resolve"};
+    pool.run(static_cast<size_t>(size.y), [&](size_t y) {
+        resolve_row(scene, view, static_cast<int>(y), size);
+    });
+}
+
+const SoftwareFrame& Rasterizer::frame() const {
+    return _frame;
+}
+
+void Rasterizer::setup(
+    Chunk& chunk,
+    const HostScene& scene,
+    const glm::mat4& view_projection,
+    glm::ivec2 size,
+    size_t first,
+    size_t last) {
+    auto mesh_idx = static_cast<size_t>(
+        std::upper_bound(_first_faces.begin(), _first_faces.end(), first) -
+        _first_faces.begin() - 1);
+    for (auto f = first; f < last; f++) {
+        while (f - _first_faces[mesh_idx] >=
+               scene.meshes[mesh_idx].faces.size()) {
+            mesh_idx++;
+        }
+        const auto& mesh = scene.meshes[mesh_idx];
+        auto face_idx = f - _first_faces[mesh_idx];
+        const auto& face = mesh.faces[face_idx];
+
+        auto vertices = std::array<ClipVertex, 3>{};
+        for (auto i = 0; i < 3; i++) {
+            auto position = mesh.vertices[face[i]].position;
+            vertices[static_cast<size_t>(i)] = {
+                view_projection * glm::vec4{position, 1.0F},
+                glm::vec3{i == 0, i == 1, i == 2}};
+        }
+
+        // Skip triangles outside of one side of the frustum.
+        auto outside = [&vertices](int axis, float sign) {
+            return std::all_of(
+                vertices.begin(),
+                vertices.end(),
+                [axis, sign](const ClipVertex& v) {
+                    return sign * v.position[axis] > v.position.w;
+                });
+        };
+        if (outside(0, 1.0F) || outside(0, -1.0F) || outside(1, 1.0F) ||
+            outside(1, -1.0F) || outside(2, -1.0F)) {
+            continue;
+        }
+
+        auto mesh_id = static_cast<uint32_t>(mesh_idx);
+        auto face_id = static_cast<uint32_t>(face_idx);
+        auto near = [](const ClipVertex& v) {
+            return v.position.z + v.position.w;
+        };
+        if (std::all_of(vertices.begin(), vertices.end(), [&](const auto& v) {
+                return near(v) >= 0.0F;
+            })) {
+            add_triangle(chunk, vertices, size, mesh_id, face_id);
+            continue;
+        }
+
+        // Clip the triangle against the near plane, and split the polygon
+        // into a fan of triangles.
+        auto polygon = std::vector<ClipVertex>{};
+        for (auto i = size_t{0}; i < 3; i++) {
+            const auto& a = vertices[i];
+            const auto& b = vertices[(i + 1) % 3];
+            if (near(a) >= 0.0F) {
+                polygon.emplace_back(a);
+            }
+            if ((near(a) >= 0.0F) != (near(b) >= 0.0F)) {
+                auto t = near(a) / (near(a) - near(b));
+                polygon.emplace_back(ClipVertex{
+                    glm::mix(a.position, b.position, t),
+                    glm::mix(a.barycentric, b.barycentric, t)});
+            }
+        }
+        for (auto i = size_t{2}; i < polygon.size(); i++) {
+            add_triangle(
+                chunk,
+                {polygon[0], polygon[i - 1], polygon[i]},
+                size,
+                mesh_id,
+                face_id);
+        }
+    }
+}
+
+void Rasterizer::add_triangle(
+    Chunk& chunk,
+    const std::array<ClipVertex, 3>& vertices,
+    glm::ivec2 size,
+    uint32_t mesh,
+    uint32_t face) {
+    auto screen = std::array<glm::vec2, 3>{};
+    auto triangle = Triangle{};
+    auto depth = glm::vec3{};
+    for (auto i = size_t{0}; i < 3; i++) {
+        const auto& position = vertices[i].position;
+        auto ndc = glm::vec3{position} / position.w;
+        screen[i] = (glm::vec2{ndc} * 0.5F + 0.5F) * glm::vec2{size};
+        depth[static_cast<glm::length_t>(i)] = ndc.z * 0.5F + 0.5F;
+        triangle.inverse_w[static_cast<glm::length_t>(i)] = 1.0F / position.w;
+        triangle.barycentric[i] = vertices[i].barycentric;
+    }
+
+    // Scale the edge functions to barycentric coordinates, flipping the
+    // edges of clockwise triangles.
+    auto area = glm::dot(
+        edge_function(screen[0], screen[1]),
+        glm::vec3{screen[2], 1.0F});
+    if (area == 0.0F || !std::isfinite(area)) {
+        return;
+    }
+    triangle.edges = {
+        edge_function(screen[1], screen[2]) / area,
+        edge_function(screen[2], screen[0]) / area,
+        edge_function(screen[0], screen[1]) / area};
+    triangle.depth = triangle.edges[0] * depth.x + triangle.edges[1] * depth.y +
+                     triangle.edges[2] * depth.z;
+
+    auto low = glm::min(glm::min(screen[0], screen[1]), screen[2]);
+    auto high = glm::max(glm::max(screen[0], screen[1]), screen[2]);
+    low = glm::max(glm::floor(low), glm::vec2{0.0F});
+    high = glm::min(glm::ceil(high), glm::vec2{size - 1});
+    if (low.x > high.x || low.y > high.y) {
+        return;
+    }
+    triangle.bounds = glm::ivec4{low, high};
+    triangle.mesh = mesh;
+    triangle.face = face;
+
+    auto index = static_cast<uint32_t>(chunk.triangles.size());
+    chunk.triangles.emplace_back(triangle);
+    auto first_tile = glm::ivec2{low} / _tile_size;
+    auto last_tile = glm::ivec2{high} / _tile_size;
+    for (auto ty = first_tile.y; ty <= last_tile.y; ty++) {
+        for (auto tx = first_tile.x; tx <= last_tile.x; tx++) {
+            chunk.bins[static_cast<size_t>(ty * _tiles.x + tx)].emplace_back(
+                index);
+        }
+    }
+}
+
+void Rasterizer::rasterize_tile(int tile, glm::ivec2 size, bool vectorize) {
+    auto origin = glm::ivec2{tile % _tiles.x, tile / _tiles.x} * _tile_size;
+    auto end = glm::min(origin + _tile_size, size) - 1;
+    for (auto y = origin.y; y <= end.y; y++) {
+        auto row = static_cast<size_t>(y * size.x);
+        std::fill_n(&_depth[row + origin.x], end.x - origin.x + 1, 1.0F);
+        std::fill_n(&_ids[row + origin.x], end.x - origin.x + 1, no_triangle);
+    }
+
+    for (auto c = size_t{0}; c < _chunks.size(); c++) {
+        const auto& chunk = _chunks[c];
+        for (auto t : chunk.bins[static_cast<size_t>(tile)]) {
+            const auto& triangle = chunk.triangles[t];
+            const auto& bounds = triangle.bounds;
+            auto rect = glm::ivec4{
+                glm::max(glm::ivec2{bounds.x, bounds.y}, origin),
+                glm::min(glm::ivec2{bounds.z, bounds.w}, end)};
+            auto id = static_cast<uint32_t>(c << triangle_bits) | t;
+#ifdef RASTERIZER_AVX2
+            if (vectorize) {
+                rasterize_avx2(
+                    triangle.edges,
+                    triangle.depth,
+                    rect,
+                    id,
+                    size.x,
+                    _depth.data(),
+                    _ids.data());
+                continue;
+            }
+#endif
+            rasterize_scalar(
+                triangle.edges,
+                triangle.depth,
+                rect,
+                id,
+                size.x,
+                _depth.data(),
+                _ids.data());
+        }
+    }
+}
+
+void Rasterizer::resolve_row(
+    const HostScene& scene,
+    const glm::mat4& view,
+    int y,
+    glm::ivec2 size) {
+    auto view_rotation = glm::mat3{view};
+    auto py = static_cast<float>(y) + 0.5F;
+    for (auto x = 0; x < size.x; x++) {
+        auto index = static_cast<size_t>(y * size.x + x);
+        auto id = _ids[index];
+        if (id == no_triangle) {
+            _frame.gbuffer.depth[index] = 1.0F;
+            _frame.gbuffer.normals[index] = glm::vec3{0.0F, 0.0F, 1.0F};
+            _frame.diffuse_spec[index] = glm::vec4{0.0F};
+            continue;
+        }
+        const auto& chunk = _chunks[id >> triangle_bits];
+        const auto& triangle =
+            chunk.triangles[id & ((1U << triangle_bits) - 1)];
+        const auto& mesh = scene.meshes[triangle.mesh];
+        const auto& face = mesh.faces[triangle.face];
+
+        // Find the perspective-correct weights of the source vertices.
+        auto px = static_cast<float>(x) + 0.5F;
+        auto weights = glm::vec3{
+            evaluate(triangle.edges[0], px, py),
+            evaluate(triangle.edges[1], px, py),
+            evaluate(triangle.edges[2], px, py)};
+        weights *= triangle.inverse_w;
+        weights /= weights.x + weights.y + weights.z;
+        auto b = triangle.barycentric[0] * weights.x +
+                 triangle.barycentric[1] * weights.y +
+                 triangle.barycentric[2] * weights.z;
+        const auto& v0 = mesh.vertices[face.x];
+        const auto& v1 = mesh.vertices[face.y];
+        const auto& v2 = mesh.vertices[face.z];
+        auto tex_coords =
+            v0.tex_coord * b.x + v1.tex_coord * b.y + v2.tex_coord * b.z;
+
+        // Perturb the normal by the normal map in view space, as the
+        // geometry pass does.
+        auto n = glm::normalize(
+            v0.normal * b.x + v1.normal * b.y + v2.normal * b.z);
+        auto t = glm::normalize(
+            v0.tex_tangent * b.x + v1.tex_tangent * b.y + v2.tex_tangent * b.z);
+        t = glm::normalize(t - glm::dot(t, n) * n);
+        auto tbn = view_rotation * glm::mat3{t, glm::cross(n, t), n};
+        auto bump = glm::vec3{0.0F, 0.0F, 1.0F};
+        if (mesh.normal) {
+            bump = glm::vec3{
+                       scene.textures[*mesh.normal].sample(tex_coords)} *
+                       2.0F -
+                   1.0F;
+        }
+        auto normal = glm::normalize(tbn * bump);
+        if (!std::isfinite(normal.x + normal.y + normal.z)) {
+            normal = glm::normalize(view_rotation * n);
+        }
+
+        auto diffuse_spec = glm::vec4{0.0F};
+        if (mesh.diffuse) {
+            diffuse_spec = scene.textures[*mesh.diffuse].sample(tex_coords);
+        }
+        diffuse_spec.a = 0.0F;
+        if (mesh.specular) {
+            diffuse_spec.a =
+                scene.textures[*mesh.specular].sample(tex_coords).r;
+        }
+
+        _frame.gbuffer.depth[index] = evaluate(triangle.depth, px, py);
+        _frame.gbuffer.normals[index] = normal;
+        _frame.diffuse_spec[index] = diffuse_spec;
+    }
+}
+
+std::vector<glm::u8vec4> cpu_lighting(
+    const SoftwareFrame& frame,
+    std::span<const float> occlusion,
+    float intensity,
+    float power,
+    ThreadPool& pool) {
+    auto width = static_cast<size_t>(frame.gbuffer.width);
+    auto pixels = std::vector<glm::u8vec4>(frame.diffuse_spec.size());
+    pool.run(static_cast<size_t>(frame.gbuffer.height), [&](size_t y) {
+        for (auto i = y * width; i < (y + 1) * width; i++) {
+            auto ambient = glm::clamp(
+                1.0F - intensity * (1.0F - occlusion[i]),
+                0.0F,
+                1.0F);
+            ambient = std::pow(ambient, power);
+            auto color = glm::vec3{frame.diffuse_spec[i]} * ambient;
+            pixels[i] = glm::u8vec4{
+                glm::round(glm::clamp(color, 0.0F, 1.0F) * 255.0F),
+                255};
+        }
+    });
+    return pixels;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "cpu_ssao.hpp"
+#include "host_scene.hpp"
+#include "thread_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A SoftwareFrame is the g-buffer filled by the software rasterizer, with
+// the same contents as the one of the geometry pass.
+struct SoftwareFrame {
+    CpuGBuffer gbuffer; // depth and view-space normals
+    std::vector<glm::vec4> diffuse_spec; // diffuse color and specular
+};
+
+// A Rasterizer renders host scenes into a SoftwareFrame on the cpu. Clipped
+// triangles are binned into screen tiles, and the tiles are rasterized in
+// parallel into a visibility buffer of depth and triangle ids, 8 pixels at a
+// time with avx2. A resolve step then fills the g-buffer once per visible
+// pixel, as the visibility buffer pipeline does on the gpu.
+class Rasterizer {
+  public:
+    // Create a rasterizer with square tiles of some width in pixels.
+    explicit Rasterizer(int tile_size = 64);
+
+    // Render a scene seen through a view and projection into a frame of
+    // some size. Triangles are not culled by facing, as in the geometry
+    // pass.
+    void render(
+        const HostScene&,
+        const glm::mat4& view,
+        const glm::mat4& projection,
+        glm::ivec2 size,
+        ThreadPool&,
+        bool vectorize = true);
+
+    // Get the last rendered frame.
+    [[nodiscard]] const SoftwareFrame& frame() const;
+
+  private:
+    // A ClipVertex is a vertex of a clipped triangle, with its barycentric
+    // coordinates in the source triangle.
+    struct ClipVertex {
+        glm::vec4 position; // clip-space position
+        glm::vec3 barycentric; // weights of the source triangle's vertices
+    };
+
+    // A Triangle is a clipped triangle set up for rasterization.
+    struct Triangle {
+        std::array<glm::vec3, 3> edges; // pixel-space edge functions
+        glm::vec3 depth; // plane of window-space depth in pixel space
+        glm::vec3 inverse_w; // 1 / w of each vertex
+        std::array<glm::vec3, 3> barycentric; // of each vertex in the source
+        glm::ivec4 bounds; // pixel bounding box (min x, min y, max x, max y)
+        uint32_t mesh; // index of the source mesh
+        uint32_t face; // index of the source face in its mesh
+    };
+
+    // A Chunk is a range of source faces set up by one task, and its
+    // triangles sorted into tiles.
+    struct Chunk {
+        std::vector<Triangle> triangles;
+        std::vector<std::vector<uint32_t>> bins; // triangles of each tile
+    };
+
+    int _tile_size;
+    glm::ivec2 _tiles{}; // number of tiles along each axis
+    std::vector<size_t> _first_faces; // index of each mesh's first face
+    std::vector<Chunk> _chunks;
+    std::vector<float> _depth; // visibility buffer depth
+    std::vector<uint32_t> _ids; // chunk and triangle of each pixel
+    SoftwareFrame _frame;
+
+    // Clip, set up, and bin a range of the faces of a scene, counted from
+    // the first face of the first mesh.
+    void setup(
+        Chunk&,
+        const HostScene&,
+        const glm::mat4& view_projection,
+        glm::ivec2 size,
+        size_t first,
+        size_t last);
+
+    // Set up a clipped triangle and bin it.
+    void add_triangle(
+        Chunk&,
+        const std::array<ClipVertex, 3>&,
+        glm::ivec2 size,
+        uint32_t mesh,
+        uint32_t face);
+
+    // Rasterize the triangles binned into one tile.
+    void rasterize_tile(int tile, glm::ivec2 size, bool vectorize);
+
+    // Fill the g-buffer of a row from the visibility buffer.
+    void resolve_row(
+        const HostScene&,
+        const glm::mat4& view,
+        int y,
+        glm::ivec2 size);
+};
+
+// Shade a software frame with ambient light and occlusion, as the lighting
+// pass does without lights, and get its rgba8 pixels.
+std::vector<glm::u8vec4> cpu_lighting(
+    const SoftwareFrame&,
+    std::span<const float> occlusion,
+    float intensity,
+    float power,
+    ThreadPool&);
@@ -0,0 +1,348 @@
+#include "render_graph.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto unused = std::numeric_limits<size_t>::max();
+
+// Check if a sized internal format holds depth.
+bool is_depth(GLenum format) {
+    switch (format) {
+    case GL_DEPTH_COMPONENT16:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32:
+    case GL_DEPTH_COMPONENT32F:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Get the number of bytes the driver allocated for a texture.
+size_t texture_bytes(GLuint tex, const TextureDesc& desc) {
+    constexpr auto components = std::array<GLenum, 6>{
+        GL_TEXTURE_RED_SIZE,
+        GL_TEXTURE_GREEN_SIZE,
+        GL_TEXTURE_BLUE_SIZE,
+        GL_TEXTURE_ALPHA_SIZE,
+        GL_TEXTURE_DEPTH_SIZE,
+        GL_TEXTURE_STENCIL_SIZE};
+    auto bits = size_t{0};
+    for (auto component : components) {
+        auto size = GLint{};
+        glGetTextureLevelParameteriv(tex, 0, component, &size);
+        bits += static_cast<size_t>(size);
+    }
+    return bits / 8 * static_cast<size_t>(desc.width) *
+           static_cast<size_t>(desc.height);
+}
+} // namespace
+
+RenderGraph::~RenderGraph() {
+    clear_pool();
+    for (auto& timers : _timer_sets) {
+        glDeleteQueries(1, &timers.start);
+    }
+}
+
+RenderGraph::Handle
+RenderGraph::create(std::string name, const TextureDesc& desc) {
+    _resources.emplace_back(Resource{std::move(name), desc, 0, false});
+    return _resources.size() - 1;
+}
+
+RenderGraph::Handle
+RenderGraph::import(std::string name, GLuint id, const TextureDesc& desc) {
+    _resources.emplace_back(Resource{std::move(name), desc, id, true});
+    return _resources.size() - 1;
+}
+
+void RenderGraph::add_pass(Pass pass) {
+    _passes.emplace_back(std::move(pass));
+}
+
+void RenderGraph::set_viewport_scale(float x, float y) {
+    _viewport_scale_x = x;
+    _viewport_scale_y = y;
+}
+
+void RenderGraph::set_output(GLuint framebuffer) {
+    _output = framebuffer;
+}
+
+void RenderGraph::clear_pool() {
+    for (auto& [attachments, fbo] : _framebuffers) {
+        glDeleteFramebuffers(1, &fbo);
+    }
+    for (auto& physical : _pool) {
+        glDeleteTextures(1, &physical.id);
+    }
+    _framebuffers.clear();
+    _pool.clear();
+}
+
+void RenderGraph::forget(GLuint id) {
+    std::erase_if(_framebuffers, [id](const auto& entry) {
+        const auto& [attachments, fbo] = entry;
+        if (std::find(attachments.begin(), attachments.end(), id) ==
+            attachments.end()) {
+            return false;
+        }
+        glDeleteFramebuffers(1, &fbo);
+        return true;
+    });
+}
+
+void RenderGraph::execute() {
+    // Walk backwards from passes with side effects to find the live passes.
+    auto live = std::vector<bool>(_passes.size(), false);
+    auto needed = std::vector<bool>(_resources.size(), false);
+    for (auto i = _passes.size(); i-- > 0;) {
+        const auto& pass = _passes[i];
+        live[i] = pass.present || pass.writes.empty() ||
+                  std::any_of(
+                      pass.writes.begin(),
+                      pass.writes.end(),
+                      [this, &needed](Handle h) {
+                          return needed[h] || _resources[h].imported;
+                      });
+        if (live[i]) {
+            for (auto h : pass.reads) {
+                needed[h] = true;
+            }
+        }
+    }
+
+    // Find the lifetime of every transient as the live passes using it.
+    auto first_use = std::vector<size_t>(_resources.size(), unused);
+    auto last_use = std::vector<size_t>(_resources.size(), unused);
+    for (auto i = size_t{0}; i < _passes.size(); i++) {
+        if (!live[i]) {
+            continue;
+        }
+        auto mark = [&](Handle h) {
+            first_use[h] = std::min(first_use[h], i);
+            last_use[h] = last_use[h] == unused ? i : std::max(last_use[h], i);
+        };
+        std::for_each(_passes[i].reads.begin(), _passes[i].reads.end(), mark);
+        std::for_each(_passes[i].writes.begin(), _passes[i].writes.end(), mark);
+    }
+
+    auto stats = Stats{};
+    auto live_bytes = size_t{0};
+    auto backing = std::vector<size_t>(_resources.size(), unused);
+    auto writer = std::vector<std::pair<GLuint, GLenum>>(_resources.size());
+    auto& profiler = Profiler::instance();
+    auto* timers = static_cast<TimerSet*>(nullptr);
+    if (_timing) {
+        timers = &_timer_sets[_timed_frames++ % _timer_sets.size()];
+        read_timers(*timers);
+        if (timers->start == 0) {
+            glCreateQueries(GL_TIMESTAMP, 1, &timers->start);
+        }
+        glQueryCounter(timers->start, GL_TIMESTAMP);
+        timers->passes.clear();
+        timers->pending = true;
+    }
+    for (auto i = size_t{0}; i < _passes.size(); i++) {
+        if (!live[i]) {
+            stats.culled++;
+            continue;
+        }
+        stats.passes++;
+        const auto& pass = _passes[i];
+
+        // Back transients that start their lifetime here with pool textures.
+        for (auto h = Handle{0}; h < _resources.size(); h++) {
+            if (first_use[h] != i || _resources[h].imported) {
+                continue;
+            }
+            backing[h] = acquire(_resources[h].desc);
+            auto& physical = _pool[backing[h]];
+            physical.busy = true;
+            _resources[h].id = physical.id;
+            live_bytes += physical.bytes;
+            stats.textures++;
+        }
+        stats.peak_bytes = std::max(stats.peak_bytes, live_bytes);
+
+        if (pass.present) {
+            glBindFramebuffer(GL_FRAMEBUFFER, _output);
+        } else if (!pass.writes.empty()) {
+            auto fbo = framebuffer(pass.writes);
+            auto color = GLenum{GL_COLOR_ATTACHMENT0};
+            for (auto h : pass.writes) {
+                auto depth = is_depth(_resources[h].desc.format);
+                writer[h] = {fbo, depth ? GL_DEPTH_ATTACHMENT : color++};
+            }
+            const auto& desc = _resources[pass.writes.front()].desc;
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glViewport(
+                0,
+                0,
+                static_cast<GLsizei>(std::ceil(desc.width * _viewport_scale_x)),
+                static_cast<GLsizei>(
+                    std::ceil(desc.height * _viewport_scale_y)));
+        }
+
+        auto scope = ProfileScope{
+            profiler.enabled() ? profiler.intern(pass.name) : "pass"};
+        if (timers != nullptr) {
+            auto timer = timers->passes.size();
+            if (timer == timers->timers.size()) {
+                timers->timers.emplace_back();
+            }
+            timers->timers[timer].begin();
+            pass.execute(*this);
+            timers->timers[timer].end();
+            timers->passes.emplace_back(profiler.intern(pass.name));
+        } else {
+            pass.execute(*this);
+        }
+
+        // Discard and recycle transients that end their lifetime here.
+        for (auto h = Handle{0}; h < _resources.size(); h++) {
+            if (last_use[h] != i || backing[h] == unused) {
+                continue;
+            }
+            auto [fbo, attachment] = writer[h];
+            if (fbo != 0) {
+                glInvalidateNamedFramebufferData(fbo, 1, &attachment);
+            }
+            _pool[backing[h]].busy = false;
+            live_bytes -= _pool[backing[h]].bytes;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, _output);
+
+    for (const auto& physical : _pool) {
+        stats.allocated_bytes += physical.bytes;
+    }
+    std::sort(backing.begin(), backing.end());
+    backing.erase(std::unique(backing.begin(), backing.end()), backing.end());
+    stats.physical = static_cast<size_t>(
+        std::count_if(backing.begin(), backing.end(), [](size_t idx) {
+            return idx != unused;
+        }));
+    _stats = stats;
+
+    _resources.clear();
+    _passes.clear();
+}
+
+GLuint RenderGraph::texture(Handle handle) const {
+    return _resources[handle].id;
+}
+
+const RenderGraph::Stats& RenderGraph::stats() const {
+    return _stats;
+}
+
+void RenderGraph::set_timing(bool timing) {
+    _timing = timing;
+}
+
+std::vector<std::pair<std::string, double>> RenderGraph::timings() const {
+    auto timings = std::vector<std::pair<std::string, double>>{};
+    if (!_timing || _timed_frames == 0) {
+        return timings;
+    }
+    const auto& timers =
+        _timer_sets[(_timed_frames - 1) % _timer_sets.size()];
+    for (auto i = size_t{0}; i < timers.passes.size(); i++) {
+        timings.emplace_back(timers.passes[i], timers.timers[i].elapsed_ms());
+    }
+    return timings;
+}
+
+size_t RenderGraph::skipped_timer_sets() const {
+    return _skipped_timer_sets;
+}
+
+void RenderGraph::read_timers(TimerSet& timers) {
+    // Timers still in flight are skipped rather than waited for. The gpu
+    // runs the passes in order, so the last one finishes last.
+    if (!timers.pending) {
+        return;
+    }
+    timers.pending = false;
+    auto& profiler = Profiler::instance();
+    if (!profiler.enabled() || timers.passes.empty()) {
+        return;
+    }
+    if (!timers.timers[timers.passes.size() - 1].ready()) {
+        _skipped_timer_sets++;
+        return;
+    }
+
+    // Map gpu timestamps to the timeline with an offset measured once.
+    if (!_gpu_offset_ns) {
+        auto gpu_ns = GLint64{};
+        glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+        _gpu_offset_ns = profiler.now_ns() - gpu_ns;
+    }
+    auto start = GLuint64{};
+    glGetQueryObjectui64v(timers.start, GL_QUERY_RESULT, &start);
+    auto begin_ns = static_cast<int64_t>(start) + *_gpu_offset_ns;
+    for (auto i = size_t{0}; i < timers.passes.size(); i++) {
+        auto end_ns = begin_ns + static_cast<int64_t>(
+                                     timers.timers[i].elapsed_ms() * 1.0e6);
+        profiler.record({timers.passes[i], begin_ns, end_ns, true});
+        begin_ns = end_ns;
+    }
+}
+
+size_t RenderGraph::acquire(const TextureDesc& desc) {
+    for (auto idx = size_t{0}; idx < _pool.size(); idx++) {
+        if (!_pool[idx].busy && _pool[idx].desc == desc) {
+            return idx;
+        }
+    }
+
+    auto tex = GLuint{};
+    glCreateTextures(GL_TEXTURE_2D, 1, &tex);
+    glTextureParameteri(tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(tex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(tex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureStorage2D(tex, 1, desc.format, desc.width, desc.height);
+    _pool.emplace_back(Physical{tex, desc, texture_bytes(tex, desc), false});
+    return _pool.size() - 1;
+}
+
+GLuint RenderGraph::framebuffer(const std::vector<Handle>& writes) {
+    auto attachments = std::vector<GLuint>{};
+    for (auto h : writes) {
+        attachments.emplace_back(_resources[h].id);
+    }
+    if (auto it = _framebuffers.find(attachments); it != _framebuffers.end()) {
+        return it->second;
+    }
+
+    auto fbo = GLuint{};
+    glCreateFramebuffers(1, &fbo);
+    auto buffers = std::vector<GLenum>{};
+    for (auto h : writes) {
+        const auto& resource = _resources[h];
+        if (is_depth(resource.desc.format)) {
+            glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, resource.id, 0);
+        } else {
+            auto attachment =
+                static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + buffers.size());
+            glNamedFramebufferTexture(fbo, attachment, resource.id, 0);
+            buffers.emplace_back(attachment);
+        }
+    }
+    glNamedFramebufferDrawBuffers(
+        fbo,
+        static_cast<GLsizei>(buffers.size()),
+        buffers.data());
+    _framebuffers.emplace(std::move(attachments), fbo);
+    return fbo;
+}
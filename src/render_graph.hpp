@@ -0,0 +1,165 @@
+#pragma once
+
+#include "frame_pacer.hpp"
+#include "gpu_timer.hpp"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A TextureDesc describes the storage of a render target.
+struct TextureDesc {
+    GLenum format; // sized internal format
+    GLsizei width;
+    GLsizei height;
+
+    bool operator==(const TextureDesc&) const = default;
+};
+
+// A RenderGraph schedules the passes of a frame from the textures that each
+// pass reads and writes. Passes whose outputs are never read are culled, and
+// transient textures with disjoint lifetimes share the same storage.
+class RenderGraph {
+  public:
+    // A Handle refers to a texture declared in the current frame.
+    using Handle = size_t;
+
+    // A Pass is a unit of work in the graph. Passes without texture writes
+    // (e.g. compute passes that write buffers) are never culled.
+    struct Pass {
+        std::string name;
+        std::vector<Handle> reads; // textures sampled by the pass
+        std::vector<Handle> writes; // color attachments in order, or depth
+        std::function<void(const RenderGraph&)> execute;
+        bool present = false; // renders to the output framebuffer
+    };
+
+    // Statistics of the last executed frame.
+    struct Stats {
+        size_t passes; // number of executed passes
+        size_t culled; // number of culled passes
+        size_t textures; // transient textures used by executed passes
+        size_t physical; // physical textures backing those transients
+        size_t peak_bytes; // largest size of simultaneously live transients
+        size_t allocated_bytes; // size of every physical texture in the pool
+
+        bool operator==(const Stats&) const = default;
+    };
+
+    RenderGraph() = default;
+
+    // Disallow copies and moves.
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph(RenderGraph&&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+    RenderGraph& operator=(RenderGraph&&) = delete;
+    ~RenderGraph();
+
+    // Declare a transient texture for the current frame.
+    Handle create(std::string, const TextureDesc&);
+
+    // Declare a texture owned outside of the graph. Passes that write to it
+    // are never culled.
+    Handle import(std::string, GLuint, const TextureDesc&);
+
+    // Add a pass to the current frame.
+    void add_pass(Pass);
+
+    // Set the fraction of each attachment that raster passes render into,
+    // starting from the bottom-left corner.
+    void set_viewport_scale(float, float);
+
+    // Set the framebuffer that present passes render into (0 for the
+    // window).
+    void set_output(GLuint framebuffer);
+
+    // Delete all pooled textures and framebuffers (e.g. after the render
+    // target sizes change).
+    void clear_pool();
+
+    // Delete the cached framebuffers that an imported texture is attached
+    // to. Call it before deleting the texture, whose name may be reused.
+    void forget(GLuint);
+
+    // Cull, allocate, and run the passes of the current frame, then start a
+    // new frame.
+    void execute();
+
+    // Get the opengl id of a texture while a pass is executing.
+    [[nodiscard]] GLuint texture(Handle) const;
+
+    // Get the statistics of the last executed frame.
+    [[nodiscard]] const Stats& stats() const;
+
+    // Time every executed pass on the gpu. There is a set of timers per
+    // frame in flight and one more: each frame reads the results of the
+    // oldest set if they are ready, and hands them to the profiler when it
+    // is recording, so that reading them never stalls.
+    void set_timing(bool);
+
+    // Get the name and gpu time in milliseconds of every pass executed in
+    // the last frame, waiting for the results. Empty unless timing is set.
+    [[nodiscard]] std::vector<std::pair<std::string, double>> timings() const;
+
+    // Get the number of timer sets reused before their results were ready,
+    // whose passes are missing from the profiler.
+    [[nodiscard]] size_t skipped_timer_sets() const;
+
+  private:
+    // A Resource is a texture declared in the current frame.
+    struct Resource {
+        std::string name;
+        TextureDesc desc;
+        GLuint id; // backing texture (0 until allocated)
+        bool imported;
+    };
+
+    // A Physical is a texture in the pool that backs transient resources.
+    struct Physical {
+        GLuint id;
+        TextureDesc desc;
+        size_t bytes;
+        bool busy; // backs a live resource
+    };
+
+    std::vector<Resource> _resources; // resources of the current frame
+    std::vector<Pass> _passes; // passes of the current frame
+    std::vector<Physical> _pool; // textures kept across frames
+    std::map<std::vector<GLuint>, GLuint> _framebuffers; // by attachments
+    Stats _stats{};
+    float _viewport_scale_x = 1.0F;
+    float _viewport_scale_y = 1.0F;
+    GLuint _output = 0; // framebuffer of present passes
+    // A TimerSet holds the pass timers of one frame.
+    struct TimerSet {
+        std::vector<GpuTimer> timers; // one time elapsed query per pass
+        std::vector<const char*> passes; // interned names of timed passes
+        GLuint start = 0; // timestamp query at the start of the frame
+        bool pending = false; // results not read yet
+    };
+
+    bool _timing = false; // time passes on the gpu
+    // One set per frame in flight, and one for the frame being recorded.
+    std::array<TimerSet, max_frames_in_flight + 1> _timer_sets;
+    size_t _timed_frames = 0; // frames executed with timing
+    size_t _skipped_timer_sets = 0; // sets reused before their results came
+    std::optional<int64_t> _gpu_offset_ns; // profiler time minus gpu time
+
+    // Get the index of an idle pool texture matching a description, creating
+    // it if needed.
+    size_t acquire(const TextureDesc&);
+
+    // Get a framebuffer with the given textures attached.
+    GLuint framebuffer(const std::vector<Handle>&);
+
+    // Hand the pass times of a set to the profiler if they are ready, laid
+    // out back to back from the start of its frame.
+    void read_timers(TimerSet&);
+};
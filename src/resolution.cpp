@@ -0,0 +1,39 @@
+#include "resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto min_scale = 0.5F;
+constexpr auto max_scale = 1.0F;
+constexpr auto max_step = 0.05F; // largest scale change per frame
+constexpr auto smoothing = 0.1; // weight of the newest frame time
+constexpr auto deadband = 0.05; // relative error that is left alone
+} // namespace
+
+float ResolutionController::update(double gpu_ms, double target_ms) {
+    _filtered_ms = _filtered_ms == 0.0
+                       ? gpu_ms
+                       : std::lerp(_filtered_ms, gpu_ms, smoothing);
+    auto ratio = target_ms / _filtered_ms;
+    if (std::abs(ratio - 1.0) < deadband) {
+        return _scale;
+    }
+
+    // Gpu cost is roughly proportional to the pixel count, so the scale of
+    // each dimension goes with the square root of the time ratio.
+    auto desired = _scale * static_cast<float>(std::sqrt(ratio));
+    desired = std::clamp(desired, _scale - max_step, _scale + max_step);
+    _scale = std::clamp(desired, min_scale, max_scale);
+    return _scale;
+}
+
+float ResolutionController::scale() const {
+    return _scale;
+}
+
+void ResolutionController::reset() {
+    _scale = max_scale;
+    _filtered_ms = 0.0;
+}
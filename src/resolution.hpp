@@ -0,0 +1,20 @@
+#pragma once
+
+// A ResolutionController picks the fraction of the window resolution to
+// render at so that the gpu frame time stays close to a target.
+class ResolutionController {
+  public:
+    // Feed the gpu time of a finished frame and the target frame time (both
+    // in milliseconds), and get the new scale.
+    float update(double gpu_ms, double target_ms);
+
+    // Get the current scale of each render dimension.
+    [[nodiscard]] float scale() const;
+
+    // Go back to full resolution.
+    void reset();
+
+  private:
+    float _scale = 1.0F; // fraction of the window width and height
+    double _filtered_ms = 0.0; // smoothed gpu frame time
+};
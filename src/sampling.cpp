@@ -0,0 +1,294 @@
+#include "sampling.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace {
+constexpr auto candidates = 16; // best-candidate tries per existing point
+constexpr auto initial_fraction = 0.1F; // share of void-and-cluster seeds
+constexpr auto energy_sigma = 1.5F; // void-and-cluster gaussian filter width
+
+// Get a kernel offset from a point in the unit cube. The first two
+// coordinates pick a cosine-weighted direction, and the third its length
+// parameter.
+glm::vec4 hemisphere_offset(float u, float v, float w) {
+    auto r = std::sqrt(u);
+    auto phi = glm::two_pi<float>() * v;
+    auto direction = glm::vec3{
+        r * std::cos(phi),
+        r * std::sin(phi),
+        std::sqrt(std::max(1.0F - u, 0.0F))};
+    return {direction, w};
+}
+
+// Get a unit disk point as the (u, v) of hemisphere_offset.
+glm::vec2 disk_to_square(glm::vec2 p) {
+    auto phi = std::atan2(p.y, p.x) / glm::two_pi<float>();
+    return {glm::dot(p, p), phi < 0.0F ? phi + 1.0F : phi};
+}
+
+// Pick points in the unit disk that are spread apart, by keeping the best
+// of several random candidates for every new point.
+std::vector<glm::vec2> poisson_disk(int size, std::mt19937& generator) {
+    auto signed_unit = std::uniform_real_distribution<float>{-1.0F, 1.0F};
+    auto random_point = [&] {
+        auto p = glm::vec2{};
+        do {
+            p = glm::vec2{signed_unit(generator), signed_unit(generator)};
+        } while (glm::dot(p, p) > 1.0F);
+        return p;
+    };
+
+    auto points = std::vector<glm::vec2>{};
+    while (static_cast<int>(points.size()) < size) {
+        auto best = random_point();
+        auto best_distance = 0.0F;
+        auto tries = candidates * static_cast<int>(points.size()) + 1;
+        for (auto i = 0; i < tries && !points.empty(); i++) {
+            auto candidate = random_point();
+            auto distance = std::numeric_limits<float>::max();
+            for (auto p : points) {
+                distance = std::min(distance, glm::distance(candidate, p));
+            }
+            if (distance > best_distance) {
+                best = candidate;
+                best_distance = distance;
+            }
+        }
+        points.emplace_back(best);
+    }
+    return points;
+}
+
+// A toroidal gaussian energy field over a binary pattern, updated as points
+// are added and removed.
+class Energy {
+  public:
+    explicit Energy(int size)
+        : _size{size}, _field(static_cast<size_t>(size * size), 0.0F),
+          _filter(static_cast<size_t>(size * size)) {
+        for (auto y = 0; y < size; y++) {
+            for (auto x = 0; x < size; x++) {
+                auto dx = static_cast<float>(std::min(x, size - x));
+                auto dy = static_cast<float>(std::min(y, size - y));
+                auto variance = energy_sigma * energy_sigma;
+                _filter[index(x, y)] =
+                    std::exp(-(dx * dx + dy * dy) / (2.0F * variance));
+            }
+        }
+    }
+
+    // Add the filter centered on a pixel, scaled by a sign.
+    void splat(size_t pixel, float sign) {
+        auto px = static_cast<int>(pixel) % _size;
+        auto py = static_cast<int>(pixel) / _size;
+        for (auto y = 0; y < _size; y++) {
+            for (auto x = 0; x < _size; x++) {
+                auto fx = (x - px + _size) % _size;
+                auto fy = (y - py + _size) % _size;
+                _field[index(x, y)] += sign * _filter[index(fx, fy)];
+            }
+        }
+    }
+
+    // Get the pixel with the highest energy among pixels set to a value
+    // (the tightest cluster), or the lowest (the largest void).
+    size_t find(const std::vector<bool>& pattern, bool value, bool highest)
+        const {
+        auto best = size_t{0};
+        auto best_energy = highest ? -std::numeric_limits<float>::max()
+                                   : std::numeric_limits<float>::max();
+        for (auto i = size_t{0}; i < pattern.size(); i++) {
+            if (pattern[i] != value) {
+                continue;
+            }
+            if (highest ? _field[i] > best_energy : _field[i] < best_energy) {
+                best = i;
+                best_energy = _field[i];
+            }
+        }
+        return best;
+    }
+
+  private:
+    int _size;
+    std::vector<float> _field;
+    std::vector<float> _filter; // gaussian of the toroidal distance
+
+    [[nodiscard]] size_t index(int x, int y) const {
+        return static_cast<size_t>(y * _size + x);
+    }
+};
+} // namespace
+
+float radical_inverse(unsigned index, unsigned base) {
+    auto inverse = 0.0F;
+    auto digit = 1.0F / static_cast<float>(base);
+    for (; index > 0; index /= base) {
+        inverse += static_cast<float>(index % base) * digit;
+        digit /= static_cast<float>(base);
+    }
+    return inverse;
+}
+
+float kernel_length(float parameter) {
+    return glm::mix(min_kernel_length, 1.0F, parameter * parameter);
+}
+
+std::vector<glm::vec4>
+generate_kernel(KernelPattern pattern, int size, unsigned seed) {
+    auto generator = std::mt19937{seed};
+    auto unit = std::uniform_real_distribution<float>{0.0F, 1.0F};
+    auto count = static_cast<unsigned>(size);
+    auto kernel = std::vector<glm::vec4>{};
+    kernel.reserve(count);
+    switch (pattern) {
+    case KernelPattern::Classic:
+        // Random directions in the unit cube, normalized, with random lengths
+        // that the length parameter scales up with the index.
+        for (auto i = 0U; i < count; i++) {
+            auto x = unit(generator) * 2.0F - 1.0F;
+            auto y = unit(generator) * 2.0F - 1.0F;
+            auto z = unit(generator);
+            auto direction = glm::normalize(glm::vec3{x, y, z});
+            kernel.emplace_back(
+                direction * unit(generator),
+                static_cast<float>(i) / static_cast<float>(count));
+        }
+        break;
+    case KernelPattern::Random:
+        // Independent points, mapped like the other patterns so that every
+        // pattern converges to the same occlusion.
+        for (auto i = 0U; i < count; i++) {
+            auto u = unit(generator);
+            auto v = unit(generator);
+            kernel.emplace_back(hemisphere_offset(u, v, unit(generator)));
+        }
+        break;
+    case KernelPattern::Hammersley:
+        // The rotations only turn the kernel about the normal, so every pixel
+        // shares its elevations and lengths. Those take the two best
+        // stratified dimensions, and the azimuth takes the third.
+        for (auto i = 0U; i < count; i++) {
+            kernel.emplace_back(hemisphere_offset(
+                (static_cast<float>(i) + 0.5F) / static_cast<float>(count),
+                radical_inverse(i, 3),
+                radical_inverse(i, 2)));
+        }
+        break;
+    case KernelPattern::Halton:
+        // The elevations and lengths take the two smallest bases.
+        for (auto i = 1U; i <= count; i++) {
+            kernel.emplace_back(hemisphere_offset(
+                radical_inverse(i, 2),
+                radical_inverse(i, 5),
+                radical_inverse(i, 3)));
+        }
+        break;
+    case KernelPattern::PoissonDisk: {
+        // Stratify the lengths, shuffled so they do not follow the order in
+        // which the disk points were picked.
+        auto lengths = std::vector<unsigned>(count);
+        std::iota(lengths.begin(), lengths.end(), 0U);
+        std::shuffle(lengths.begin(), lengths.end(), generator);
+        auto points = poisson_disk(size, generator);
+        for (auto i = size_t{0}; i < points.size(); i++) {
+            auto uv = disk_to_square(points[i]);
+            kernel.emplace_back(hemisphere_offset(
+                uv.x,
+                uv.y,
+                (static_cast<float>(lengths[i]) + 0.5F) /
+                    static_cast<float>(count)));
+        }
+        break;
+    }
+    }
+    return kernel;
+}
+
+std::vector<int> void_and_cluster(int size, unsigned seed) {
+    auto pixels = static_cast<size_t>(size * size);
+    auto generator = std::mt19937{seed};
+    auto energy = Energy{size};
+
+    // Seed a sparse random pattern, then move its tightest clusters into its
+    // largest voids until it is evenly spread.
+    auto initial = std::max(
+        static_cast<size_t>(initial_fraction * static_cast<float>(pixels)),
+        size_t{1});
+    auto order = std::vector<size_t>(pixels);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::shuffle(order.begin(), order.end(), generator);
+    auto pattern = std::vector<bool>(pixels, false);
+    for (auto i = size_t{0}; i < initial; i++) {
+        pattern[order[i]] = true;
+        energy.splat(order[i], 1.0F);
+    }
+    for (auto moves = size_t{0}; moves < pixels; moves++) {
+        auto cluster = energy.find(pattern, true, true);
+        pattern[cluster] = false;
+        energy.splat(cluster, -1.0F);
+        auto gap = energy.find(pattern, false, false);
+        pattern[gap] = true;
+        energy.splat(gap, 1.0F);
+        if (gap == cluster) {
+            break;
+        }
+    }
+
+    // Rank the seed points by removing tightest clusters, then the remaining
+    // pixels by filling largest voids.
+    auto ranks = std::vector<int>(pixels, 0);
+    auto seeded = pattern;
+    auto seeded_energy = energy;
+    for (auto rank = static_cast<int>(initial); rank-- > 0;) {
+        auto cluster = seeded_energy.find(seeded, true, true);
+        seeded[cluster] = false;
+        seeded_energy.splat(cluster, -1.0F);
+        ranks[cluster] = rank;
+    }
+    for (auto rank = static_cast<int>(initial);
+         rank < static_cast<int>(pixels);
+         rank++) {
+        auto gap = energy.find(pattern, false, false);
+        pattern[gap] = true;
+        energy.splat(gap, 1.0F);
+        ranks[gap] = rank;
+    }
+    return ranks;
+}
+
+std::vector<glm::vec3>
+generate_rotations(NoisePattern pattern, int size, unsigned seed) {
+    auto pixels = static_cast<size_t>(size * size);
+    auto rotations = std::vector<glm::vec3>{};
+    rotations.reserve(pixels);
+    if (pattern == NoisePattern::White) {
+        auto generator = std::mt19937{seed};
+        auto signed_unit = std::uniform_real_distribution<float>{-1.0F, 1.0F};
+        auto unit = std::uniform_real_distribution<float>{0.0F, 1.0F};
+        for (auto i = size_t{0}; i < pixels; i++) {
+            auto x = signed_unit(generator);
+            auto y = signed_unit(generator);
+            rotations.emplace_back(x, y, unit(generator));
+        }
+        return rotations;
+    }
+
+    // The angles and shifts of the ranks form a golden-ratio lattice, so that
+    // every tile covers both evenly.
+    for (auto rank : void_and_cluster(size, seed)) {
+        auto fraction =
+            (static_cast<float>(rank) + 0.5F) / static_cast<float>(pixels);
+        auto angle = glm::two_pi<float>() * fraction;
+        auto shift = glm::fract(
+            static_cast<float>(rank) * glm::golden_ratio<float>());
+        rotations.emplace_back(std::cos(angle), std::sin(angle), shift);
+    }
+    return rotations;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// A KernelPattern is a point set that places the samples of a hemisphere
+// kernel.
+enum class KernelPattern {
+    Classic, // the original kernel: normalized cube points, random lengths
+    Random, // independent uniform random points
+    Hammersley, // radical inverses in bases 2 and 3 of the sample index
+    Halton, // radical inverses in bases 2, 3, and 5
+    PoissonDisk, // best-candidate points with a minimum spacing
+};
+
+// A NoisePattern is an arrangement of the per-pixel kernel rotations.
+enum class NoisePattern {
+    White, // independent random rotations
+    Blue, // evenly spaced angles ordered by void-and-cluster ranks
+};
+
+constexpr auto min_kernel_length = 0.1F; // length of the shortest offsets
+
+// Get the radical inverse of an index in a base: its digits mirrored about
+// the decimal point.
+float radical_inverse(unsigned index, unsigned base);
+
+// Get the length scale of a kernel offset from its length parameter in
+// [0, 1). Lengths cluster towards the center.
+float kernel_length(float parameter);
+
+// Generate a reproducible kernel of offsets in the unit hemisphere around +z.
+// Each offset is xyz scaled by the kernel_length of w, so that the rotations
+// can shift the length parameters per pixel. Directions are cosine-weighted.
+std::vector<glm::vec4> generate_kernel(KernelPattern, int size, unsigned seed);
+
+// Get the void-and-cluster rank of every pixel of a tileable square of blue
+// noise, in row-major order.
+std::vector<int> void_and_cluster(int size, unsigned seed);
+
+// Generate a reproducible tileable square of kernel rotations, as vectors in
+// the xy plane, in row-major order. The z of each is a shift in [0, 1) of the
+// kernel's length parameters.
+std::vector<glm::vec3>
+generate_rotations(NoisePattern, int size, unsigned seed);
@@ -1,7 +1,16 @@
 #include "scene.hpp"
 
+#include <glm/common.hpp>
+
 Scene::Scene(std::vector<Texture> textures, std::vector<Mesh> meshes)
     : _textures{std::move(textures)}, _meshes{std::move(meshes)} {
+    if (!_meshes.empty()) {
+        _bounds = _meshes.front().bounds();
+    }
+    for (const auto& mesh : _meshes) {
+        _bounds.min = glm::min(_bounds.min, mesh.bounds().min);
+        _bounds.max = glm::max(_bounds.max, mesh.bounds().max);
+    }
 }
 
 void Scene::render() {
@@ -9,3 +18,23 @@ void Scene::render() {
         mesh.draw();
     }
 }
+
+const Bounds& Scene::bounds() const {
+    return _bounds;
+}
+
+void Scene::render_visibility(GLint first_triangle_location) {
+    auto first_triangle = GLuint{};
+    for (auto& mesh : _meshes) {
+        glUniform1ui(first_triangle_location, first_triangle);
+        mesh.draw_geometry();
+        first_triangle += static_cast<GLuint>(mesh.triangle_count());
+    }
+}
+
+const VisibilityGeometry& Scene::visibility() {
+    if (!_visibility) {
+        _visibility.emplace(_meshes);
+    }
+    return *_visibility;
+}
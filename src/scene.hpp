@@ -2,7 +2,9 @@
 
 #include "mesh.hpp"
 #include "texture.hpp"
+#include "visibility.hpp"
 
+#include <optional>
 #include <vector>
 
 // A scene is a collection of meshes and textures in those meshes
@@ -14,7 +16,20 @@ class Scene {
     // Render the scene.
     void render();
 
+    // Get the bounding box of every mesh in the scene.
+    const Bounds& bounds() const;
+
+    // Render the scene's geometry only, setting the id of each mesh's first
+    // triangle (less one) through the given uniform location.
+    void render_visibility(GLint first_triangle_location);
+
+    // Get the scene's merged geometry for resolving a visibility buffer,
+    // building it on first use.
+    const VisibilityGeometry& visibility();
+
   private:
     std::vector<Texture> _textures;
     std::vector<Mesh> _meshes;
+    Bounds _bounds{}; // bounding box of every mesh
+    std::optional<VisibilityGeometry> _visibility; // releases before textures
 };
@@ -1,8 +1,12 @@
 #include "shader.hpp"
+#include "startup.hpp"
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <fstream>
+#include <sstream>
+#include <string_view>
 
 // Use the anonymous namespace for private constants/methods
 namespace {
@@ -36,8 +40,12 @@ void assert_status(GLuint id, GLenum type) {
 
 // Read a file as shader source code.
 // https://stackoverflow.com/a/116220
-std::string shader_source(const std::filesystem::path& path) {
+std::string read_source(const std::filesystem::path& path) {
     auto file = std::ifstream(path);
+    if (!file) {
+        fmt::print(stderr, "could not read {}\n", path.string());
+        std::terminate();
+    }
     file.exceptions(std::ios_base::badbit);
 
     auto out = std::string{};
@@ -46,13 +54,63 @@ std::string shader_source(const std::filesystem::path& path) {
         file.read(&buf[0], read_size);
         out.append(buf, 0, file.gcount());
     }
+    StartupReport::instance().add_read(out.size());
+
+    return out;
+}
+
+// Read a file as shader source code, replacing each #include "file" line with
+// the contents of that file (relative to the including file).
+std::string shader_source(const std::filesystem::path& path) {
+    constexpr auto directive = std::string_view{"#include \""};
 
+    auto source = read_source(path);
+    auto out = std::string{};
+    auto line_number = 1;
+    auto stream = std::istringstream{source};
+    for (auto line = std::string{}; std::getline(stream, line); line_number++) {
+        if (line.starts_with(directive)) {
+            auto name = line.substr(
+                directive.size(),
+                line.find('"', directive.size()) - directive.size());
+            out += shader_source(path.parent_path() / name);
+            out += fmt::format("\n#line {}\n", line_number + 1);
+        } else {
+            out += line;
+            out += '\n';
+        }
+    }
     return out;
 }
 
+// Insert preprocessor definitions after the #version directive of a shader
+// source. A #line directive keeps compiler messages pointing at the file.
+std::string inject_defines(std::string source, const ShaderDefines& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    auto version = source.find("#version");
+    auto pos = version == std::string::npos ? 0 : source.find('\n', version);
+    pos = pos == std::string::npos ? source.size() : pos + 1;
+    auto line = std::count(source.begin(), source.begin() + pos, '\n') + 1;
+
+    auto block = std::string{};
+    for (const auto& [name, value] : defines) {
+        block += fmt::format("#define {} {}\n", name, value);
+    }
+    block += fmt::format("#line {}\n", line);
+    source.insert(pos, block);
+    return source;
+}
+
 // Compile a file to an opengl shader.
-GLuint compile_shader(const std::filesystem::path& path, GLenum type) {
-    auto source = shader_source(path);
+GLuint compile_shader(
+    const std::filesystem::path& path,
+    GLenum type,
+    const ShaderDefines& defines) {
+    auto phase = StartupPhase{"compile shader"};
+    auto source = inject_defines(shader_source(path), defines);
     const auto* csource = source.c_str();
 
     auto shader = glCreateShader(type);
@@ -66,21 +124,41 @@ GLuint compile_shader(const std::filesystem::path& path, GLenum type) {
 
 Shader::Shader(
     const std::filesystem::path& vertex_path,
-    const std::filesystem::path& fragment_path)
+    const std::filesystem::path& fragment_path,
+    const ShaderDefines& defines)
     : _id{glCreateProgram()} {
-    auto vertex_shader = compile_shader(vertex_path, GL_VERTEX_SHADER);
-    auto fragment_shader = compile_shader(fragment_path, GL_FRAGMENT_SHADER);
+    auto phase = StartupPhase{"create shader"};
+    auto vertex_shader =
+        compile_shader(vertex_path, GL_VERTEX_SHADER, defines);
+    auto fragment_shader =
+        compile_shader(fragment_path, GL_FRAGMENT_SHADER, defines);
 
     glAttachShader(_id, vertex_shader);
     glAttachShader(_id, fragment_shader);
+    auto link_phase = StartupPhase{"link shader"};
     glLinkProgram(_id);
-
     assert_status(_id, GL_LINK_STATUS);
 
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 }
 
+Shader::Shader(
+    const std::filesystem::path& compute_path,
+    const ShaderDefines& defines)
+    : _id{glCreateProgram()} {
+    auto phase = StartupPhase{"create shader"};
+    auto compute_shader =
+        compile_shader(compute_path, GL_COMPUTE_SHADER, defines);
+
+    glAttachShader(_id, compute_shader);
+    auto link_phase = StartupPhase{"link shader"};
+    glLinkProgram(_id);
+    assert_status(_id, GL_LINK_STATUS);
+
+    glDeleteShader(compute_shader);
+}
+
 Shader::~Shader() {
     glDeleteProgram(_id);
 }
@@ -105,3 +183,42 @@ void Shader::use() const {
 void Shader::_swap(Shader& a, Shader& b) {
     std::swap(a._id, b._id);
 }
+
+ShaderVariants::ShaderVariants(
+    std::filesystem::path vertex_path,
+    std::filesystem::path fragment_path,
+    Init init)
+    : _vertex_path{std::move(vertex_path)},
+      _fragment_path{std::move(fragment_path)}, _init{std::move(init)} {
+}
+
+ShaderVariants::ShaderVariants(std::filesystem::path compute_path, Init init)
+    : _vertex_path{std::move(compute_path)}, _init{std::move(init)} {
+}
+
+const Shader& ShaderVariants::get(const ShaderDefines& defines) {
+    auto key = _key(defines);
+    auto it = _variants.find(key);
+    if (it == _variants.end()) {
+        auto shader = _fragment_path.empty()
+                          ? Shader{_vertex_path, defines}
+                          : Shader{_vertex_path, _fragment_path, defines};
+        if (_init) {
+            _init(shader, defines);
+        }
+        it = _variants.emplace(std::move(key), std::move(shader)).first;
+    }
+    return it->second;
+}
+
+size_t ShaderVariants::size() const {
+    return _variants.size();
+}
+
+std::string ShaderVariants::_key(const ShaderDefines& defines) {
+    auto key = std::string{};
+    for (const auto& [name, value] : defines) {
+        key += fmt::format("{}={};", name, value);
+    }
+    return key;
+}
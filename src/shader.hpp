@@ -3,12 +3,28 @@
 #include <glad/glad.h>
 
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// A ShaderDefines is a set of preprocessor definitions (name to value) that
+// are injected into shader sources right after the #version directive.
+using ShaderDefines = std::map<std::string, std::string>;
 
 // A shader is a wrapper for opengl shaders
 class Shader {
   public:
     // Create a new shader program from paths to vertex and fragment shaders
-    Shader(const std::filesystem::path&, const std::filesystem::path&);
+    // and an optional set of preprocessor definitions.
+    Shader(
+        const std::filesystem::path&,
+        const std::filesystem::path&,
+        const ShaderDefines& = {});
+
+    // Create a new compute shader program from a path to a compute shader
+    // and an optional set of preprocessor definitions.
+    explicit Shader(const std::filesystem::path&, const ShaderDefines& = {});
 
     // Allow moves but disallow copies.
     Shader(const Shader&) = delete;
@@ -29,3 +45,33 @@ class Shader {
     // Swap the ids of two shaders.
     static void _swap(Shader&, Shader&);
 };
+
+// A ShaderVariants is a cache of shader permutations built on demand from the
+// same sources with different preprocessor definitions.
+class ShaderVariants {
+  public:
+    // A callback run once on every newly built variant (e.g. to set uniforms
+    // that never change).
+    using Init = std::function<void(const Shader&, const ShaderDefines&)>;
+
+    // Create an empty cache for the given vertex and fragment shader paths.
+    ShaderVariants(std::filesystem::path, std::filesystem::path, Init = {});
+
+    // Create an empty cache for the given compute shader path.
+    explicit ShaderVariants(std::filesystem::path, Init = {});
+
+    // Get the variant for a set of definitions, building it on first use.
+    const Shader& get(const ShaderDefines&);
+
+    // Get the number of variants built so far.
+    [[nodiscard]] size_t size() const;
+
+  private:
+    std::filesystem::path _vertex_path; // or compute shader path
+    std::filesystem::path _fragment_path; // empty for compute shaders
+    Init _init;
+    std::unordered_map<std::string, Shader> _variants; // keyed by definitions
+
+    // Get the cache key of a set of definitions.
+    static std::string _key(const ShaderDefines&);
+};
@@ -0,0 +1,187 @@
+#include "startup.hpp"
+
+#include <fmt/format.h>
+#include <sys/resource.h>
+
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+// Use the anonymous namespace for private constants/functions.
+namespace {
+constexpr auto mib = 1024.0 * 1024.0;
+
+// The innermost phase running on this thread.
+thread_local StartupPhase* current_phase = nullptr;
+
+// Get the peak resident memory of the process in bytes.
+uint64_t peak_rss_bytes() {
+    auto usage = rusage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // in KiB on linux
+}
+} // namespace
+
+StartupReport& StartupReport::instance() {
+    static auto report = StartupReport{};
+    return report;
+}
+
+StartupReport::StartupReport() : _start{Clock::now()} {}
+
+void StartupReport::set_output(std::filesystem::path path) {
+    _output = std::move(path);
+}
+
+void StartupReport::add_read(const std::filesystem::path& path) {
+    auto error = std::error_code{};
+    auto bytes = std::filesystem::file_size(path, error);
+    if (!error) {
+        add_read(bytes);
+    }
+}
+
+void StartupReport::add_read(uint64_t bytes) {
+    if (current_phase != nullptr) {
+        current_phase->_bytes_read += bytes;
+    }
+}
+
+void StartupReport::add_uploaded(uint64_t bytes) {
+    if (current_phase != nullptr) {
+        current_phase->_bytes_uploaded += bytes;
+    }
+}
+
+void StartupReport::finish() {
+    {
+        auto lock = std::lock_guard{_mutex};
+        if (_total_ms) {
+            return;
+        }
+        _total_ms = std::chrono::duration<double, std::milli>(
+                        Clock::now() - _start)
+                        .count();
+    }
+    if (_output) {
+        print();
+        if (write_json(*_output)) {
+            fmt::print("wrote the startup report to {}\n", _output->string());
+        } else {
+            fmt::print(stderr, "could not write {}\n", _output->string());
+        }
+    }
+}
+
+bool StartupReport::finished() const {
+    auto lock = std::lock_guard{_mutex};
+    return _total_ms.has_value();
+}
+
+std::vector<StartupReport::Phase> StartupReport::phases() const {
+    auto lock = std::lock_guard{_mutex};
+    return _phases;
+}
+
+void StartupReport::print() const {
+    auto lock = std::lock_guard{_mutex};
+    fmt::print(
+        "{:<40} {:>5} {:>10} {:>9} {:>9} {:>9}\n",
+        "startup phase",
+        "count",
+        "ms",
+        "read MiB",
+        "gpu MiB",
+        "peak MiB");
+    for (const auto& phase : _phases) {
+        fmt::print(
+            "{:<40} {:>5} {:>10.2f} {:>9.2f} {:>9.2f} {:>9.1f}\n",
+            std::string(static_cast<size_t>(phase.depth) * 2, ' ') +
+                phase.name,
+            phase.count,
+            phase.ms,
+            static_cast<double>(phase.bytes_read) / mib,
+            static_cast<double>(phase.bytes_uploaded) / mib,
+            static_cast<double>(phase.peak_rss_bytes) / mib);
+    }
+    fmt::print(
+        "time to first frame: {:.2f} ms, peak memory {:.1f} MiB\n",
+        _total_ms.value_or(0.0),
+        static_cast<double>(peak_rss_bytes()) / mib);
+}
+
+bool StartupReport::write_json(const std::filesystem::path& path) const {
+    auto lock = std::lock_guard{_mutex};
+    auto file = std::ofstream{path};
+    file << fmt::format(
+        "{{\n  \"time_to_first_frame_ms\": {:.3f},\n"
+        "  \"peak_rss_bytes\": {},\n  \"phases\": [",
+        _total_ms.value_or(0.0),
+        peak_rss_bytes());
+    for (auto i = size_t{0}; i < _phases.size(); i++) {
+        const auto& phase = _phases[i];
+        file << fmt::format(
+            "{}\n    {{\"path\": \"{}\", \"name\": \"{}\", \"depth\": {}, "
+            "\"count\": {}, \"ms\": {:.3f}, \"bytes_read\": {}, "
+            "\"bytes_uploaded\": {}, \"peak_rss_bytes\": {}}}",
+            i == 0 ? "" : ",",
+            phase.path,
+            phase.name,
+            phase.depth,
+            phase.count,
+            phase.ms,
+            phase.bytes_read,
+            phase.bytes_uploaded,
+            phase.peak_rss_bytes);
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
+
+StartupPhase::StartupPhase(const char* name)
+    : _scope{name}, _parent{current_phase},
+      _begin{StartupReport::Clock::now()} {
+    current_phase = this;
+    auto& report = StartupReport::instance();
+    auto lock = std::lock_guard{report._mutex};
+    if (report._total_ms) {
+        return;
+    }
+
+    // Phases at the same place in the nesting share their totals.
+    auto depth = 0;
+    auto path = std::string{name};
+    if (_parent != nullptr && _parent->_index) {
+        const auto& parent = report._phases[*_parent->_index];
+        depth = parent.depth + 1;
+        path = parent.path + "/" + path;
+    }
+    auto [index, added] = report._indices.emplace(path, report._phases.size());
+    if (added) {
+        report._phases.emplace_back(
+            StartupReport::Phase{path, name, depth, 0, 0.0, 0, 0, 0});
+    }
+    _index = index->second;
+}
+
+StartupPhase::~StartupPhase() {
+    current_phase = _parent;
+    if (_parent != nullptr) {
+        _parent->_bytes_read += _bytes_read;
+        _parent->_bytes_uploaded += _bytes_uploaded;
+    }
+    if (!_index) {
+        return;
+    }
+    auto ms = std::chrono::duration<double, std::milli>(
+                  StartupReport::Clock::now() - _begin)
+                  .count();
+    auto& report = StartupReport::instance();
+    auto lock = std::lock_guard{report._mutex};
+    auto& phase = report._phases[*_index];
+    phase.count++;
+    phase.ms += ms;
+    phase.bytes_read += _bytes_read;
+    phase.bytes_uploaded += _bytes_uploaded;
+    phase.peak_rss_bytes = peak_rss_bytes();
+}
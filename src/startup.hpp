@@ -0,0 +1,109 @@
+#pragma once
+
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A StartupReport breaks the time to the first frame down into nested
+// phases, with the bytes each phase read from files and uploaded to the gpu,
+// and the peak memory use of the process by its end.
+class StartupReport {
+  public:
+    // A Phase is the totals of every run of a phase at one place in the
+    // nesting of phases.
+    struct Phase {
+        std::string path; // names of the enclosing phases and this one
+        std::string name;
+        int depth; // number of enclosing phases
+        int count; // number of runs
+        double ms; // wall time
+        uint64_t bytes_read;
+        uint64_t bytes_uploaded;
+        uint64_t peak_rss_bytes; // peak resident memory by the last run's end
+    };
+
+    // Get the report shared by all threads.
+    static StartupReport& instance();
+
+    // Disallow copies and moves.
+    StartupReport(const StartupReport&) = delete;
+    StartupReport(StartupReport&&) = delete;
+    StartupReport& operator=(const StartupReport&) = delete;
+    StartupReport& operator=(StartupReport&&) = delete;
+    ~StartupReport() = default;
+
+    // Print the report and write it as json to a file when startup
+    // finishes.
+    void set_output(std::filesystem::path);
+
+    // Count bytes read from a file, or from memory, in the innermost phase
+    // running on the calling thread.
+    void add_read(const std::filesystem::path&);
+    void add_read(uint64_t bytes);
+
+    // Count bytes uploaded to the gpu in the innermost phase running on the
+    // calling thread.
+    void add_uploaded(uint64_t bytes);
+
+    // Stop recording phases at the first frame, and output the report.
+    void finish();
+    [[nodiscard]] bool finished() const;
+
+    // Get the phases in the order they first started.
+    [[nodiscard]] std::vector<Phase> phases() const;
+
+    // Print the phases as a table.
+    void print() const;
+
+    // Write the phases as json, and get whether it succeeded.
+    bool write_json(const std::filesystem::path&) const;
+
+  private:
+    friend class StartupPhase;
+    using Clock = std::chrono::steady_clock;
+
+    StartupReport();
+
+    Clock::time_point _start; // when the report was created
+    std::optional<double> _total_ms; // time to the first frame
+    std::optional<std::filesystem::path> _output;
+    mutable std::mutex _mutex; // guards the phases
+    std::vector<Phase> _phases;
+    std::map<std::string, size_t> _indices; // of the phases by path
+};
+
+// A StartupPhase records the time from its creation to its destruction as a
+// phase of the startup report, nested in the phase that encloses it on the
+// same thread. It does nothing once startup has finished, besides being a
+// profiler scope.
+class StartupPhase {
+  public:
+    // Start a phase. The name must outlive the profiler (e.g. a string
+    // literal).
+    explicit StartupPhase(const char* name);
+
+    // Disallow copies and moves.
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase(StartupPhase&&) = delete;
+    StartupPhase& operator=(const StartupPhase&) = delete;
+    StartupPhase& operator=(StartupPhase&&) = delete;
+    ~StartupPhase();
+
+  private:
+    friend class StartupReport;
+
+    ProfileScope _scope;
+    std::optional<size_t> _index; // in the report, if recording
+    StartupPhase* _parent; // enclosing phase on this thread
+    StartupReport::Clock::time_point _begin;
+    uint64_t _bytes_read = 0; // including enclosed phases
+    uint64_t _bytes_uploaded = 0; // including enclosed phases
+};
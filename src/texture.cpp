@@ -1,8 +1,10 @@
 #include "texture.hpp"
+#include "startup.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <exception>
+#include <optional>
 #include <utility>
 
 // Use the anonymouse namespace for private constants/functions.
@@ -40,9 +42,31 @@ GLenum gl_sized_format(const TextureData::Format& format) {
         std::terminate();
     }
 }
+
+// Get the number of bytes in a pixel of a TextureData::Format.
+uint64_t pixel_bytes(const TextureData::Format& format) {
+    switch (format) {
+    case TextureData::Format::Greyscale:
+        return 1;
+    case TextureData::Format::GreyAlpha:
+        return 2;
+    case TextureData::Format::Rgb:
+        return 3;
+    case TextureData::Format::Rgba:
+        return 4;
+    default:
+        std::terminate();
+    }
+}
 } // namespace
 
 Texture::Texture(const TextureData& tex_data) : _tex_id{0} {
+    auto phase = std::optional<StartupPhase>{};
+    phase.emplace("upload texture");
+    StartupReport::instance().add_uploaded(
+        static_cast<uint64_t>(tex_data.width) *
+        static_cast<uint64_t>(tex_data.height) *
+        pixel_bytes(tex_data.format));
     glCreateTextures(GL_TEXTURE_2D, 1, &_tex_id);
     glTextureParameteri(_tex_id, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTextureParameteri(_tex_id, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -70,6 +94,7 @@ Texture::Texture(const TextureData& tex_data) : _tex_id{0} {
         gl_base_format(tex_data.format),
         GL_UNSIGNED_BYTE,
         tex_data.data);
+    phase.emplace("generate mipmaps");
     glGenerateTextureMipmap(_tex_id);
 }
 
@@ -0,0 +1,66 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    for (auto i = size_t{1}; i < threads; i++) {
+        _workers.emplace_back([this] { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        auto lock = std::lock_guard{_mutex};
+        _stop = true;
+    }
+    _start.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return _workers.size() + 1;
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    auto lock = std::unique_lock{_mutex};
+    _task = &task;
+    _count = count;
+    _next = 0;
+    _busy = _workers.size();
+    _batch++;
+    _start.notify_all();
+
+    drain(lock);
+    _done.wait(lock, [this] { return _busy == 0; });
+    _task = nullptr;
+}
+
+void ThreadPool::drain(std::unique_lock<std::mutex>& lock) {
+    while (_next < _count) {
+        auto index = _next++;
+        lock.unlock();
+        (*_task)(index);
+        lock.lock();
+    }
+}
+
+void ThreadPool::work() {
+    auto lock = std::unique_lock{_mutex};
+    auto batch = size_t{0};
+    while (true) {
+        _start.wait(lock, [this, batch] { return _stop || _batch != batch; });
+        if (_stop) {
+            return;
+        }
+        batch = _batch;
+        drain(lock);
+        if (--_busy == 0) {
+            _done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A ThreadPool runs batches of independent tasks on a fixed set of worker
+// threads. The calling thread takes part in every batch.
+class ThreadPool {
+  public:
+    // Start a pool with the given total number of threads, including the
+    // calling thread (0 for one per hardware thread).
+    explicit ThreadPool(size_t threads = 0);
+
+    // Disallow copies and moves.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    ~ThreadPool();
+
+    // Get the total number of threads, including the calling thread.
+    [[nodiscard]] size_t size() const;
+
+    // Run a task for every index in [0, count) and wait for all of them.
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+  private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _start; // signals a new batch or shutdown
+    std::condition_variable _done; // signals that a worker left a batch
+    const std::function<void(size_t)>* _task = nullptr; // task of the batch
+    size_t _count = 0; // number of tasks in the batch
+    size_t _next = 0; // next task to claim
+    size_t _busy = 0; // workers still inside the batch
+    size_t _batch = 0; // number of batches started
+    bool _stop = false;
+
+    // Claim and run tasks of the current batch until none are left. Called
+    // with the lock held, and returns with it held.
+    void drain(std::unique_lock<std::mutex>&);
+
+    // Wait for batches and help run them until shutdown.
+    void work();
+};
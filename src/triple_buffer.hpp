@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// A TripleBuffer hands values from one producer thread to one consumer thread
+// without locks. The producer fills the back slot and publishes it, and the
+// consumer takes the most recently published slot. Neither side ever waits
+// for the other, and values published in between are skipped.
+template <typename T> class TripleBuffer {
+  public:
+    // Get the slot that the producer fills before publishing.
+    T& back() {
+        return _slots[_back].value;
+    }
+
+    // Publish the back slot as the latest value (producer only).
+    void publish() {
+        auto previous = _middle.exchange(
+            static_cast<uint8_t>(_back | fresh_bit),
+            std::memory_order_acq_rel);
+        _back = static_cast<uint8_t>(previous & index_mask);
+    }
+
+    // Take the latest published value if there is a new one, and return
+    // whether there was (consumer only).
+    bool update() {
+        if ((_middle.load(std::memory_order_relaxed) & fresh_bit) == 0) {
+            return false;
+        }
+        auto previous = _middle.exchange(_front, std::memory_order_acq_rel);
+        _front = static_cast<uint8_t>(previous & index_mask);
+        return true;
+    }
+
+    // Get the value last taken by the consumer.
+    const T& front() const {
+        return _slots[_front].value;
+    }
+
+  private:
+    static constexpr auto index_mask = uint8_t{0b011};
+    static constexpr auto fresh_bit = uint8_t{0b100};
+
+    // A Slot keeps each value on its own cache line.
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    std::array<Slot, 3> _slots{};
+    uint8_t _back = 0; // slot owned by the producer
+    std::atomic<uint8_t> _middle = 1; // last published slot and fresh flag
+    uint8_t _front = 2; // slot owned by the consumer
+};
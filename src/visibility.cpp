@@ -0,0 +1,122 @@
+#include "visibility.hpp"
+
+#include "bindless.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+// A DrawRecord locates a mesh in the merged buffers. The layout matches the
+// std430 Draw struct in shaders/visibility/resolve-frag.glsl.
+struct DrawRecord {
+    uint32_t first_triangle; // id of the first triangle, less one
+    uint32_t base_vertex; // index of the first vertex
+    GLuint64 diffuse; // texture handles, 0 for none
+    GLuint64 normal;
+    GLuint64 specular;
+};
+static_assert(sizeof(DrawRecord) == 32);
+
+// Create an immutable buffer of the given size.
+GLuint create_buffer(GLsizeiptr size, const void* data = nullptr) {
+    auto buffer = GLuint{};
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, data, 0);
+    return buffer;
+}
+} // namespace
+
+VisibilityGeometry::VisibilityGeometry(std::span<const Mesh> meshes)
+    : _vertices{0}, _indices{0}, _draws{0} {
+    auto vertex_count = GLsizeiptr{};
+    auto triangle_count = GLsizeiptr{};
+    for (const auto& mesh : meshes) {
+        vertex_count += mesh.vertex_count();
+        triangle_count += mesh.triangle_count();
+    }
+    constexpr auto triangle_size = GLsizeiptr{3 * sizeof(GLuint)};
+    _vertices = create_buffer(vertex_count * GLsizeiptr{sizeof(Vertex)});
+    _indices = create_buffer(triangle_count * triangle_size);
+
+    // Textures shared by several meshes must only be made resident once.
+    auto handles = std::unordered_map<const Texture*, GLuint64>{};
+    auto handle = [&](const Texture* texture) {
+        if (texture == nullptr) {
+            return GLuint64{0};
+        }
+        auto [it, inserted] = handles.try_emplace(texture);
+        if (inserted) {
+            it->second = resident_texture_handle(texture->id());
+            _handles.emplace_back(it->second);
+        }
+        return it->second;
+    };
+
+    auto draws = std::vector<DrawRecord>{};
+    draws.reserve(meshes.size());
+    auto vertex_offset = GLsizeiptr{};
+    auto triangle_offset = GLsizeiptr{};
+    for (const auto& mesh : meshes) {
+        auto vertex_bytes = mesh.vertex_count() * GLsizeiptr{sizeof(Vertex)};
+        auto index_bytes = mesh.triangle_count() * triangle_size;
+        glCopyNamedBufferSubData(
+            mesh.vertex_buffer(),
+            _vertices,
+            0,
+            vertex_offset * GLsizeiptr{sizeof(Vertex)},
+            vertex_bytes);
+        glCopyNamedBufferSubData(
+            mesh.index_buffer(),
+            _indices,
+            0,
+            triangle_offset * triangle_size,
+            index_bytes);
+
+        const auto& texture = mesh.texture();
+        draws.emplace_back(DrawRecord{
+            static_cast<uint32_t>(triangle_offset),
+            static_cast<uint32_t>(vertex_offset),
+            handle(texture.diffuse),
+            handle(texture.normal),
+            handle(texture.specular)});
+        vertex_offset += mesh.vertex_count();
+        triangle_offset += mesh.triangle_count();
+    }
+    _draws = create_buffer(
+        static_cast<GLsizeiptr>(draws.size() * sizeof(DrawRecord)),
+        draws.data());
+}
+
+VisibilityGeometry::VisibilityGeometry(VisibilityGeometry&& v) noexcept
+    : _vertices{0}, _indices{0}, _draws{0} {
+    VisibilityGeometry::_swap(*this, v);
+}
+
+VisibilityGeometry& VisibilityGeometry::operator=(
+    VisibilityGeometry&& v) noexcept {
+    VisibilityGeometry::_swap(*this, v);
+    return *this;
+}
+
+VisibilityGeometry::~VisibilityGeometry() {
+    for (auto handle : _handles) {
+        release_texture_handle(handle);
+    }
+    glDeleteBuffers(1, &_draws);
+    glDeleteBuffers(1, &_indices);
+    glDeleteBuffers(1, &_vertices);
+}
+
+void VisibilityGeometry::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _vertices);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _indices);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _draws);
+}
+
+void VisibilityGeometry::_swap(VisibilityGeometry& a, VisibilityGeometry& b) {
+    std::swap(a._vertices, b._vertices);
+    std::swap(a._indices, b._indices);
+    std::swap(a._draws, b._draws);
+    std::swap(a._handles, b._handles);
+}
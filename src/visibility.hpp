@@ -0,0 +1,38 @@
+#pragma once
+
+#include "mesh.hpp"
+
+#include <glad/glad.h>
+
+#include <span>
+#include <vector>
+
+// A VisibilityGeometry merges the vertices, indices, and materials of a list
+// of meshes into shader storage buffers, so that a resolve pass can look up
+// any triangle by its id in a visibility buffer. Triangle ids count up from
+// the first mesh, in order. Textures are referenced by bindless handles.
+class VisibilityGeometry {
+  public:
+    // Merge the given meshes. Requires load_bindless_textures().
+    VisibilityGeometry(std::span<const Mesh>);
+
+    // Allow moves but disallow copies.
+    VisibilityGeometry(const VisibilityGeometry&) = delete;
+    VisibilityGeometry(VisibilityGeometry&&) noexcept;
+    VisibilityGeometry& operator=(const VisibilityGeometry&) = delete;
+    VisibilityGeometry& operator=(VisibilityGeometry&&) noexcept;
+    ~VisibilityGeometry();
+
+    // Bind the vertex, index, and draw buffers to shader storage bindings
+    // 0-2, matching shaders/visibility/resolve-frag.glsl.
+    void bind() const;
+
+  private:
+    GLuint _vertices; // buffer id of all vertices
+    GLuint _indices; // buffer id of all triangles, relative to their mesh
+    GLuint _draws; // buffer id of the per-mesh draw records
+    std::vector<GLuint64> _handles; // resident texture handles
+
+    // Swap the contents of two VisibilityGeometries.
+    static void _swap(VisibilityGeometry&, VisibilityGeometry&);
+};